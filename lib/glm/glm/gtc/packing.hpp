@@ -573,6 +573,70 @@ namespace glm
 	/// @see gtc_packing
 	/// @see uint8 packUnorm2x3_1x2(vec3 const & v)
 	GLM_FUNC_DECL vec3 unpackUnorm2x3_1x2(uint8 p);
+
+	/// Converts Count contiguous floats with packUnorm1x8.
+	/// The results are bit identical to the scalar function. SSE2 processes 16 values per iteration.
+	/// Packing the components of N vec4 this way gives the bytes of N packUnorm4x8 results.
+	///
+	/// @see gtc_packing
+	/// @see uint8 packUnorm1x8(float v)
+	GLM_FUNC_DECL void packUnorm1x8(float const * Src, uint8 * Dst, std::size_t Count);
+
+	/// Converts Count contiguous values with unpackUnorm1x8, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see float unpackUnorm1x8(uint8 p)
+	GLM_FUNC_DECL void unpackUnorm1x8(uint8 const * Src, float * Dst, std::size_t Count);
+
+	/// Converts Count contiguous floats with packSnorm1x8, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see uint8 packSnorm1x8(float s)
+	GLM_FUNC_DECL void packSnorm1x8(float const * Src, uint8 * Dst, std::size_t Count);
+
+	/// Converts Count contiguous values with unpackSnorm1x8, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see float unpackSnorm1x8(uint8 p)
+	GLM_FUNC_DECL void unpackSnorm1x8(uint8 const * Src, float * Dst, std::size_t Count);
+
+	/// Converts Count contiguous floats with packUnorm1x16, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see uint16 packUnorm1x16(float v)
+	GLM_FUNC_DECL void packUnorm1x16(float const * Src, uint16 * Dst, std::size_t Count);
+
+	/// Converts Count contiguous values with unpackUnorm1x16, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see float unpackUnorm1x16(uint16 p)
+	GLM_FUNC_DECL void unpackUnorm1x16(uint16 const * Src, float * Dst, std::size_t Count);
+
+	/// Converts Count contiguous floats with packSnorm1x16, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see uint16 packSnorm1x16(float v)
+	GLM_FUNC_DECL void packSnorm1x16(float const * Src, uint16 * Dst, std::size_t Count);
+
+	/// Converts Count contiguous values with unpackSnorm1x16, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see float unpackSnorm1x16(uint16 p)
+	GLM_FUNC_DECL void unpackSnorm1x16(uint16 const * Src, float * Dst, std::size_t Count);
+
+	/// Converts Count contiguous floats with packHalf1x16.
+	/// The results are bit identical to the scalar function, which rounds ties away from zero; F16C
+	/// rounds them to even, so the SSE2 and AVX2 paths use integer arithmetic instead.
+	///
+	/// @see gtc_packing
+	/// @see uint16 packHalf1x16(float v)
+	GLM_FUNC_DECL void packHalf1x16(float const * Src, uint16 * Dst, std::size_t Count);
+
+	/// Converts Count contiguous half floats with unpackHalf1x16, bit identical to the scalar function.
+	///
+	/// @see gtc_packing
+	/// @see float unpackHalf1x16(uint16 v)
+	GLM_FUNC_DECL void unpackHalf1x16(uint16 const * Src, float * Dst, std::size_t Count);
 	/// @}
 }// namespace glm
 
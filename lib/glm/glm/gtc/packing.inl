@@ -6,6 +6,7 @@
 #include "../vec3.hpp"
 #include "../vec4.hpp"
 #include "../detail/type_half.hpp"
+#include "../simd/packing.h"
 #include <cstring>
 #include <limits>
 
@@ -777,5 +778,194 @@ namespace detail
 		Unpack.pack = v;
 		return vec3(Unpack.data.x, Unpack.data.y, Unpack.data.z) * ScaleFactor;
 	}
-}//namespace glm
 
+	GLM_FUNC_QUALIFIER void packUnorm1x8(float const * Src, uint8 * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(255.0f);
+			for(; i + 16 <= Count; i += 16)
+			{
+				glm_ivec4 v[4];
+				for(int j = 0; j < 4; ++j)
+					v[j] = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + j * 4), 0.0f, 1.0f), Scale));
+				glm_ivec4 const Packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), Packed);
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = packUnorm1x8(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void unpackUnorm1x8(uint8 const * Src, float * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(static_cast<float>(0.0039215686274509803921568627451)); // 1 / 255
+			glm_ivec4 const Zero = _mm_setzero_si128();
+			for(; i + 16 <= Count; i += 16)
+			{
+				glm_ivec4 const Bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				glm_ivec4 const Lo = _mm_unpacklo_epi8(Bytes, Zero);
+				glm_ivec4 const Hi = _mm_unpackhi_epi8(Bytes, Zero);
+				_mm_storeu_ps(Dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Lo, Zero)), Scale));
+				_mm_storeu_ps(Dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Lo, Zero)), Scale));
+				_mm_storeu_ps(Dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Hi, Zero)), Scale));
+				_mm_storeu_ps(Dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Hi, Zero)), Scale));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = unpackUnorm1x8(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void packSnorm1x8(float const * Src, uint8 * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(127.0f);
+			for(; i + 16 <= Count; i += 16)
+			{
+				glm_ivec4 v[4];
+				for(int j = 0; j < 4; ++j)
+					v[j] = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + j * 4), -1.0f, 1.0f), Scale));
+				glm_ivec4 const Packed = _mm_packs_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), Packed);
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = packSnorm1x8(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void unpackSnorm1x8(uint8 const * Src, float * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(0.00787401574803149606299212598425f); // 1.0f / 127.0f
+			for(; i + 16 <= Count; i += 16)
+			{
+				// Sign extension: the byte goes to the top of a wider lane, then an arithmetic shift brings it back
+				glm_ivec4 const Bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				glm_ivec4 const Lo = _mm_unpacklo_epi8(Bytes, Bytes);
+				glm_ivec4 const Hi = _mm_unpackhi_epi8(Bytes, Bytes);
+				glm_ivec4 const v[4] = {
+					_mm_srai_epi32(_mm_unpacklo_epi16(Lo, Lo), 24), _mm_srai_epi32(_mm_unpackhi_epi16(Lo, Lo), 24),
+					_mm_srai_epi32(_mm_unpacklo_epi16(Hi, Hi), 24), _mm_srai_epi32(_mm_unpackhi_epi16(Hi, Hi), 24)};
+				for(int j = 0; j < 4; ++j)
+					_mm_storeu_ps(Dst + i + j * 4, glm_vec4_clamp(_mm_mul_ps(_mm_cvtepi32_ps(v[j]), Scale), -1.0f, 1.0f));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = unpackSnorm1x8(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void packUnorm1x16(float const * Src, uint16 * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(65535.0f);
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_ivec4 const v0 = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + 0), 0.0f, 1.0f), Scale));
+				glm_ivec4 const v1 = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + 4), 0.0f, 1.0f), Scale));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), glm_uvec4_pack_u16(v0, v1));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = packUnorm1x16(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void unpackUnorm1x16(uint16 const * Src, float * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(1.5259021896696421759365224689097e-5f); // 1.0 / 65535.0
+			glm_ivec4 const Zero = _mm_setzero_si128();
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_ivec4 const Words = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				_mm_storeu_ps(Dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Words, Zero)), Scale));
+				_mm_storeu_ps(Dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Words, Zero)), Scale));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = unpackUnorm1x16(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void packSnorm1x16(float const * Src, uint16 * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(32767.0f);
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_ivec4 const v0 = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + 0), -1.0f, 1.0f), Scale));
+				glm_ivec4 const v1 = glm_vec4_round_away_to_ivec4(_mm_mul_ps(glm_vec4_clamp(_mm_loadu_ps(Src + i + 4), -1.0f, 1.0f), Scale));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), _mm_packs_epi32(v0, v1));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = packSnorm1x16(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void unpackSnorm1x16(uint16 const * Src, float * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_vec4 const Scale = _mm_set1_ps(3.0518509475997192297128208258309e-5f); //1.0f / 32767.0f
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_ivec4 const Words = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				glm_ivec4 const v0 = _mm_srai_epi32(_mm_unpacklo_epi16(Words, Words), 16);
+				glm_ivec4 const v1 = _mm_srai_epi32(_mm_unpackhi_epi16(Words, Words), 16);
+				_mm_storeu_ps(Dst + i + 0, glm_vec4_clamp(_mm_mul_ps(_mm_cvtepi32_ps(v0), Scale), -1.0f, 1.0f));
+				_mm_storeu_ps(Dst + i + 4, glm_vec4_clamp(_mm_mul_ps(_mm_cvtepi32_ps(v1), Scale), -1.0f, 1.0f));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = unpackSnorm1x16(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void packHalf1x16(float const * Src, uint16 * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_AVX2_BIT
+			for(; i + 8 <= Count; i += 8)
+			{
+				__m256i const Half = glm_vec8_to_half(_mm256_loadu_ps(Src + i));
+				__m128i const Packed = _mm_packus_epi32(_mm256_castsi256_si128(Half), _mm256_extracti128_si256(Half, 1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), Packed);
+			}
+#		elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_uvec4 const h0 = glm_vec4_to_half(_mm_loadu_ps(Src + i + 0));
+				glm_uvec4 const h1 = glm_vec4_to_half(_mm_loadu_ps(Src + i + 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), glm_uvec4_pack_u16(h0, h1));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = packHalf1x16(Src[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void unpackHalf1x16(uint16 const * Src, float * Dst, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		if GLM_ARCH & GLM_ARCH_AVX2_BIT
+			for(; i + 8 <= Count; i += 8)
+			{
+				__m128i const Words = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				_mm256_storeu_ps(Dst + i, glm_half_to_vec8(_mm256_cvtepu16_epi32(Words)));
+			}
+#		elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_ivec4 const Zero = _mm_setzero_si128();
+			for(; i + 8 <= Count; i += 8)
+			{
+				glm_ivec4 const Words = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Src + i));
+				_mm_storeu_ps(Dst + i + 0, glm_half_to_vec4(_mm_unpacklo_epi16(Words, Zero)));
+				_mm_storeu_ps(Dst + i + 4, glm_half_to_vec4(_mm_unpackhi_epi16(Words, Zero)));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Dst[i] = unpackHalf1x16(Src[i]);
+	}
+}//namespace glm
@@ -0,0 +1,95 @@
+/// @ref gtx_cpu_dispatch
+/// @file glm/gtx/cpu_dispatch.hpp
+///
+/// @see core (dependence)
+/// @see gtx_soa (dependence)
+///
+/// @defgroup gtx_cpu_dispatch GLM_GTX_cpu_dispatch
+/// @ingroup gtx
+///
+/// @brief Hot kernels with a code path selected at runtime from the CPU features.
+/// The rest of GLM selects its SIMD code at compile time through GLM_ARCH, so a binary built for SSE2
+/// never uses AVX2. The dispatch functions detect the CPU with cpuid on their first call and use the
+/// fastest path both the build and the CPU support, through a table of function pointers.
+///
+/// The SIMD paths need an SSE2 build with GCC, Clang or Visual C++; otherwise, or with GLM_FORCE_PURE,
+/// only dispatch_pure is available.
+///
+/// <glm/gtx/cpu_dispatch.hpp> need to be included to use these functionalities.
+
+#pragma once
+
+// Dependency:
+#include "../glm.hpp"
+#include "../gtx/soa.hpp"
+
+#if GLM_MESSAGES == GLM_MESSAGES_ENABLED && !defined(GLM_EXT_INCLUDED)
+#	pragma message("GLM: GLM_GTX_cpu_dispatch extension included")
+#endif
+
+namespace glm
+{
+	/// @addtogroup gtx_cpu_dispatch
+	/// @{
+
+	/// Code paths of the dispatched functions
+	/// @see gtx_cpu_dispatch
+	enum dispatch_path
+	{
+		dispatch_pure,
+		dispatch_sse2,
+		dispatch_avx2
+	};
+
+	/// Instruction sets of the running CPU as a GLM_ARCH value.
+	/// AVX2 is only reported together with FMA. Returns GLM_ARCH when runtime detection is not available.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL int cpuArch();
+
+	/// Whether Path is compiled in and can run on this CPU. dispatch_pure is always supported.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL bool isDispatchPathSupported(dispatch_path Path);
+
+	/// Path used by the dispatch functions: the fastest supported one unless setDispatchPath was called.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL dispatch_path getDispatchPath();
+
+	/// Force a path, for tests and benchmarks. Returns false and keeps the current path if Path is not supported.
+	/// Not thread safe: no dispatch function may run concurrently.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL bool setDispatchPath(dispatch_path Path);
+
+	/// m1 * m2
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL mat4 dispatchMul(mat4 const & m1, mat4 const & m2);
+
+	/// inverse(m)
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL mat4 dispatchInverse(mat4 const & m);
+
+	/// Result[i] = m1[i] * m2[i]. Result may be one of the inputs.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL void dispatchMul(mat4 const * m1, mat4 const * m2, mat4 * Result, std::size_t Count);
+
+	/// Result[i] = inverse(m[i]). Result may be the input.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL void dispatchInverse(mat4 const * m, mat4 * Result, std::size_t Count);
+
+	/// determinant(m)
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL float dispatchDeterminant(mat4 const & m);
+
+	/// transformPoint(m, v, Result, Count) of gtx_soa.
+	/// Every path computes the same operations in the same order, up to FMA contraction of the compiler.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL void dispatchTransformPoint(mat4 const & m, soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count);
+
+	/// transform(m, v, Result, Count) of gtx_soa.
+	/// Every path computes the same operations in the same order, up to FMA contraction of the compiler.
+	/// @see gtx_cpu_dispatch
+	GLM_FUNC_DECL void dispatchTransform(mat4 const & m, soa_vec3 const & v, soa_vec4 const & Result, std::size_t Count);
+
+	/// @}
+}//namespace glm
+
+#include "cpu_dispatch.inl"
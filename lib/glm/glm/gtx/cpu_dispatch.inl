@@ -0,0 +1,353 @@
+/// @ref gtx_cpu_dispatch
+/// @file glm/gtx/cpu_dispatch.inl
+
+#include "../simd/cpuid.h"
+#include "../simd/matrix.h"
+
+namespace glm{
+namespace detail
+{
+	struct dispatch_table
+	{
+		dispatch_path Path;
+		void (*Mul)(mat4 const & m1, mat4 const & m2, mat4 & Result);
+		void (*Inverse)(mat4 const & m, mat4 & Result);
+		float (*Determinant)(mat4 const & m);
+		void (*MulBatch)(mat4 const * m1, mat4 const * m2, mat4 * Result, std::size_t Count);
+		void (*InverseBatch)(mat4 const * m, mat4 * Result, std::size_t Count);
+		// Rows is 3 for points and 4 for homogeneous coordinates
+		void (*Transform)(mat4 const & m, float const * const In[3], float * const Out[4], length_t Rows, std::size_t Count);
+	};
+
+	// Scalar code of the core functions, whatever the SIMD specializations the build enables for mat4
+	template <precision P>
+	GLM_FUNC_QUALIFIER void dispatch_mul_pure(tmat4x4<float, P> const & m1, tmat4x4<float, P> const & m2, tmat4x4<float, P> & Result)
+	{
+		Result = m1 * m2;
+	}
+
+	template <precision P>
+	GLM_FUNC_QUALIFIER void dispatch_inverse_pure(tmat4x4<float, P> const & m, tmat4x4<float, P> & Result)
+	{
+		Result = compute_inverse<tmat4x4, float, P, false>::call(m);
+	}
+
+	template <precision P>
+	GLM_FUNC_QUALIFIER float dispatch_determinant_pure(tmat4x4<float, P> const & m)
+	{
+		return compute_determinant<tmat4x4, float, P, false>::call(m);
+	}
+
+	template <precision P>
+	GLM_FUNC_QUALIFIER void dispatch_mul_batch_pure(tmat4x4<float, P> const * m1, tmat4x4<float, P> const * m2, tmat4x4<float, P> * Result, std::size_t Count)
+	{
+		for(std::size_t i = 0; i < Count; ++i)
+			dispatch_mul_pure(m1[i], m2[i], Result[i]);
+	}
+
+	template <precision P>
+	GLM_FUNC_QUALIFIER void dispatch_inverse_batch_pure(tmat4x4<float, P> const * m, tmat4x4<float, P> * Result, std::size_t Count)
+	{
+		for(std::size_t i = 0; i < Count; ++i)
+			dispatch_inverse_pure(m[i], Result[i]);
+	}
+
+	// Same operations as mat4 * vec4: (c0 * x + c1 * y) + (c2 * z + c3 * 1)
+	GLM_FUNC_QUALIFIER void dispatch_transform_pure_range(mat4 const & m, float const * const In[3], float * const Out[4], length_t Rows, std::size_t First, std::size_t Count)
+	{
+		for(std::size_t i = First; i < Count; ++i)
+		{
+			vec4 const Value = m * vec4(In[0][i], In[1][i], In[2][i], 1.0f);
+			for(length_t Row = 0; Row < Rows; ++Row)
+				Out[Row][i] = Value[Row];
+		}
+	}
+
+	GLM_FUNC_QUALIFIER void dispatch_transform_pure(mat4 const & m, float const * const In[3], float * const Out[4], length_t Rows, std::size_t Count)
+	{
+		dispatch_transform_pure_range(m, In, Out, Rows, 0, Count);
+	}
+
+#	ifdef GLM_TARGET_AVX2
+		GLM_FUNC_QUALIFIER void dispatch_mul_sse2(mat4 const & m1, mat4 const & m2, mat4 & Result)
+		{
+			glm_vec4 const a[4] = {_mm_loadu_ps(&m1[0][0]), _mm_loadu_ps(&m1[1][0]), _mm_loadu_ps(&m1[2][0]), _mm_loadu_ps(&m1[3][0])};
+			glm_vec4 const b[4] = {_mm_loadu_ps(&m2[0][0]), _mm_loadu_ps(&m2[1][0]), _mm_loadu_ps(&m2[2][0]), _mm_loadu_ps(&m2[3][0])};
+			glm_vec4 r[4];
+			glm_mat4_mul(a, b, r);
+			for(length_t i = 0; i < 4; ++i)
+				_mm_storeu_ps(&Result[i][0], r[i]);
+		}
+
+		GLM_FUNC_QUALIFIER void dispatch_inverse_sse2(mat4 const & m, mat4 & Result)
+		{
+			glm_vec4 const a[4] = {_mm_loadu_ps(&m[0][0]), _mm_loadu_ps(&m[1][0]), _mm_loadu_ps(&m[2][0]), _mm_loadu_ps(&m[3][0])};
+			glm_vec4 r[4];
+			glm_mat4_inverse(a, r);
+			for(length_t i = 0; i < 4; ++i)
+				_mm_storeu_ps(&Result[i][0], r[i]);
+		}
+
+		GLM_FUNC_QUALIFIER void dispatch_mul_batch_sse2(mat4 const * m1, mat4 const * m2, mat4 * Result, std::size_t Count)
+		{
+			for(std::size_t i = 0; i < Count; ++i)
+				dispatch_mul_sse2(m1[i], m2[i], Result[i]);
+		}
+
+		GLM_FUNC_QUALIFIER void dispatch_inverse_batch_sse2(mat4 const * m, mat4 * Result, std::size_t Count)
+		{
+			for(std::size_t i = 0; i < Count; ++i)
+				dispatch_inverse_sse2(m[i], Result[i]);
+		}
+
+		GLM_FUNC_QUALIFIER float dispatch_determinant_sse2(mat4 const & m)
+		{
+			glm_vec4 const a[4] = {_mm_loadu_ps(&m[0][0]), _mm_loadu_ps(&m[1][0]), _mm_loadu_ps(&m[2][0]), _mm_loadu_ps(&m[3][0])};
+			return _mm_cvtss_f32(glm_mat4_determinant(a));
+		}
+
+		GLM_FUNC_QUALIFIER void dispatch_transform_sse2(mat4 const & m, float const * const In[3], float * const Out[4], length_t Rows, std::size_t Count)
+		{
+			glm_vec4 Column[4][4];
+			for(length_t c = 0; c < 4; ++c)
+			for(length_t r = 0; r < 4; ++r)
+				Column[c][r] = _mm_set1_ps(m[c][r]);
+
+			std::size_t i = 0;
+			for(; i < Count - Count % 4; i += 4)
+			{
+				glm_vec4 const x = _mm_loadu_ps(In[0] + i);
+				glm_vec4 const y = _mm_loadu_ps(In[1] + i);
+				glm_vec4 const z = _mm_loadu_ps(In[2] + i);
+				for(length_t Row = 0; Row < Rows; ++Row)
+				{
+					glm_vec4 const Add0 = _mm_add_ps(_mm_mul_ps(Column[0][Row], x), _mm_mul_ps(Column[1][Row], y));
+					glm_vec4 const Add1 = _mm_add_ps(_mm_mul_ps(Column[2][Row], z), Column[3][Row]);
+					_mm_storeu_ps(Out[Row] + i, _mm_add_ps(Add0, Add1));
+				}
+			}
+			dispatch_transform_pure_range(m, In, Out, Rows, i, Count);
+		}
+
+		// Not GLM_FUNC_QUALIFIER: a forced inline into a caller compiled without AVX2 would not build
+		GLM_TARGET_AVX2 inline void dispatch_mul_avx2(mat4 const & m1, mat4 const & m2, mat4 & Result)
+		{
+			glm_vec4 const a[4] = {_mm_loadu_ps(&m1[0][0]), _mm_loadu_ps(&m1[1][0]), _mm_loadu_ps(&m1[2][0]), _mm_loadu_ps(&m1[3][0])};
+			glm_vec4 const b[4] = {_mm_loadu_ps(&m2[0][0]), _mm_loadu_ps(&m2[1][0]), _mm_loadu_ps(&m2[2][0]), _mm_loadu_ps(&m2[3][0])};
+			glm_vec4 r[4];
+			glm_mat4_mul_avx2(a, b, r);
+			for(length_t i = 0; i < 4; ++i)
+				_mm_storeu_ps(&Result[i][0], r[i]);
+		}
+
+		// Column i of m[0] in the low half and of m[1] in the high half
+		GLM_TARGET_AVX2 inline void dispatch_load_pair(mat4 const * m, __m256 Pair[4])
+		{
+			for(length_t i = 0; i < 4; ++i)
+				Pair[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&m[0][i][0])), _mm_loadu_ps(&m[1][i][0]), 1);
+		}
+
+		GLM_TARGET_AVX2 inline void dispatch_store_pair(__m256 const Pair[4], mat4 * m)
+		{
+			for(length_t i = 0; i < 4; ++i)
+			{
+				_mm_storeu_ps(&m[0][i][0], _mm256_castps256_ps128(Pair[i]));
+				_mm_storeu_ps(&m[1][i][0], _mm256_extractf128_ps(Pair[i], 1));
+			}
+		}
+
+		GLM_TARGET_AVX2 inline void dispatch_mul_batch_avx2(mat4 const * m1, mat4 const * m2, mat4 * Result, std::size_t Count)
+		{
+			std::size_t i = 0;
+			for(; i + 1 < Count; i += 2)
+			{
+				__m256 a[4], b[4], r[4];
+				dispatch_load_pair(m1 + i, a);
+				dispatch_load_pair(m2 + i, b);
+				glm_mat4x2_mul(a, b, r);
+				dispatch_store_pair(r, Result + i);
+			}
+			if(i < Count)
+				dispatch_mul_avx2(m1[i], m2[i], Result[i]);
+		}
+
+		GLM_TARGET_AVX2 inline void dispatch_inverse_batch_avx2(mat4 const * m, mat4 * Result, std::size_t Count)
+		{
+			std::size_t i = 0;
+			for(; i + 1 < Count; i += 2)
+			{
+				__m256 a[4], r[4];
+				dispatch_load_pair(m + i, a);
+				glm_mat4x2_inverse(a, r);
+				dispatch_store_pair(r, Result + i);
+			}
+			_mm256_zeroupper();
+			if(i < Count)
+				dispatch_inverse_sse2(m[i], Result[i]);
+		}
+
+		GLM_TARGET_AVX2 inline void dispatch_transform_avx2(mat4 const & m, float const * const In[3], float * const Out[4], length_t Rows, std::size_t Count)
+		{
+			__m256 Column[4][4];
+			for(length_t c = 0; c < 4; ++c)
+			for(length_t r = 0; r < 4; ++r)
+				Column[c][r] = _mm256_set1_ps(m[c][r]);
+
+			std::size_t i = 0;
+			for(; i < Count - Count % 8; i += 8)
+			{
+				__m256 const x = _mm256_loadu_ps(In[0] + i);
+				__m256 const y = _mm256_loadu_ps(In[1] + i);
+				__m256 const z = _mm256_loadu_ps(In[2] + i);
+				for(length_t Row = 0; Row < Rows; ++Row)
+				{
+					__m256 const Add0 = _mm256_add_ps(_mm256_mul_ps(Column[0][Row], x), _mm256_mul_ps(Column[1][Row], y));
+					__m256 const Add1 = _mm256_add_ps(_mm256_mul_ps(Column[2][Row], z), Column[3][Row]);
+					_mm256_storeu_ps(Out[Row] + i, _mm256_add_ps(Add0, Add1));
+				}
+			}
+			// Leave the AVX state before running SSE code again
+			_mm256_zeroupper();
+			dispatch_transform_pure_range(m, In, Out, Rows, i, Count);
+		}
+#	endif//GLM_TARGET_AVX2
+
+	GLM_FUNC_QUALIFIER dispatch_table make_dispatch_table(dispatch_path Path)
+	{
+		dispatch_table Table;
+		Table.Path = dispatch_pure;
+		Table.Mul = dispatch_mul_pure;
+		Table.Inverse = dispatch_inverse_pure;
+		Table.Determinant = dispatch_determinant_pure;
+		Table.MulBatch = dispatch_mul_batch_pure;
+		Table.InverseBatch = dispatch_inverse_batch_pure;
+		Table.Transform = dispatch_transform_pure;
+
+#		ifdef GLM_TARGET_AVX2
+			if(Path == dispatch_sse2 || Path == dispatch_avx2)
+			{
+				Table.Path = dispatch_sse2;
+				Table.Mul = dispatch_mul_sse2;
+				Table.Inverse = dispatch_inverse_sse2;
+				Table.Determinant = dispatch_determinant_sse2;
+				Table.MulBatch = dispatch_mul_batch_sse2;
+				Table.InverseBatch = dispatch_inverse_batch_sse2;
+				Table.Transform = dispatch_transform_sse2;
+			}
+
+			// A single inverse or determinant keeps the SSE2 kernel: it has no second matrix to fill the upper lanes
+			if(Path == dispatch_avx2)
+			{
+				Table.Path = dispatch_avx2;
+				Table.Mul = dispatch_mul_avx2;
+				Table.MulBatch = dispatch_mul_batch_avx2;
+				Table.InverseBatch = dispatch_inverse_batch_avx2;
+				Table.Transform = dispatch_transform_avx2;
+			}
+#		else
+			static_cast<void>(Path);
+#		endif
+
+		return Table;
+	}
+
+	GLM_FUNC_QUALIFIER dispatch_path best_dispatch_path()
+	{
+		if(isDispatchPathSupported(dispatch_avx2))
+			return dispatch_avx2;
+		if(isDispatchPathSupported(dispatch_sse2))
+			return dispatch_sse2;
+		return dispatch_pure;
+	}
+
+	// Built on the first call of a dispatch function, thread safe with C++11 static initialization
+	GLM_FUNC_QUALIFIER dispatch_table & dispatch_current()
+	{
+		static dispatch_table Table = make_dispatch_table(best_dispatch_path());
+		return Table;
+	}
+}//namespace detail
+
+	GLM_FUNC_QUALIFIER int cpuArch()
+	{
+#		ifdef GLM_TARGET_AVX2
+			static int const Arch = glm_cpu_arch();
+			return Arch;
+#		else
+			return GLM_ARCH;
+#		endif
+	}
+
+	GLM_FUNC_QUALIFIER bool isDispatchPathSupported(dispatch_path Path)
+	{
+		switch(Path)
+		{
+		case dispatch_pure:
+			return true;
+#		ifdef GLM_TARGET_AVX2
+			case dispatch_sse2:
+				return true;
+			case dispatch_avx2:
+				return (cpuArch() & GLM_ARCH_AVX2_BIT) != 0;
+#		endif
+		default:
+			return false;
+		}
+	}
+
+	GLM_FUNC_QUALIFIER dispatch_path getDispatchPath()
+	{
+		return detail::dispatch_current().Path;
+	}
+
+	GLM_FUNC_QUALIFIER bool setDispatchPath(dispatch_path Path)
+	{
+		if(!isDispatchPathSupported(Path))
+			return false;
+		detail::dispatch_current() = detail::make_dispatch_table(Path);
+		return true;
+	}
+
+	GLM_FUNC_QUALIFIER mat4 dispatchMul(mat4 const & m1, mat4 const & m2)
+	{
+		mat4 Result(uninitialize);
+		detail::dispatch_current().Mul(m1, m2, Result);
+		return Result;
+	}
+
+	GLM_FUNC_QUALIFIER mat4 dispatchInverse(mat4 const & m)
+	{
+		mat4 Result(uninitialize);
+		detail::dispatch_current().Inverse(m, Result);
+		return Result;
+	}
+
+	GLM_FUNC_QUALIFIER void dispatchMul(mat4 const * m1, mat4 const * m2, mat4 * Result, std::size_t Count)
+	{
+		detail::dispatch_current().MulBatch(m1, m2, Result, Count);
+	}
+
+	GLM_FUNC_QUALIFIER void dispatchInverse(mat4 const * m, mat4 * Result, std::size_t Count)
+	{
+		detail::dispatch_current().InverseBatch(m, Result, Count);
+	}
+
+	GLM_FUNC_QUALIFIER float dispatchDeterminant(mat4 const & m)
+	{
+		return detail::dispatch_current().Determinant(m);
+	}
+
+	GLM_FUNC_QUALIFIER void dispatchTransformPoint(mat4 const & m, soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count)
+	{
+		float const * const In[3] = {v.x, v.y, v.z};
+		float * const Out[4] = {Result.x, Result.y, Result.z, 0};
+		detail::dispatch_current().Transform(m, In, Out, 3, Count);
+	}
+
+	GLM_FUNC_QUALIFIER void dispatchTransform(mat4 const & m, soa_vec3 const & v, soa_vec4 const & Result, std::size_t Count)
+	{
+		float const * const In[3] = {v.x, v.y, v.z};
+		float * const Out[4] = {Result.x, Result.y, Result.z, Result.w};
+		detail::dispatch_current().Transform(m, In, Out, 4, Count);
+	}
+}//namespace glm
@@ -0,0 +1,97 @@
+/// @ref gtx_soa
+/// @file glm/gtx/soa.hpp
+///
+/// @see core (dependence)
+///
+/// @defgroup gtx_soa GLM_GTX_soa
+/// @ingroup gtx
+///
+/// @brief Batched vector math over structure of arrays (SoA) streams.
+/// Each function processes Count vectors stored as one array per component, so every SIMD lane
+/// holds a different vector: 4 with SSE2, 8 with AVX/AVX2 and 16 with AVX-512, selected by GLM_ARCH.
+/// The remainder is processed with the scalar glm functions.
+///
+/// Results are computed with the same operations as the scalar functions but may differ in the
+/// last bits when the compiler contracts the scalar code into FMAs.
+/// Result streams may be the same as an input stream (in place), but must not partially overlap it.
+///
+/// <glm/gtx/soa.hpp> need to be included to use these functionalities.
+
+#pragma once
+
+// Dependency:
+#include "../glm.hpp"
+#include <cstddef>
+
+#if GLM_MESSAGES == GLM_MESSAGES_ENABLED && !defined(GLM_EXT_INCLUDED)
+#	pragma message("GLM: GLM_GTX_soa extension included")
+#endif
+
+namespace glm
+{
+	/// @addtogroup gtx_soa
+	/// @{
+
+	/// Non owning view of 3 component vectors stored as three float arrays.
+	/// @see gtx_soa
+	struct soa_vec3
+	{
+		GLM_FUNC_DECL soa_vec3(float * x, float * y, float * z);
+
+		float * x;
+		float * y;
+		float * z;
+	};
+
+	/// Non owning view of 4 component vectors stored as four float arrays.
+	/// @see gtx_soa
+	struct soa_vec4
+	{
+		GLM_FUNC_DECL soa_vec4(float * x, float * y, float * z, float * w);
+
+		float * x;
+		float * y;
+		float * z;
+		float * w;
+	};
+
+	/// Result[i] = dot(a[i], b[i])
+	/// @see gtx_soa
+	GLM_FUNC_DECL void dot(soa_vec3 const & a, soa_vec3 const & b, float * Result, std::size_t Count);
+
+	/// Result[i] = cross(a[i], b[i])
+	/// @see gtx_soa
+	GLM_FUNC_DECL void cross(soa_vec3 const & a, soa_vec3 const & b, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = length(v[i])
+	/// @see gtx_soa
+	GLM_FUNC_DECL void length(soa_vec3 const & v, float * Result, std::size_t Count);
+
+	/// Result[i] = normalize(v[i])
+	/// @see gtx_soa
+	GLM_FUNC_DECL void normalize(soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = mix(a[i], b[i], t)
+	/// @see gtx_soa
+	GLM_FUNC_DECL void mix(soa_vec3 const & a, soa_vec3 const & b, float t, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = mix(a[i], b[i], t[i])
+	/// @see gtx_soa
+	GLM_FUNC_DECL void mix(soa_vec3 const & a, soa_vec3 const & b, float const * t, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = a[i] + b[i] * s, e.g. an explicit Euler step
+	/// @see gtx_soa
+	GLM_FUNC_DECL void addScaled(soa_vec3 const & a, soa_vec3 const & b, float s, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = vec3(m * vec4(v[i], 1)), for affine transforms of positions
+	/// @see gtx_soa
+	GLM_FUNC_DECL void transformPoint(mat4 const & m, soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count);
+
+	/// Result[i] = m * vec4(v[i], 1), e.g. positions to clip space
+	/// @see gtx_soa
+	GLM_FUNC_DECL void transform(mat4 const & m, soa_vec3 const & v, soa_vec4 const & Result, std::size_t Count);
+
+	/// @}
+}//namespace glm
+
+#include "soa.inl"
@@ -0,0 +1,200 @@
+/// @ref gtx_soa
+/// @file glm/gtx/soa.inl
+
+#include "../simd/soa.h"
+
+namespace glm
+{
+	GLM_FUNC_QUALIFIER soa_vec3::soa_vec3(float * x_, float * y_, float * z_) :
+		x(x_), y(y_), z(z_)
+	{}
+
+	GLM_FUNC_QUALIFIER soa_vec4::soa_vec4(float * x_, float * y_, float * z_, float * w_) :
+		x(x_), y(y_), z(z_), w(w_)
+	{}
+
+namespace detail
+{
+	GLM_FUNC_QUALIFIER vec3 soa_load(soa_vec3 const & v, std::size_t i)
+	{
+		return vec3(v.x[i], v.y[i], v.z[i]);
+	}
+
+	GLM_FUNC_QUALIFIER void soa_store(soa_vec3 const & v, std::size_t i, vec3 const & Value)
+	{
+		v.x[i] = Value.x;
+		v.y[i] = Value.y;
+		v.z[i] = Value.z;
+	}
+
+#	ifdef GLM_SOA_WIDTH
+		// Same association as compute_dot<tvec3>: (x + y) + z
+		GLM_FUNC_QUALIFIER glm_soa soa_dot(glm_soa ax, glm_soa ay, glm_soa az, glm_soa bx, glm_soa by, glm_soa bz)
+		{
+			return glm_soa_add(glm_soa_add(glm_soa_mul(ax, bx), glm_soa_mul(ay, by)), glm_soa_mul(az, bz));
+		}
+
+		// Same association as mat4 * vec4: (c0 * x + c1 * y) + (c2 * z + c3 * 1)
+		GLM_FUNC_QUALIFIER glm_soa soa_transform_row(mat4 const & m, length_t Row, glm_soa x, glm_soa y, glm_soa z)
+		{
+			glm_soa const Add0 = glm_soa_add(glm_soa_mul(glm_soa_set1(m[0][Row]), x), glm_soa_mul(glm_soa_set1(m[1][Row]), y));
+			glm_soa const Add1 = glm_soa_add(glm_soa_mul(glm_soa_set1(m[2][Row]), z), glm_soa_set1(m[3][Row]));
+			return glm_soa_add(Add0, Add1);
+		}
+#	endif
+}//namespace detail
+
+	GLM_FUNC_QUALIFIER void dot(soa_vec3 const & a, soa_vec3 const & b, float * Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa_store(Result + i, detail::soa_dot(
+					glm_soa_load(a.x + i), glm_soa_load(a.y + i), glm_soa_load(a.z + i),
+					glm_soa_load(b.x + i), glm_soa_load(b.y + i), glm_soa_load(b.z + i)));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Result[i] = dot(detail::soa_load(a, i), detail::soa_load(b, i));
+	}
+
+	GLM_FUNC_QUALIFIER void cross(soa_vec3 const & a, soa_vec3 const & b, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const ax = glm_soa_load(a.x + i), ay = glm_soa_load(a.y + i), az = glm_soa_load(a.z + i);
+				glm_soa const bx = glm_soa_load(b.x + i), by = glm_soa_load(b.y + i), bz = glm_soa_load(b.z + i);
+				glm_soa_store(Result.x + i, glm_soa_sub(glm_soa_mul(ay, bz), glm_soa_mul(by, az)));
+				glm_soa_store(Result.y + i, glm_soa_sub(glm_soa_mul(az, bx), glm_soa_mul(bz, ax)));
+				glm_soa_store(Result.z + i, glm_soa_sub(glm_soa_mul(ax, by), glm_soa_mul(bx, ay)));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, cross(detail::soa_load(a, i), detail::soa_load(b, i)));
+	}
+
+	GLM_FUNC_QUALIFIER void length(soa_vec3 const & v, float * Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const x = glm_soa_load(v.x + i), y = glm_soa_load(v.y + i), z = glm_soa_load(v.z + i);
+				glm_soa_store(Result + i, glm_soa_sqrt(detail::soa_dot(x, y, z, x, y, z)));
+			}
+#		endif
+		for(; i < Count; ++i)
+			Result[i] = length(detail::soa_load(v, i));
+	}
+
+	GLM_FUNC_QUALIFIER void normalize(soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			// inversesqrt is 1 / sqrt(x), the approximate rsqrt instructions would not match normalize
+			glm_soa const One = glm_soa_set1(1.0f);
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const x = glm_soa_load(v.x + i), y = glm_soa_load(v.y + i), z = glm_soa_load(v.z + i);
+				glm_soa const InvLength = glm_soa_div(One, glm_soa_sqrt(detail::soa_dot(x, y, z, x, y, z)));
+				glm_soa_store(Result.x + i, glm_soa_mul(x, InvLength));
+				glm_soa_store(Result.y + i, glm_soa_mul(y, InvLength));
+				glm_soa_store(Result.z + i, glm_soa_mul(z, InvLength));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, normalize(detail::soa_load(v, i)));
+	}
+
+	GLM_FUNC_QUALIFIER void mix(soa_vec3 const & a, soa_vec3 const & b, float t, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			glm_soa const Factor = glm_soa_set1(t);
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const ax = glm_soa_load(a.x + i), ay = glm_soa_load(a.y + i), az = glm_soa_load(a.z + i);
+				glm_soa_store(Result.x + i, glm_soa_add(ax, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.x + i), ax))));
+				glm_soa_store(Result.y + i, glm_soa_add(ay, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.y + i), ay))));
+				glm_soa_store(Result.z + i, glm_soa_add(az, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.z + i), az))));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, mix(detail::soa_load(a, i), detail::soa_load(b, i), t));
+	}
+
+	GLM_FUNC_QUALIFIER void mix(soa_vec3 const & a, soa_vec3 const & b, float const * t, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const Factor = glm_soa_load(t + i);
+				glm_soa const ax = glm_soa_load(a.x + i), ay = glm_soa_load(a.y + i), az = glm_soa_load(a.z + i);
+				glm_soa_store(Result.x + i, glm_soa_add(ax, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.x + i), ax))));
+				glm_soa_store(Result.y + i, glm_soa_add(ay, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.y + i), ay))));
+				glm_soa_store(Result.z + i, glm_soa_add(az, glm_soa_mul(Factor, glm_soa_sub(glm_soa_load(b.z + i), az))));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, mix(detail::soa_load(a, i), detail::soa_load(b, i), t[i]));
+	}
+
+	GLM_FUNC_QUALIFIER void addScaled(soa_vec3 const & a, soa_vec3 const & b, float s, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			glm_soa const Scale = glm_soa_set1(s);
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa_store(Result.x + i, glm_soa_add(glm_soa_load(a.x + i), glm_soa_mul(glm_soa_load(b.x + i), Scale)));
+				glm_soa_store(Result.y + i, glm_soa_add(glm_soa_load(a.y + i), glm_soa_mul(glm_soa_load(b.y + i), Scale)));
+				glm_soa_store(Result.z + i, glm_soa_add(glm_soa_load(a.z + i), glm_soa_mul(glm_soa_load(b.z + i), Scale)));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, detail::soa_load(a, i) + detail::soa_load(b, i) * s);
+	}
+
+	GLM_FUNC_QUALIFIER void transformPoint(mat4 const & m, soa_vec3 const & v, soa_vec3 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const x = glm_soa_load(v.x + i), y = glm_soa_load(v.y + i), z = glm_soa_load(v.z + i);
+				glm_soa_store(Result.x + i, detail::soa_transform_row(m, 0, x, y, z));
+				glm_soa_store(Result.y + i, detail::soa_transform_row(m, 1, x, y, z));
+				glm_soa_store(Result.z + i, detail::soa_transform_row(m, 2, x, y, z));
+			}
+#		endif
+		for(; i < Count; ++i)
+			detail::soa_store(Result, i, vec3(m * vec4(detail::soa_load(v, i), 1.0f)));
+	}
+
+	GLM_FUNC_QUALIFIER void transform(mat4 const & m, soa_vec3 const & v, soa_vec4 const & Result, std::size_t Count)
+	{
+		std::size_t i = 0;
+#		ifdef GLM_SOA_WIDTH
+			for(; i < Count - Count % GLM_SOA_WIDTH; i += GLM_SOA_WIDTH)
+			{
+				glm_soa const x = glm_soa_load(v.x + i), y = glm_soa_load(v.y + i), z = glm_soa_load(v.z + i);
+				glm_soa_store(Result.x + i, detail::soa_transform_row(m, 0, x, y, z));
+				glm_soa_store(Result.y + i, detail::soa_transform_row(m, 1, x, y, z));
+				glm_soa_store(Result.z + i, detail::soa_transform_row(m, 2, x, y, z));
+				glm_soa_store(Result.w + i, detail::soa_transform_row(m, 3, x, y, z));
+			}
+#		endif
+		for(; i < Count; ++i)
+		{
+			vec4 const Value = m * vec4(detail::soa_load(v, i), 1.0f);
+			Result.x[i] = Value.x;
+			Result.y[i] = Value.y;
+			Result.z[i] = Value.z;
+			Result.w[i] = Value.w;
+		}
+	}
+}//namespace glm
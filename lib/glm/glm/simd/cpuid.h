@@ -0,0 +1,95 @@
+/// @ref simd
+/// @file glm/simd/cpuid.h
+
+#pragma once
+
+#include "platform.h"
+
+// Runtime detection of the instruction sets, for builds targeting a lower GLM_ARCH than the CPU running them.
+// GLM_TARGET_AVX2 is defined when a function can be compiled for AVX2 and FMA whatever GLM_ARCH is,
+// such function must only be called after glm_cpu_arch reported GLM_ARCH_AVX2_BIT.
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+#if GLM_COMPILER & GLM_COMPILER_VC
+#	include <intrin.h>
+#	include <immintrin.h>
+#	define GLM_TARGET_AVX2
+#elif GLM_COMPILER & (GLM_COMPILER_GCC | GLM_COMPILER_CLANG)
+#	include <cpuid.h>
+#	include <immintrin.h>
+#	define GLM_TARGET_AVX2 __attribute__((__target__("avx2,fma")))
+#endif
+
+#ifdef GLM_TARGET_AVX2
+
+GLM_FUNC_QUALIFIER void glm_cpuid(unsigned int Leaf, unsigned int Info[4])
+{
+#	if GLM_COMPILER & GLM_COMPILER_VC
+		int Registers[4];
+		__cpuidex(Registers, static_cast<int>(Leaf), 0);
+		for(int i = 0; i < 4; ++i)
+			Info[i] = static_cast<unsigned int>(Registers[i]);
+#	else
+		__cpuid_count(Leaf, 0, Info[0], Info[1], Info[2], Info[3]);
+#	endif
+}
+
+// Register states the OS saves on context switches, only valid when cpuid reports OSXSAVE
+GLM_FUNC_QUALIFIER unsigned int glm_xgetbv()
+{
+#	if GLM_COMPILER & GLM_COMPILER_VC
+		return static_cast<unsigned int>(_xgetbv(0));
+#	else
+		unsigned int Eax, Edx;
+		__asm__ __volatile__("xgetbv" : "=a"(Eax), "=d"(Edx) : "c"(0));
+		return Eax;
+#	endif
+}
+
+// GLM_ARCH value of the running CPU. AVX2 is only reported with FMA, AVX-512 with the Skylake subset.
+GLM_FUNC_QUALIFIER int glm_cpu_arch()
+{
+	unsigned int Info[4];
+	glm_cpuid(0, Info);
+	unsigned int const MaxLeaf = Info[0];
+
+	glm_cpuid(1, Info);
+	unsigned int const Ecx = Info[2];
+	unsigned int const Edx = Info[3];
+
+	if(!(Edx & (1u << 26)))
+		return GLM_ARCH_X86;
+	if(!(Ecx & (1u << 0)))
+		return GLM_ARCH_SSE2;
+	if(!(Ecx & (1u << 9)))
+		return GLM_ARCH_SSE3;
+	if(!(Ecx & (1u << 19)))
+		return GLM_ARCH_SSSE3;
+	if(!(Ecx & (1u << 20)))
+		return GLM_ARCH_SSE41;
+
+	// AVX needs the OS to save the YMM registers (XCR0 bits 1 and 2)
+	bool const OSXSAVE = (Ecx & (1u << 27)) != 0;
+	unsigned int const XCR0 = OSXSAVE ? glm_xgetbv() : 0u;
+	if(!(Ecx & (1u << 28)) || (XCR0 & 0x06) != 0x06)
+		return GLM_ARCH_SSE42;
+	if(MaxLeaf < 7)
+		return GLM_ARCH_AVX;
+
+	glm_cpuid(7, Info);
+	unsigned int const Ebx7 = Info[1];
+	if(!(Ebx7 & (1u << 5)) || !(Ecx & (1u << 12)))
+		return GLM_ARCH_AVX;
+
+	// AVX-512 F, DQ, CD, BW and VL with the opmask and ZMM states (XCR0 bits 5 to 7)
+	unsigned int const AVX512Bits = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+	if((Ebx7 & AVX512Bits) != AVX512Bits || (XCR0 & 0xe6) != 0xe6)
+		return GLM_ARCH_AVX2;
+
+	return GLM_ARCH_AVX512;
+}
+
+#endif//GLM_TARGET_AVX2
+
+#endif//GLM_ARCH & GLM_ARCH_SSE2_BIT
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "geometric.h"
+#include "cpuid.h"
 
 #if GLM_ARCH & GLM_ARCH_SSE2_BIT
 
@@ -1026,3 +1027,228 @@ GLM_FUNC_QUALIFIER void glm_mat4_outerProduct(__m128 const & c, __m128 const & r
 }
 
 #endif//GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+// AVX2 and FMA kernels, only to call when glm_cpu_arch() reports GLM_ARCH_AVX2_BIT. In a build for a lower
+// GLM_ARCH they are compiled for AVX2 and FMA anyway, so they are not forced inline into other functions.
+// The glm_mat4x2 functions process two matrices at once: each __m256 holds the same column of both,
+// the first matrix in the low 128 bits and the second one in the high 128 bits.
+#ifdef GLM_TARGET_AVX2
+
+// One product, with two columns of the result per register
+GLM_TARGET_AVX2 inline void glm_mat4_mul_avx2(glm_vec4 const in1[4], glm_vec4 const in2[4], glm_vec4 out[4])
+{
+	__m256 const a0 = _mm256_insertf128_ps(_mm256_castps128_ps256(in1[0]), in1[0], 1);
+	__m256 const a1 = _mm256_insertf128_ps(_mm256_castps128_ps256(in1[1]), in1[1], 1);
+	__m256 const a2 = _mm256_insertf128_ps(_mm256_castps128_ps256(in1[2]), in1[2], 1);
+	__m256 const a3 = _mm256_insertf128_ps(_mm256_castps128_ps256(in1[3]), in1[3], 1);
+
+	for(int i = 0; i < 4; i += 2)
+	{
+		__m256 const b = _mm256_insertf128_ps(_mm256_castps128_ps256(in2[i]), in2[i + 1], 1);
+
+		__m256 const e0 = _mm256_permute_ps(b, _MM_SHUFFLE(0, 0, 0, 0));
+		__m256 const e1 = _mm256_permute_ps(b, _MM_SHUFFLE(1, 1, 1, 1));
+		__m256 const e2 = _mm256_permute_ps(b, _MM_SHUFFLE(2, 2, 2, 2));
+		__m256 const e3 = _mm256_permute_ps(b, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m256 const a01 = _mm256_fmadd_ps(a1, e1, _mm256_mul_ps(a0, e0));
+		__m256 const a23 = _mm256_fmadd_ps(a3, e3, _mm256_mul_ps(a2, e2));
+		__m256 const r = _mm256_add_ps(a01, a23);
+
+		out[i] = _mm256_castps256_ps128(r);
+		out[i + 1] = _mm256_extractf128_ps(r, 1);
+	}
+}
+
+GLM_TARGET_AVX2 inline void glm_mat4x2_mul(__m256 const in1[4], __m256 const in2[4], __m256 out[4])
+{
+	for(int i = 0; i < 4; ++i)
+	{
+		__m256 const e0 = _mm256_permute_ps(in2[i], _MM_SHUFFLE(0, 0, 0, 0));
+		__m256 const e1 = _mm256_permute_ps(in2[i], _MM_SHUFFLE(1, 1, 1, 1));
+		__m256 const e2 = _mm256_permute_ps(in2[i], _MM_SHUFFLE(2, 2, 2, 2));
+		__m256 const e3 = _mm256_permute_ps(in2[i], _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m256 const a01 = _mm256_fmadd_ps(in1[1], e1, _mm256_mul_ps(in1[0], e0));
+		__m256 const a23 = _mm256_fmadd_ps(in1[3], e3, _mm256_mul_ps(in1[2], e2));
+		out[i] = _mm256_add_ps(a01, a23);
+	}
+}
+
+// Same cofactor expansion as glm_mat4_inverse, the shuffles stay within each 128 bit half
+GLM_TARGET_AVX2 inline void glm_mat4x2_inverse(__m256 const in[4], __m256 out[4])
+{
+	__m256 Fac0;
+	{
+		//	valType SubFactor00 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+		//	valType SubFactor06 = m[1][2] * m[3][3] - m[3][2] * m[1][3];
+		//	valType SubFactor13 = m[1][2] * m[2][3] - m[2][2] * m[1][3];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(2, 2, 2, 2));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(2, 2, 2, 2));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(3, 3, 3, 3));
+
+		Fac0 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 Fac1;
+	{
+		//	valType SubFactor01 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+		//	valType SubFactor07 = m[1][1] * m[3][3] - m[3][1] * m[1][3];
+		//	valType SubFactor14 = m[1][1] * m[2][3] - m[2][1] * m[1][3];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(1, 1, 1, 1));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(1, 1, 1, 1));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(3, 3, 3, 3));
+
+		Fac1 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 Fac2;
+	{
+		//	valType SubFactor02 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+		//	valType SubFactor08 = m[1][1] * m[3][2] - m[3][1] * m[1][2];
+		//	valType SubFactor15 = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(2, 2, 2, 2));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(1, 1, 1, 1));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(1, 1, 1, 1));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(2, 2, 2, 2));
+
+		Fac2 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 Fac3;
+	{
+		//	valType SubFactor03 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+		//	valType SubFactor09 = m[1][0] * m[3][3] - m[3][0] * m[1][3];
+		//	valType SubFactor16 = m[1][0] * m[2][3] - m[2][0] * m[1][3];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(0, 0, 0, 0));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(0, 0, 0, 0));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(3, 3, 3, 3));
+
+		Fac3 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 Fac4;
+	{
+		//	valType SubFactor04 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+		//	valType SubFactor10 = m[1][0] * m[3][2] - m[3][0] * m[1][2];
+		//	valType SubFactor17 = m[1][0] * m[2][2] - m[2][0] * m[1][2];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(2, 2, 2, 2));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(0, 0, 0, 0));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(0, 0, 0, 0));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(2, 2, 2, 2));
+
+		Fac4 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 Fac5;
+	{
+		//	valType SubFactor05 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+		//	valType SubFactor12 = m[1][0] * m[3][1] - m[3][0] * m[1][1];
+		//	valType SubFactor18 = m[1][0] * m[2][1] - m[2][0] * m[1][1];
+
+		__m256 Swp0a = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(1, 1, 1, 1));
+		__m256 Swp0b = _mm256_shuffle_ps(in[3], in[2], _MM_SHUFFLE(0, 0, 0, 0));
+
+		__m256 Swp00 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(0, 0, 0, 0));
+		__m256 Swp01 = _mm256_shuffle_ps(Swp0a, Swp0a, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp02 = _mm256_shuffle_ps(Swp0b, Swp0b, _MM_SHUFFLE(2, 0, 0, 0));
+		__m256 Swp03 = _mm256_shuffle_ps(in[2], in[1], _MM_SHUFFLE(1, 1, 1, 1));
+
+		Fac5 = _mm256_fmsub_ps(Swp00, Swp01, _mm256_mul_ps(Swp02, Swp03));
+	}
+
+	__m256 SignA = _mm256_set_ps( 1.0f,-1.0f, 1.0f,-1.0f, 1.0f,-1.0f, 1.0f,-1.0f);
+	__m256 SignB = _mm256_set_ps(-1.0f, 1.0f,-1.0f, 1.0f,-1.0f, 1.0f,-1.0f, 1.0f);
+
+	__m256 Temp0 = _mm256_shuffle_ps(in[1], in[0], _MM_SHUFFLE(0, 0, 0, 0));
+	__m256 Vec0 = _mm256_shuffle_ps(Temp0, Temp0, _MM_SHUFFLE(2, 2, 2, 0));
+
+	__m256 Temp1 = _mm256_shuffle_ps(in[1], in[0], _MM_SHUFFLE(1, 1, 1, 1));
+	__m256 Vec1 = _mm256_shuffle_ps(Temp1, Temp1, _MM_SHUFFLE(2, 2, 2, 0));
+
+	__m256 Temp2 = _mm256_shuffle_ps(in[1], in[0], _MM_SHUFFLE(2, 2, 2, 2));
+	__m256 Vec2 = _mm256_shuffle_ps(Temp2, Temp2, _MM_SHUFFLE(2, 2, 2, 0));
+
+	__m256 Temp3 = _mm256_shuffle_ps(in[1], in[0], _MM_SHUFFLE(3, 3, 3, 3));
+	__m256 Vec3 = _mm256_shuffle_ps(Temp3, Temp3, _MM_SHUFFLE(2, 2, 2, 0));
+
+	// col0
+	// + (Vec1[0] * Fac0[0] - Vec2[0] * Fac1[0] + Vec3[0] * Fac2[0]),
+	// - (Vec1[1] * Fac0[1] - Vec2[1] * Fac1[1] + Vec3[1] * Fac2[1]),
+	// + (Vec1[2] * Fac0[2] - Vec2[2] * Fac1[2] + Vec3[2] * Fac2[2]),
+	// - (Vec1[3] * Fac0[3] - Vec2[3] * Fac1[3] + Vec3[3] * Fac2[3]),
+	__m256 Sub00 = _mm256_fmsub_ps(Vec1, Fac0, _mm256_mul_ps(Vec2, Fac1));
+	__m256 Add00 = _mm256_fmadd_ps(Vec3, Fac2, Sub00);
+	__m256 Inv0 = _mm256_mul_ps(SignB, Add00);
+
+	// col1
+	// - (Vec0[0] * Fac0[0] - Vec2[0] * Fac3[0] + Vec3[0] * Fac4[0]),
+	// + (Vec0[0] * Fac0[1] - Vec2[1] * Fac3[1] + Vec3[1] * Fac4[1]),
+	// - (Vec0[0] * Fac0[2] - Vec2[2] * Fac3[2] + Vec3[2] * Fac4[2]),
+	// + (Vec0[0] * Fac0[3] - Vec2[3] * Fac3[3] + Vec3[3] * Fac4[3]),
+	__m256 Sub01 = _mm256_fmsub_ps(Vec0, Fac0, _mm256_mul_ps(Vec2, Fac3));
+	__m256 Add01 = _mm256_fmadd_ps(Vec3, Fac4, Sub01);
+	__m256 Inv1 = _mm256_mul_ps(SignA, Add01);
+
+	// col2
+	// + (Vec0[0] * Fac1[0] - Vec1[0] * Fac3[0] + Vec3[0] * Fac5[0]),
+	// - (Vec0[0] * Fac1[1] - Vec1[1] * Fac3[1] + Vec3[1] * Fac5[1]),
+	// + (Vec0[0] * Fac1[2] - Vec1[2] * Fac3[2] + Vec3[2] * Fac5[2]),
+	// - (Vec0[0] * Fac1[3] - Vec1[3] * Fac3[3] + Vec3[3] * Fac5[3]),
+	__m256 Sub02 = _mm256_fmsub_ps(Vec0, Fac1, _mm256_mul_ps(Vec1, Fac3));
+	__m256 Add02 = _mm256_fmadd_ps(Vec3, Fac5, Sub02);
+	__m256 Inv2 = _mm256_mul_ps(SignB, Add02);
+
+	// col3
+	// - (Vec1[0] * Fac2[0] - Vec1[0] * Fac4[0] + Vec2[0] * Fac5[0]),
+	// + (Vec1[0] * Fac2[1] - Vec1[1] * Fac4[1] + Vec2[1] * Fac5[1]),
+	// - (Vec1[0] * Fac2[2] - Vec1[2] * Fac4[2] + Vec2[2] * Fac5[2]),
+	// + (Vec1[0] * Fac2[3] - Vec1[3] * Fac4[3] + Vec2[3] * Fac5[3]));
+	__m256 Sub03 = _mm256_fmsub_ps(Vec0, Fac2, _mm256_mul_ps(Vec1, Fac4));
+	__m256 Add03 = _mm256_fmadd_ps(Vec2, Fac5, Sub03);
+	__m256 Inv3 = _mm256_mul_ps(SignA, Add03);
+
+	__m256 Row0 = _mm256_shuffle_ps(Inv0, Inv1, _MM_SHUFFLE(0, 0, 0, 0));
+	__m256 Row1 = _mm256_shuffle_ps(Inv2, Inv3, _MM_SHUFFLE(0, 0, 0, 0));
+	__m256 Row2 = _mm256_shuffle_ps(Row0, Row1, _MM_SHUFFLE(2, 0, 2, 0));
+
+	//	valType Determinant = m[0][0] * Inverse[0][0]
+	//						+ m[0][1] * Inverse[1][0]
+	//						+ m[0][2] * Inverse[2][0]
+	//						+ m[0][3] * Inverse[3][0];
+	__m256 Dot0 = _mm256_mul_ps(in[0], Row2);
+	__m256 Dot1 = _mm256_add_ps(Dot0, _mm256_permute_ps(Dot0, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m256 Det0 = _mm256_add_ps(Dot1, _mm256_permute_ps(Dot1, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m256 Rcp0 = _mm256_div_ps(_mm256_set1_ps(1.0f), Det0);
+
+	//	Inverse /= Determinant;
+	out[0] = _mm256_mul_ps(Inv0, Rcp0);
+	out[1] = _mm256_mul_ps(Inv1, Rcp0);
+	out[2] = _mm256_mul_ps(Inv2, Rcp0);
+	out[3] = _mm256_mul_ps(Inv3, Rcp0);
+}
+
+#endif//GLM_TARGET_AVX2
@@ -3,6 +3,136 @@
 
 #pragma once
 
+#include "platform.h"
+
 #if GLM_ARCH & GLM_ARCH_SSE2_BIT
 
+// Rounds half away from zero like std::round. x - trunc(x) is exact, so the tie test is exact too.
+// Lanes must fit in an int32.
+GLM_FUNC_QUALIFIER glm_ivec4 glm_vec4_round_away_to_ivec4(glm_vec4 x)
+{
+	glm_ivec4 const trc0 = _mm_cvttps_epi32(x);
+	glm_vec4 const frc0 = _mm_sub_ps(x, _mm_cvtepi32_ps(trc0));
+	glm_ivec4 const up0 = _mm_castps_si128(_mm_cmpge_ps(frc0, _mm_set1_ps(0.5f)));
+	glm_ivec4 const dn0 = _mm_castps_si128(_mm_cmple_ps(frc0, _mm_set1_ps(-0.5f)));
+	return _mm_add_epi32(_mm_sub_epi32(trc0, up0), dn0);
+}
+
+GLM_FUNC_QUALIFIER glm_vec4 glm_vec4_clamp(glm_vec4 x, float minVal, float maxVal)
+{
+	return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(minVal)), _mm_set1_ps(maxVal));
+}
+
+// Packs eight lanes holding 0..65535 to uint16, SSE2 only has a signed saturating pack
+GLM_FUNC_QUALIFIER glm_uvec4 glm_uvec4_pack_u16(glm_uvec4 a, glm_uvec4 b)
+{
+	glm_uvec4 const bias = _mm_set1_epi32(32768);
+	glm_uvec4 const pck0 = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+	return _mm_xor_si128(pck0, _mm_set1_epi16(static_cast<short>(0x8000)));
+}
+
+// Same result as detail::toFloat16 per lane (round half up, not to even), in the low 16 bits
+GLM_FUNC_QUALIFIER glm_uvec4 glm_vec4_to_half(glm_vec4 v)
+{
+	glm_ivec4 const i = _mm_castps_si128(v);
+	glm_ivec4 const s = _mm_and_si128(_mm_srli_epi32(i, 16), _mm_set1_epi32(0x8000));
+	glm_ivec4 const e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(i, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127 - 15));
+	glm_ivec4 const m = _mm_and_si128(i, _mm_set1_epi32(0x007fffff));
+
+	// Normalized: rounding carries into the exponent by itself, too large exponents saturate to infinity
+	glm_ivec4 const rnd = _mm_add_epi32(m, _mm_slli_epi32(_mm_and_si128(m, _mm_set1_epi32(0x00001000)), 1));
+	glm_ivec4 nrm = _mm_add_epi32(_mm_slli_epi32(e, 10), _mm_srli_epi32(rnd, 13));
+	glm_ivec4 const ovf = _mm_cmpgt_epi32(nrm, _mm_set1_epi32(0x7c00));
+	nrm = _mm_or_si128(_mm_andnot_si128(ovf, nrm), _mm_and_si128(ovf, _mm_set1_epi32(0x7c00)));
+
+	// Denormalized: |v| * 2^24 rounded half up, the scale by a power of two is exact
+	glm_vec4 const den0 = _mm_mul_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), v), _mm_set1_ps(16777216.0f));
+	glm_ivec4 const den1 = _mm_cvttps_epi32(den0);
+	glm_vec4 const frc0 = _mm_sub_ps(den0, _mm_cvtepi32_ps(den1));
+	glm_ivec4 const den = _mm_sub_epi32(den1, _mm_castps_si128(_mm_cmpge_ps(frc0, _mm_set1_ps(0.5f))));
+
+	// Infinity and NaN, a NaN keeps a non zero significand
+	glm_ivec4 const man = _mm_srli_epi32(m, 13);
+	glm_ivec4 const nan0 = _mm_andnot_si128(_mm_cmpeq_epi32(m, _mm_setzero_si128()), _mm_cmpeq_epi32(man, _mm_setzero_si128()));
+	glm_ivec4 const inf = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0x7c00), man), _mm_and_si128(nan0, _mm_set1_epi32(1)));
+
+	glm_ivec4 const isZero = _mm_cmplt_epi32(e, _mm_set1_epi32(-10));
+	glm_ivec4 const isDen = _mm_andnot_si128(isZero, _mm_cmplt_epi32(e, _mm_set1_epi32(1)));
+	glm_ivec4 const isInf = _mm_cmpeq_epi32(e, _mm_set1_epi32(0xff - (127 - 15)));
+	glm_ivec4 const isNrm = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(isZero, isDen), isInf), _mm_set1_epi32(-1));
+
+	glm_ivec4 res = _mm_and_si128(isNrm, nrm);
+	res = _mm_or_si128(res, _mm_and_si128(isDen, den));
+	res = _mm_or_si128(res, _mm_and_si128(isInf, inf));
+	return _mm_or_si128(res, s);
+}
+
+// Same result as detail::toFloat32 per lane, the half is in the low 16 bits.
+// Denormals are renormalized with an exact subtraction, no denormal float is formed.
+GLM_FUNC_QUALIFIER glm_vec4 glm_half_to_vec4(glm_uvec4 h)
+{
+	glm_ivec4 const shf = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+	glm_ivec4 const exp = _mm_and_si128(shf, _mm_set1_epi32(0x0f800000));
+	glm_ivec4 o = _mm_add_epi32(shf, _mm_set1_epi32((127 - 15) << 23));
+
+	glm_ivec4 const isInf = _mm_cmpeq_epi32(exp, _mm_set1_epi32(0x0f800000));
+	glm_ivec4 const isDen = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+	o = _mm_add_epi32(o, _mm_and_si128(isInf, _mm_set1_epi32((128 - 16) << 23)));
+
+	glm_vec4 const den = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+	glm_vec4 res = _mm_or_ps(_mm_andnot_ps(_mm_castsi128_ps(isDen), _mm_castsi128_ps(o)), _mm_and_ps(_mm_castsi128_ps(isDen), den));
+	return _mm_or_ps(res, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16)));
+}
+
 #endif//GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+#if GLM_ARCH & GLM_ARCH_AVX2_BIT
+
+// Eight lane version of glm_vec4_to_half
+GLM_FUNC_QUALIFIER __m256i glm_vec8_to_half(__m256 v)
+{
+	__m256i const i = _mm256_castps_si256(v);
+	__m256i const s = _mm256_and_si256(_mm256_srli_epi32(i, 16), _mm256_set1_epi32(0x8000));
+	__m256i const e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(i, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127 - 15));
+	__m256i const m = _mm256_and_si256(i, _mm256_set1_epi32(0x007fffff));
+
+	__m256i const rnd = _mm256_add_epi32(m, _mm256_slli_epi32(_mm256_and_si256(m, _mm256_set1_epi32(0x00001000)), 1));
+	__m256i const nrm = _mm256_min_epi32(_mm256_add_epi32(_mm256_slli_epi32(e, 10), _mm256_srli_epi32(rnd, 13)), _mm256_set1_epi32(0x7c00));
+
+	// Denormalized: the variable shift of the scalar code is available here
+	__m256i const shf = _mm256_sub_epi32(_mm256_set1_epi32(1), e);
+	__m256i const den0 = _mm256_srlv_epi32(_mm256_or_si256(m, _mm256_set1_epi32(0x00800000)), shf);
+	__m256i const den = _mm256_srli_epi32(_mm256_add_epi32(den0, _mm256_slli_epi32(_mm256_and_si256(den0, _mm256_set1_epi32(0x00001000)), 1)), 13);
+
+	__m256i const man = _mm256_srli_epi32(m, 13);
+	__m256i const nan0 = _mm256_andnot_si256(_mm256_cmpeq_epi32(m, _mm256_setzero_si256()), _mm256_cmpeq_epi32(man, _mm256_setzero_si256()));
+	__m256i const inf = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0x7c00), man), _mm256_and_si256(nan0, _mm256_set1_epi32(1)));
+
+	__m256i const isZero = _mm256_cmpgt_epi32(_mm256_set1_epi32(-10), e);
+	__m256i const isDen = _mm256_andnot_si256(isZero, _mm256_cmpgt_epi32(_mm256_set1_epi32(1), e));
+	__m256i const isInf = _mm256_cmpeq_epi32(e, _mm256_set1_epi32(0xff - (127 - 15)));
+	__m256i const isNrm = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(isZero, isDen), isInf), _mm256_set1_epi32(-1));
+
+	__m256i res = _mm256_and_si256(isNrm, nrm);
+	res = _mm256_or_si256(res, _mm256_and_si256(isDen, den));
+	res = _mm256_or_si256(res, _mm256_and_si256(isInf, inf));
+	return _mm256_or_si256(res, s);
+}
+
+// Eight lane version of glm_half_to_vec4
+GLM_FUNC_QUALIFIER __m256 glm_half_to_vec8(__m256i h)
+{
+	__m256i const shf = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x7fff)), 13);
+	__m256i const exp = _mm256_and_si256(shf, _mm256_set1_epi32(0x0f800000));
+	__m256i o = _mm256_add_epi32(shf, _mm256_set1_epi32((127 - 15) << 23));
+
+	__m256i const isInf = _mm256_cmpeq_epi32(exp, _mm256_set1_epi32(0x0f800000));
+	__m256i const isDen = _mm256_cmpeq_epi32(exp, _mm256_setzero_si256());
+	o = _mm256_add_epi32(o, _mm256_and_si256(isInf, _mm256_set1_epi32((128 - 16) << 23)));
+
+	__m256 const den = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_add_epi32(o, _mm256_set1_epi32(1 << 23))), _mm256_castsi256_ps(_mm256_set1_epi32(113 << 23)));
+	__m256 const res = _mm256_blendv_ps(_mm256_castsi256_ps(o), den, _mm256_castsi256_ps(isDen));
+	return _mm256_or_ps(res, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16)));
+}
+
+#endif//GLM_ARCH & GLM_ARCH_AVX2_BIT
@@ -0,0 +1,149 @@
+/// @ref simd
+/// @file glm/simd/soa.h
+
+#pragma once
+
+#include "platform.h"
+
+// Widest float register of the target, used by the structure of arrays kernels of gtx_soa.
+// GLM_SOA_WIDTH is the number of floats per register and is not defined without SIMD.
+
+#if GLM_ARCH & GLM_ARCH_AVX512_BIT
+
+#define GLM_SOA_WIDTH 16
+
+typedef __m512 glm_soa;
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_load(float const * p)
+{
+	return _mm512_loadu_ps(p);
+}
+
+GLM_FUNC_QUALIFIER void glm_soa_store(float * p, glm_soa v)
+{
+	_mm512_storeu_ps(p, v);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_set1(float s)
+{
+	return _mm512_set1_ps(s);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_add(glm_soa a, glm_soa b)
+{
+	return _mm512_add_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sub(glm_soa a, glm_soa b)
+{
+	return _mm512_sub_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_mul(glm_soa a, glm_soa b)
+{
+	return _mm512_mul_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_div(glm_soa a, glm_soa b)
+{
+	return _mm512_div_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sqrt(glm_soa a)
+{
+	return _mm512_sqrt_ps(a);
+}
+
+#elif GLM_ARCH & GLM_ARCH_AVX_BIT
+
+#define GLM_SOA_WIDTH 8
+
+typedef __m256 glm_soa;
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_load(float const * p)
+{
+	return _mm256_loadu_ps(p);
+}
+
+GLM_FUNC_QUALIFIER void glm_soa_store(float * p, glm_soa v)
+{
+	_mm256_storeu_ps(p, v);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_set1(float s)
+{
+	return _mm256_set1_ps(s);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_add(glm_soa a, glm_soa b)
+{
+	return _mm256_add_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sub(glm_soa a, glm_soa b)
+{
+	return _mm256_sub_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_mul(glm_soa a, glm_soa b)
+{
+	return _mm256_mul_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_div(glm_soa a, glm_soa b)
+{
+	return _mm256_div_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sqrt(glm_soa a)
+{
+	return _mm256_sqrt_ps(a);
+}
+
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+#define GLM_SOA_WIDTH 4
+
+typedef glm_vec4 glm_soa;
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_load(float const * p)
+{
+	return _mm_loadu_ps(p);
+}
+
+GLM_FUNC_QUALIFIER void glm_soa_store(float * p, glm_soa v)
+{
+	_mm_storeu_ps(p, v);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_set1(float s)
+{
+	return _mm_set1_ps(s);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_add(glm_soa a, glm_soa b)
+{
+	return _mm_add_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sub(glm_soa a, glm_soa b)
+{
+	return _mm_sub_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_mul(glm_soa a, glm_soa b)
+{
+	return _mm_mul_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_div(glm_soa a, glm_soa b)
+{
+	return _mm_div_ps(a, b);
+}
+
+GLM_FUNC_QUALIFIER glm_soa glm_soa_sqrt(glm_soa a)
+{
+	return _mm_sqrt_ps(a);
+}
+
+#endif
@@ -208,6 +208,69 @@ int test_inverse_simd()
 	return Error;
 }
 
+#ifdef GLM_TARGET_AVX2
+// The AVX2 and FMA kernels of simd/matrix.h, on two matrices at once, with the accuracy of test_inverse_simd
+GLM_TARGET_AVX2 int test_inverse_avx2_kernels()
+{
+	int Error = 0;
+
+	glm::mat4x4 const Identity(1);
+
+	glm::mat4x4 const A4x4(
+		glm::vec4(1, 0, 1, 0),
+		glm::vec4(0, 1, 0, 0),
+		glm::vec4(0, 0, 1, 0),
+		glm::vec4(0, 0, 0, 1));
+	glm::mat4x4 const B4x4 = glm::rotate(glm::translate(glm::mat4x4(1), glm::vec3(1, 2, 3)), 0.5f, glm::normalize(glm::vec3(1, 2, 3)));
+
+	__m256 Pair[4];
+	for(glm::length_t i = 0; i < 4; ++i)
+		Pair[i] = _mm256_setr_ps(A4x4[i].x, A4x4[i].y, A4x4[i].z, A4x4[i].w, B4x4[i].x, B4x4[i].y, B4x4[i].z, B4x4[i].w);
+
+	__m256 Inverse[4];
+	glm_mat4x2_inverse(Pair, Inverse);
+	__m256 Product[4];
+	glm_mat4x2_mul(Pair, Inverse, Product);
+
+	float Result[4][8];
+	for(glm::length_t i = 0; i < 4; ++i)
+		_mm256_storeu_ps(Result[i], Product[i]);
+
+	for(glm::length_t i = 0; i < 4; ++i)
+	{
+		Error += glm::all(glm::epsilonEqual(glm::vec4(Result[i][0], Result[i][1], Result[i][2], Result[i][3]), Identity[i], 0.001f)) ? 0 : 1;
+		Error += glm::all(glm::epsilonEqual(glm::vec4(Result[i][4], Result[i][5], Result[i][6], Result[i][7]), Identity[i], 0.001f)) ? 0 : 1;
+	}
+
+	glm_vec4 Columns[4], InverseColumns[4], Single[4];
+	for(glm::length_t i = 0; i < 4; ++i)
+		Columns[i] = _mm_setr_ps(B4x4[i].x, B4x4[i].y, B4x4[i].z, B4x4[i].w);
+	glm_mat4_inverse(Columns, InverseColumns);
+	glm_mat4_mul_avx2(Columns, InverseColumns, Single);
+
+	for(glm::length_t i = 0; i < 4; ++i)
+	{
+		float Column[4];
+		_mm_storeu_ps(Column, Single[i]);
+		Error += glm::all(glm::epsilonEqual(glm::vec4(Column[0], Column[1], Column[2], Column[3]), Identity[i], 0.001f)) ? 0 : 1;
+	}
+
+	return Error;
+}
+#endif//GLM_TARGET_AVX2
+
+int test_inverse_avx2()
+{
+	int Error = 0;
+
+#	ifdef GLM_TARGET_AVX2
+	if(glm_cpu_arch() & GLM_ARCH_AVX2_BIT)
+		Error += test_inverse_avx2_kernels();
+#	endif//GLM_TARGET_AVX2
+
+	return Error;
+}
+
 template <typename VEC3, typename MAT4>
 int test_inverse_perf(std::size_t Count, std::size_t Instance, char const * Message)
 {
@@ -262,6 +325,7 @@ int main()
 	Error += test_determinant();
 	Error += test_inverse();
 	Error += test_inverse_simd();
+	Error += test_inverse_avx2();
 
 #	ifdef NDEBUG
 	std::size_t const Samples(1000);
@@ -0,0 +1,245 @@
+#include <glm/gtc/packing.hpp>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// Floats covering every exponent, both signs, ties at each rounding position, denormals, infinities and NaNs.
+// The span functions have to match the scalar ones bit for bit on all of them.
+static std::vector<float> sample_floats()
+{
+	std::vector<float> Result;
+
+	for(glm::uint64 Bits = 0; Bits < 0x100000000ull; Bits += 0x1011)
+	{
+		glm::uint32 const Value = static_cast<glm::uint32>(Bits);
+		float f;
+		std::memcpy(&f, &Value, sizeof(f));
+		Result.push_back(f);
+	}
+
+	// Exact ties of the half conversion: bit 12 set and nothing below it, normal and denormal
+	for(glm::uint32 Exponent = 90; Exponent < 150; ++Exponent)
+	for(glm::uint32 Mantissa = 0; Mantissa < 0x800000; Mantissa += 0x3000)
+	{
+		glm::uint32 const Value = (Exponent << 23) | (Mantissa & ~0x1fffu) | 0x1000;
+		float f;
+		std::memcpy(&f, &Value, sizeof(f));
+		Result.push_back(f);
+		Result.push_back(-f);
+	}
+
+	// Exact ties of denormal halves, (k + 0.5) * 2^-24
+	for(int k = 0; k < 1024; ++k)
+	{
+		Result.push_back((static_cast<float>(k) + 0.5f) * 5.9604644775390625e-8f);
+		Result.push_back(-(static_cast<float>(k) + 0.5f) * 5.9604644775390625e-8f);
+	}
+
+	// Exact ties of the fixed point conversions
+	for(int i = -65535 * 2; i <= 65535 * 2; ++i)
+	{
+		Result.push_back((static_cast<float>(i) + 0.5f) / 255.0f);
+		Result.push_back((static_cast<float>(i) + 0.5f) / 127.0f);
+		Result.push_back((static_cast<float>(i) + 0.5f) / 65535.0f);
+		Result.push_back((static_cast<float>(i) + 0.5f) / 32767.0f);
+	}
+
+	return Result;
+}
+
+static bool is_nan(float f)
+{
+	return f != f;
+}
+
+// Unpacked floats are compared by bits, the pack functions are not defined for NaN inputs
+template <typename packedType>
+static int compare_packed(std::vector<float> const & Input, std::vector<packedType> const & Span, packedType (*Scalar)(float), bool WithNaN)
+{
+	int Error = 0;
+	for(std::size_t i = 0; i < Span.size(); ++i)
+	{
+		if(!WithNaN && is_nan(Input[i]))
+			continue;
+		Error += Span[i] == Scalar(Input[i]) ? 0 : 1;
+	}
+	return Error;
+}
+
+template <typename packedType>
+static int compare_unpacked(std::vector<packedType> const & Input, std::vector<float> const & Span, float (*Scalar)(packedType))
+{
+	int Error = 0;
+	for(std::size_t i = 0; i < Input.size(); ++i)
+	{
+		float const Expected = Scalar(Input[i]);
+		Error += std::memcmp(&Expected, &Span[i], sizeof(float)) == 0 ? 0 : 1;
+	}
+	return Error;
+}
+
+// Every odd count exercises a different scalar tail length
+static int test_packHalf()
+{
+	int Error = 0;
+
+	std::vector<float> const Input = sample_floats();
+	for(std::size_t Tail = 0; Tail < 9; ++Tail)
+	{
+		std::size_t const Count = Input.size() - Tail;
+		std::vector<float> Data(Input.begin(), Input.begin() + Count);
+		std::vector<glm::uint16> Packed(Count);
+		glm::packHalf1x16(&Data[0], &Packed[0], Count);
+		Error += compare_packed<glm::uint16>(Data, Packed, glm::packHalf1x16, true);
+	}
+
+	return Error;
+}
+
+static int test_unpackHalf()
+{
+	int Error = 0;
+
+	// Exhaustive
+	std::vector<glm::uint16> Input(65536 + 5);
+	for(std::size_t i = 0; i < Input.size(); ++i)
+		Input[i] = static_cast<glm::uint16>(i);
+
+	std::vector<float> Unpacked(Input.size());
+	glm::unpackHalf1x16(&Input[0], &Unpacked[0], Input.size());
+	Error += compare_unpacked<glm::uint16>(Input, Unpacked, glm::unpackHalf1x16);
+
+	return Error;
+}
+
+static int test_packNorm()
+{
+	int Error = 0;
+
+	std::vector<float> const Input = sample_floats();
+	std::size_t const Count = Input.size() - 3;
+
+	std::vector<glm::uint8> Packed8(Count);
+	glm::packUnorm1x8(&Input[0], &Packed8[0], Count);
+	Error += compare_packed<glm::uint8>(Input, Packed8, glm::packUnorm1x8, false);
+	glm::packSnorm1x8(&Input[0], &Packed8[0], Count);
+	Error += compare_packed<glm::uint8>(Input, Packed8, glm::packSnorm1x8, false);
+
+	std::vector<glm::uint16> Packed16(Count);
+	glm::packUnorm1x16(&Input[0], &Packed16[0], Count);
+	Error += compare_packed<glm::uint16>(Input, Packed16, glm::packUnorm1x16, false);
+	glm::packSnorm1x16(&Input[0], &Packed16[0], Count);
+	Error += compare_packed<glm::uint16>(Input, Packed16, glm::packSnorm1x16, false);
+
+	return Error;
+}
+
+static int test_unpackNorm()
+{
+	int Error = 0;
+
+	std::vector<glm::uint8> Input8(256 + 7);
+	for(std::size_t i = 0; i < Input8.size(); ++i)
+		Input8[i] = static_cast<glm::uint8>(i);
+	std::vector<float> Unpacked(Input8.size());
+	glm::unpackUnorm1x8(&Input8[0], &Unpacked[0], Input8.size());
+	Error += compare_unpacked<glm::uint8>(Input8, Unpacked, glm::unpackUnorm1x8);
+	glm::unpackSnorm1x8(&Input8[0], &Unpacked[0], Input8.size());
+	Error += compare_unpacked<glm::uint8>(Input8, Unpacked, glm::unpackSnorm1x8);
+
+	std::vector<glm::uint16> Input16(65536 + 7);
+	for(std::size_t i = 0; i < Input16.size(); ++i)
+		Input16[i] = static_cast<glm::uint16>(i);
+	Unpacked.resize(Input16.size());
+	glm::unpackUnorm1x16(&Input16[0], &Unpacked[0], Input16.size());
+	Error += compare_unpacked<glm::uint16>(Input16, Unpacked, glm::unpackUnorm1x16);
+	glm::unpackSnorm1x16(&Input16[0], &Unpacked[0], Input16.size());
+	Error += compare_unpacked<glm::uint16>(Input16, Unpacked, glm::unpackSnorm1x16);
+
+	return Error;
+}
+
+// A packed vec4 array is the same as the span of its components
+static int test_packUnorm4x8()
+{
+	int Error = 0;
+
+	std::vector<glm::vec4> Colors;
+	for(int i = 0; i < 1001; ++i)
+		Colors.push_back(glm::vec4(i / 1000.f, 1.f - i / 1000.f, (i % 17) / 16.f, 0.5f));
+
+	std::vector<glm::uint32> Packed(Colors.size());
+	glm::packUnorm1x8(&Colors[0].x, reinterpret_cast<glm::uint8*>(&Packed[0]), Colors.size() * 4);
+	for(std::size_t i = 0; i < Colors.size(); ++i)
+		Error += Packed[i] == glm::packUnorm4x8(Colors[i]) ? 0 : 1;
+
+	return Error;
+}
+
+static int perf()
+{
+	std::size_t const Count = 1 << 24;
+
+	std::vector<float> Input(Count);
+	for(std::size_t i = 0; i < Count; ++i)
+		Input[i] = static_cast<float>(i % 20000) / 10000.0f - 1.0f;
+	std::vector<glm::uint16> Packed(Count);
+	std::vector<float> Unpacked(Count);
+
+	std::clock_t const Timestamp0 = std::clock();
+
+	for(std::size_t i = 0; i < Count; ++i)
+		Packed[i] = glm::packHalf1x16(Input[i]);
+
+	std::clock_t const Timestamp1 = std::clock();
+
+	glm::packHalf1x16(&Input[0], &Packed[0], Count);
+
+	std::clock_t const Timestamp2 = std::clock();
+
+	for(std::size_t i = 0; i < Count; ++i)
+		Unpacked[i] = glm::unpackHalf1x16(Packed[i]);
+
+	std::clock_t const Timestamp3 = std::clock();
+
+	glm::unpackHalf1x16(&Packed[0], &Unpacked[0], Count);
+
+	std::clock_t const Timestamp4 = std::clock();
+
+	for(std::size_t i = 0; i < Count; ++i)
+		Packed[i] = glm::packSnorm1x16(Input[i]);
+
+	std::clock_t const Timestamp5 = std::clock();
+
+	glm::packSnorm1x16(&Input[0], &Packed[0], Count);
+
+	std::clock_t const Timestamp6 = std::clock();
+
+	// Millions of values per second
+	double const Scale = static_cast<double>(Count) / 1e6 * CLOCKS_PER_SEC;
+	std::clock_t const Times[6] = {
+		Timestamp1 - Timestamp0, Timestamp2 - Timestamp1, Timestamp3 - Timestamp2,
+		Timestamp4 - Timestamp3, Timestamp5 - Timestamp4, Timestamp6 - Timestamp5};
+	char const * Names[6] = {
+		"packHalf1x16[scalar]", "packHalf1x16[span]", "unpackHalf1x16[scalar]",
+		"unpackHalf1x16[span]", "packSnorm1x16[scalar]", "packSnorm1x16[span]"};
+	for(int i = 0; i < 6; ++i)
+		printf("%s: %d clocks, %.0f M/s\n", Names[i], static_cast<int>(Times[i]), Times[i] > 0 ? Scale / Times[i] : 0.0);
+
+	return 0;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_packHalf();
+	Error += test_unpackHalf();
+	Error += test_packNorm();
+	Error += test_unpackNorm();
+	Error += test_packUnorm4x8();
+	Error += perf();
+
+	return Error;
+}
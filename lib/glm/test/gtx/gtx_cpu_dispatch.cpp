@@ -0,0 +1,275 @@
+#include <glm/gtx/cpu_dispatch.hpp>
+#include <glm/gtc/epsilon.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+static char const * path_name(glm::dispatch_path Path)
+{
+	switch(Path)
+	{
+	case glm::dispatch_pure:
+		return "pure";
+	case glm::dispatch_sse2:
+		return "sse2";
+	case glm::dispatch_avx2:
+		return "avx2";
+	default:
+		return "unknown";
+	}
+}
+
+static glm::dispatch_path const Paths[] = {glm::dispatch_pure, glm::dispatch_sse2, glm::dispatch_avx2};
+static std::size_t const PathCount = sizeof(Paths) / sizeof(Paths[0]);
+
+static bool equal(glm::vec4 const & a, glm::vec4 const & b, float Epsilon)
+{
+	return glm::all(glm::epsilonEqual(a, b, glm::max(glm::length(b), 1.0f) * Epsilon));
+}
+
+static bool equal(glm::mat4 const & a, glm::mat4 const & b, float Epsilon)
+{
+	bool Result = true;
+	for(glm::length_t i = 0; i < 4; ++i)
+		Result = Result && equal(a[i], b[i], Epsilon);
+	return Result;
+}
+
+// The binary runs, so the CPU supports at least the instruction sets it was built for
+static int test_cpuArch()
+{
+	int Error = 0;
+
+	Error += (glm::cpuArch() & GLM_ARCH) == GLM_ARCH ? 0 : 1;
+	Error += glm::isDispatchPathSupported(glm::dispatch_pure) ? 0 : 1;
+
+	// The default is the fastest supported path
+	glm::dispatch_path const Default = glm::getDispatchPath();
+	Error += glm::isDispatchPathSupported(Default) ? 0 : 1;
+	for(std::size_t p = Default + 1; p < PathCount; ++p)
+		Error += glm::isDispatchPathSupported(Paths[p]) ? 1 : 0;
+
+	std::printf("cpuArch: 0x%x, default path: %s\n", glm::cpuArch(), path_name(Default));
+
+	return Error;
+}
+
+static int test_setDispatchPath()
+{
+	int Error = 0;
+
+	glm::dispatch_path const Default = glm::getDispatchPath();
+	for(std::size_t p = 0; p < PathCount; ++p)
+	{
+		bool const Supported = glm::isDispatchPathSupported(Paths[p]);
+		Error += glm::setDispatchPath(Paths[p]) == Supported ? 0 : 1;
+		Error += glm::getDispatchPath() == (Supported ? Paths[p] : glm::dispatch_pure) ? 0 : 1;
+		glm::setDispatchPath(glm::dispatch_pure);
+	}
+	Error += glm::setDispatchPath(Default) ? 0 : 1;
+
+	return Error;
+}
+
+static std::vector<glm::mat4> sample_matrices()
+{
+	std::vector<glm::mat4> Result;
+	for(int i = 0; i < 64; ++i)
+	{
+		float const f = static_cast<float>(i);
+		glm::mat4 m = glm::translate(glm::mat4(), glm::vec3(f, -2.0f * f, 0.5f * f));
+		m = glm::rotate(m, 0.1f * f, glm::normalize(glm::vec3(1.0f, f, 2.0f)));
+		m = glm::scale(m, glm::vec3(1.0f + 0.25f * f, 2.0f, 0.5f + 0.125f * f));
+		Result.push_back(m);
+	}
+	Result.push_back(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+	Result.push_back(glm::lookAt(glm::vec3(1, 2, 3), glm::vec3(0), glm::vec3(0, 1, 0)));
+	return Result;
+}
+
+// Each supported path is forced and compared to the core functions
+static int test_matrix_paths()
+{
+	int Error = 0;
+
+	std::vector<glm::mat4> const Matrices = sample_matrices();
+	glm::dispatch_path const Default = glm::getDispatchPath();
+	for(std::size_t p = 0; p < PathCount; ++p)
+	{
+		if(!glm::setDispatchPath(Paths[p]))
+			continue;
+
+		for(std::size_t i = 0; i < Matrices.size(); ++i)
+		{
+			glm::mat4 const & a = Matrices[i];
+			glm::mat4 const & b = Matrices[(i + 1) % Matrices.size()];
+			Error += equal(glm::dispatchMul(a, b), a * b, 1e-5f) ? 0 : 1;
+			Error += equal(glm::dispatchInverse(a), glm::inverse(a), 1e-4f) ? 0 : 1;
+			Error += equal(glm::dispatchInverse(a) * a, glm::mat4(), 1e-4f) ? 0 : 1;
+
+			float const Determinant = glm::determinant(a);
+			Error += glm::epsilonEqual(glm::dispatchDeterminant(a), Determinant, glm::max(glm::abs(Determinant), 1.0f) * 1e-5f) ? 0 : 1;
+		}
+	}
+	glm::setDispatchPath(Default);
+
+	return Error;
+}
+
+// Odd counts leave a single matrix after the pairs of the AVX2 path, in place results read before writing
+static int test_batch_paths()
+{
+	int Error = 0;
+
+	std::vector<glm::mat4> const Matrices = sample_matrices();
+	std::vector<glm::mat4> Shifted(Matrices.begin() + 1, Matrices.end());
+	Shifted.push_back(Matrices[0]);
+	glm::dispatch_path const Default = glm::getDispatchPath();
+
+	for(std::size_t p = 0; p < PathCount; ++p)
+	{
+		if(!glm::setDispatchPath(Paths[p]))
+			continue;
+
+		for(std::size_t Count = 0; Count <= Matrices.size(); Count += (Count < 5 ? 1 : 31))
+		{
+			std::vector<glm::mat4> Product(Count + 1, glm::mat4(0.0f)), Inverse(Count + 1, glm::mat4(0.0f));
+			if(Count > 0)
+			{
+				glm::dispatchMul(&Matrices[0], &Shifted[0], &Product[0], Count);
+				glm::dispatchInverse(&Matrices[0], &Inverse[0], Count);
+			}
+			for(std::size_t i = 0; i < Count; ++i)
+			{
+				Error += equal(Product[i], Matrices[i] * Shifted[i], 1e-5f) ? 0 : 1;
+				Error += equal(Inverse[i], glm::inverse(Matrices[i]), 1e-4f) ? 0 : 1;
+			}
+			Error += Product[Count] == glm::mat4(0.0f) && Inverse[Count] == glm::mat4(0.0f) ? 0 : 1;
+		}
+
+		std::vector<glm::mat4> InPlace(Matrices);
+		glm::dispatchInverse(&InPlace[0], &InPlace[0], InPlace.size());
+		glm::dispatchMul(&InPlace[0], &Matrices[0], &InPlace[0], InPlace.size());
+		for(std::size_t i = 0; i < InPlace.size(); ++i)
+			Error += equal(InPlace[i], glm::mat4(), 1e-4f) ? 0 : 1;
+	}
+	glm::setDispatchPath(Default);
+
+	return Error;
+}
+
+static int test_transform_paths()
+{
+	int Error = 0;
+
+	glm::mat4 const m = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 100.0f) * glm::lookAt(glm::vec3(1, 2, 3), glm::vec3(0), glm::vec3(0, 1, 0));
+	glm::dispatch_path const Default = glm::getDispatchPath();
+
+	// Odd counts leave a scalar tail for every SIMD width
+	std::size_t const Counts[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 1001};
+	for(std::size_t c = 0; c < sizeof(Counts) / sizeof(Counts[0]); ++c)
+	{
+		std::size_t const Count = Counts[c];
+		std::vector<float> x(Count + 1), y(Count + 1), z(Count + 1);
+		for(std::size_t i = 0; i < Count; ++i)
+		{
+			x[i] = static_cast<float>(i % 13) - 6.0f;
+			y[i] = static_cast<float>(i % 7) * 0.5f;
+			z[i] = -static_cast<float>(i % 29);
+		}
+		glm::soa_vec3 const In(&x[0], &y[0], &z[0]);
+
+		for(std::size_t p = 0; p < PathCount; ++p)
+		{
+			if(!glm::setDispatchPath(Paths[p]))
+				continue;
+
+			std::vector<float> rx(Count + 1), ry(Count + 1), rz(Count + 1), rw(Count + 1);
+			glm::dispatchTransform(m, In, glm::soa_vec4(&rx[0], &ry[0], &rz[0], &rw[0]), Count);
+			for(std::size_t i = 0; i < Count; ++i)
+				Error += equal(glm::vec4(rx[i], ry[i], rz[i], rw[i]), m * glm::vec4(x[i], y[i], z[i], 1.0f), 1e-5f) ? 0 : 1;
+			Error += rx[Count] == 0.0f && rw[Count] == 0.0f ? 0 : 1;
+
+			std::vector<float> px(Count + 1), py(Count + 1), pz(Count + 1);
+			glm::dispatchTransformPoint(m, In, glm::soa_vec3(&px[0], &py[0], &pz[0]), Count);
+			for(std::size_t i = 0; i < Count; ++i)
+				Error += equal(glm::vec4(px[i], py[i], pz[i], 0.0f), glm::vec4(rx[i], ry[i], rz[i], 0.0f), 1e-5f) ? 0 : 1;
+			Error += pz[Count] == 0.0f ? 0 : 1;
+		}
+	}
+	glm::setDispatchPath(Default);
+
+	return Error;
+}
+
+static int perf()
+{
+	std::size_t const Count = 1 << 20;
+	int const Frames = 20;
+
+	std::vector<float> x(Count), y(Count), z(Count);
+	std::vector<float> rx(Count), ry(Count), rz(Count), rw(Count);
+	for(std::size_t i = 0; i < Count; ++i)
+	{
+		x[i] = static_cast<float>(i % 1000);
+		y[i] = static_cast<float>(i % 100);
+		z[i] = static_cast<float>(i % 10);
+	}
+	glm::mat4 const m = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 100.0f);
+
+	// Batches of matrices staying in the L1 cache, as a scene graph update would process them
+	std::size_t const Batch = 64;
+	std::vector<glm::mat4> const Samples = sample_matrices();
+	std::vector<glm::mat4> const Left(Samples.begin(), Samples.begin() + Batch);
+	std::vector<glm::mat4> const Right(Samples.rbegin(), Samples.rbegin() + Batch);
+	std::vector<glm::mat4> Product(Batch);
+
+	glm::dispatch_path const Default = glm::getDispatchPath();
+	for(std::size_t p = 0; p < PathCount; ++p)
+	{
+		if(!glm::setDispatchPath(Paths[p]))
+			continue;
+
+		std::clock_t const Timestamp0 = std::clock();
+
+		for(int Frame = 0; Frame < Frames; ++Frame)
+			glm::dispatchTransform(m, glm::soa_vec3(&x[0], &y[0], &z[0]), glm::soa_vec4(&rx[0], &ry[0], &rz[0], &rw[0]), Count);
+
+		std::clock_t const Timestamp1 = std::clock();
+
+		for(std::size_t i = 0; i < Count; i += Batch)
+			glm::dispatchMul(&Left[0], &Right[0], &Product[0], Batch);
+
+		std::clock_t const Timestamp2 = std::clock();
+
+		for(std::size_t i = 0; i < Count; i += Batch)
+			glm::dispatchInverse(&Left[0], &Product[0], Batch);
+
+		std::clock_t const Timestamp3 = std::clock();
+
+		std::clock_t const Times[3] = {Timestamp1 - Timestamp0, Timestamp2 - Timestamp1, Timestamp3 - Timestamp2};
+		double const Vertices = static_cast<double>(Count) * Frames / 1e6 * CLOCKS_PER_SEC;
+		double const Matrices = static_cast<double>(Count) / 1e6 * CLOCKS_PER_SEC;
+		std::printf("cpu_dispatch transform[%s]: %d clocks, %.0f M vertices/s\n", path_name(Paths[p]), static_cast<int>(Times[0]), Times[0] > 0 ? Vertices / Times[0] : 0.0);
+		std::printf("cpu_dispatch mul[%s]: %d clocks, %.1f M matrices/s\n", path_name(Paths[p]), static_cast<int>(Times[1]), Times[1] > 0 ? Matrices / Times[1] : 0.0);
+		std::printf("cpu_dispatch inverse[%s]: %d clocks, %.1f M matrices/s\n", path_name(Paths[p]), static_cast<int>(Times[2]), Times[2] > 0 ? Matrices / Times[2] : 0.0);
+	}
+	glm::setDispatchPath(Default);
+
+	return 0;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_cpuArch();
+	Error += test_setDispatchPath();
+	Error += test_matrix_paths();
+	Error += test_batch_paths();
+	Error += test_transform_paths();
+	Error += perf();
+
+	return Error;
+}
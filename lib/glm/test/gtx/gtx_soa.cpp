@@ -0,0 +1,242 @@
+#include <glm/gtx/soa.hpp>
+#include <glm/gtc/epsilon.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+struct stream
+{
+	explicit stream(std::size_t Count) :
+		x(Count), y(Count), z(Count), w(Count)
+	{}
+
+	glm::soa_vec3 xyz()
+	{
+		return glm::soa_vec3(&x[0], &y[0], &z[0]);
+	}
+
+	glm::soa_vec4 xyzw()
+	{
+		return glm::soa_vec4(&x[0], &y[0], &z[0], &w[0]);
+	}
+
+	glm::vec3 get(std::size_t i) const
+	{
+		return glm::vec3(x[i], y[i], z[i]);
+	}
+
+	glm::vec4 get4(std::size_t i) const
+	{
+		return glm::vec4(x[i], y[i], z[i], w[i]);
+	}
+
+	std::vector<float> x, y, z, w;
+};
+
+// Deterministic values in [-Range, Range]
+static void fill(stream & s, unsigned Seed, float Range)
+{
+	for(std::size_t i = 0; i < s.x.size(); ++i)
+	{
+		Seed = Seed * 1664525u + 1013904223u;
+		s.x[i] = (static_cast<float>(Seed >> 8) / 16777216.0f * 2.0f - 1.0f) * Range;
+		Seed = Seed * 1664525u + 1013904223u;
+		s.y[i] = (static_cast<float>(Seed >> 8) / 16777216.0f * 2.0f - 1.0f) * Range;
+		Seed = Seed * 1664525u + 1013904223u;
+		s.z[i] = (static_cast<float>(Seed >> 8) / 16777216.0f * 2.0f - 1.0f) * Range;
+		s.w[i] = static_cast<float>(Seed >> 8) / 16777216.0f;
+	}
+}
+
+static bool equal(glm::vec3 const & a, glm::vec3 const & b)
+{
+	return glm::all(glm::epsilonEqual(a, b, glm::max(glm::length(b), 1.0f) * 1e-5f));
+}
+
+static bool equal(glm::vec4 const & a, glm::vec4 const & b)
+{
+	return glm::all(glm::epsilonEqual(a, b, glm::max(glm::length(b), 1.0f) * 1e-5f));
+}
+
+// Odd counts leave a scalar tail for every SIMD width
+static int test_functions()
+{
+	int Error = 0;
+
+	std::size_t const Counts[] = {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 1001};
+	for(std::size_t c = 0; c < sizeof(Counts) / sizeof(Counts[0]); ++c)
+	{
+		std::size_t const Count = Counts[c];
+		stream a(Count + 1), b(Count + 1), r(Count + 1);
+		fill(a, 1, 10.0f);
+		fill(b, 2, 10.0f);
+		glm::mat4 const m = glm::rotate(glm::translate(glm::mat4(), glm::vec3(1, 2, 3)), 0.5f, glm::vec3(0, 1, 0));
+
+		glm::dot(a.xyz(), b.xyz(), &r.x[0], Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += glm::epsilonEqual(r.x[i], glm::dot(a.get(i), b.get(i)), 1e-3f) ? 0 : 1;
+
+		glm::length(a.xyz(), &r.x[0], Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += glm::epsilonEqual(r.x[i], glm::length(a.get(i)), 1e-4f) ? 0 : 1;
+
+		glm::cross(a.xyz(), b.xyz(), r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), glm::cross(a.get(i), b.get(i))) ? 0 : 1;
+
+		glm::normalize(a.xyz(), r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), glm::normalize(a.get(i))) ? 0 : 1;
+
+		glm::mix(a.xyz(), b.xyz(), 0.25f, r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), glm::mix(a.get(i), b.get(i), 0.25f)) ? 0 : 1;
+
+		glm::mix(a.xyz(), b.xyz(), &a.w[0], r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), glm::mix(a.get(i), b.get(i), a.w[i])) ? 0 : 1;
+
+		glm::addScaled(a.xyz(), b.xyz(), 0.016f, r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), a.get(i) + b.get(i) * 0.016f) ? 0 : 1;
+
+		glm::transformPoint(m, a.xyz(), r.xyz(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get(i), glm::vec3(m * glm::vec4(a.get(i), 1.0f))) ? 0 : 1;
+
+		glm::transform(m, a.xyz(), r.xyzw(), Count);
+		for(std::size_t i = 0; i < Count; ++i)
+			Error += equal(r.get4(i), m * glm::vec4(a.get(i), 1.0f)) ? 0 : 1;
+
+		// The element past Count is never written
+		Error += r.x[Count] == 0.0f && r.w[Count] == 0.0f ? 0 : 1;
+	}
+
+	return Error;
+}
+
+static int test_in_place()
+{
+	int Error = 0;
+
+	std::size_t const Count = 37;
+	stream a(Count), Reference(Count);
+	fill(a, 3, 5.0f);
+	Reference = a;
+
+	glm::normalize(a.xyz(), a.xyz(), Count);
+	for(std::size_t i = 0; i < Count; ++i)
+		Error += equal(a.get(i), glm::normalize(Reference.get(i))) ? 0 : 1;
+
+	return Error;
+}
+
+// Particle update: velocities steered towards a target direction, positions integrated
+static int perf_particles()
+{
+	std::size_t const Count = 1 << 20;
+	int const Frames = 20;
+	float const DeltaTime = 0.016f;
+
+	stream Position(Count), Velocity(Count), Target(Count);
+	fill(Position, 4, 100.0f);
+	fill(Velocity, 5, 1.0f);
+	fill(Target, 6, 1.0f);
+	std::vector<glm::vec3> PositionAoS(Count), VelocityAoS(Count), TargetAoS(Count);
+	for(std::size_t i = 0; i < Count; ++i)
+	{
+		PositionAoS[i] = Position.get(i);
+		VelocityAoS[i] = Velocity.get(i);
+		TargetAoS[i] = Target.get(i);
+	}
+
+	std::clock_t const Timestamp0 = std::clock();
+
+	for(int Frame = 0; Frame < Frames; ++Frame)
+	for(std::size_t i = 0; i < Count; ++i)
+	{
+		VelocityAoS[i] = glm::mix(VelocityAoS[i], glm::normalize(TargetAoS[i]), 0.1f);
+		PositionAoS[i] += VelocityAoS[i] * DeltaTime;
+	}
+
+	std::clock_t const Timestamp1 = std::clock();
+
+	for(int Frame = 0; Frame < Frames; ++Frame)
+	{
+		glm::normalize(Target.xyz(), Target.xyz(), Count);
+		glm::mix(Velocity.xyz(), Target.xyz(), 0.1f, Velocity.xyz(), Count);
+		glm::addScaled(Position.xyz(), Velocity.xyz(), DeltaTime, Position.xyz(), Count);
+	}
+
+	std::clock_t const Timestamp2 = std::clock();
+
+	std::printf("soa particles[aos]: %d clocks\n", static_cast<int>(Timestamp1 - Timestamp0));
+	std::printf("soa particles[soa]: %d clocks\n", static_cast<int>(Timestamp2 - Timestamp1));
+
+	return equal(Position.get(Count / 2), PositionAoS[Count / 2]) ? 0 : 1;
+}
+
+// Culling: bounding sphere centers to view space, then a depth and side plane test
+static int perf_culling()
+{
+	std::size_t const Count = 1 << 20;
+	int const Frames = 20;
+
+	stream Center(Count), View(Count), Normal(Count);
+	fill(Center, 7, 200.0f);
+	glm::mat4 const ViewMatrix = glm::lookAt(glm::vec3(0, 10, 0), glm::vec3(1, 10, -1), glm::vec3(0, 1, 0));
+	glm::vec3 const Plane = glm::normalize(glm::vec3(0.8f, 0.0f, -0.6f));
+	for(std::size_t i = 0; i < Count; ++i)
+	{
+		Normal.x[i] = Plane.x;
+		Normal.y[i] = Plane.y;
+		Normal.z[i] = Plane.z;
+	}
+	std::vector<float> Distance(Count);
+
+	std::size_t VisibleAoS = 0, VisibleSoA = 0;
+	std::clock_t const Timestamp0 = std::clock();
+
+	for(int Frame = 0; Frame < Frames; ++Frame)
+	{
+		VisibleAoS = 0;
+		for(std::size_t i = 0; i < Count; ++i)
+		{
+			glm::vec3 const p = glm::vec3(ViewMatrix * glm::vec4(Center.get(i), 1.0f));
+			VisibleAoS += p.z < -0.1f && glm::dot(p, Plane) < 1.0f ? 1 : 0;
+		}
+	}
+
+	std::clock_t const Timestamp1 = std::clock();
+
+	for(int Frame = 0; Frame < Frames; ++Frame)
+	{
+		glm::transformPoint(ViewMatrix, Center.xyz(), View.xyz(), Count);
+		glm::dot(View.xyz(), Normal.xyz(), &Distance[0], Count);
+		VisibleSoA = 0;
+		for(std::size_t i = 0; i < Count; ++i)
+			VisibleSoA += View.z[i] < -0.1f && Distance[i] < 1.0f ? 1 : 0;
+	}
+
+	std::clock_t const Timestamp2 = std::clock();
+
+	std::printf("soa culling[aos]: %d clocks\n", static_cast<int>(Timestamp1 - Timestamp0));
+	std::printf("soa culling[soa]: %d clocks\n", static_cast<int>(Timestamp2 - Timestamp1));
+
+	// Spheres right on a plane may go either way with a different rounding
+	std::size_t const Difference = VisibleAoS > VisibleSoA ? VisibleAoS - VisibleSoA : VisibleSoA - VisibleAoS;
+	return Difference <= Count / 10000 ? 0 : 1;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_functions();
+	Error += test_in_place();
+	Error += perf_particles();
+	Error += perf_culling();
+
+	return Error;
+}
@@ -0,0 +1,79 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box
+struct AABB
+{
+    glm::vec3 min{ 0.0f };
+    glm::vec3 max{ 0.0f };
+
+    AABB() = default;
+
+    AABB(const glm::vec3& minPoint, const glm::vec3& maxPoint) : min(minPoint), max(maxPoint)
+    {
+    }
+
+    glm::vec3 GetCenter() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 GetExtents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    bool Contains(const glm::vec3& point) const
+    {
+        return glm::all(glm::greaterThanEqual(point, min)) && glm::all(glm::lessThanEqual(point, max));
+    }
+
+    // Box enclosing this box after an affine transform
+    AABB Transform(const glm::mat4& m) const
+    {
+        glm::vec3 center = glm::vec3(m * glm::vec4(GetCenter(), 1.0f));
+        glm::vec3 extents = GetExtents();
+        glm::vec3 worldExtents = glm::abs(glm::vec3(m[0])) * extents.x + glm::abs(glm::vec3(m[1])) * extents.y + glm::abs(glm::vec3(m[2])) * extents.z;
+        return AABB(center - worldExtents, center + worldExtents);
+    }
+};
+
+// Six planes (left, right, bottom, top, near, far) facing inwards, xyz normalized
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    Frustum() = default;
+
+    // Extracted from the rows of a projection * view matrix, the planes are in world space
+    explicit Frustum(const glm::mat4& viewProjection)
+    {
+        glm::mat4 m = glm::transpose(viewProjection);
+        planes[0] = m[3] + m[0];
+        planes[1] = m[3] - m[0];
+        planes[2] = m[3] + m[1];
+        planes[3] = m[3] - m[1];
+        planes[4] = m[3] + m[2];
+        planes[5] = m[3] - m[2];
+        for (auto& plane: planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Conservative: false only when the box is fully outside one plane
+    bool Intersects(const AABB& box) const
+    {
+        glm::vec3 center = box.GetCenter();
+        glm::vec3 extents = box.GetExtents();
+        for (auto& plane: planes)
+        {
+            glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extents) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif //BOUNDS_HPP
@@ -1,12 +1,17 @@
 #ifndef __CAMERA_HPP_
 #define __CAMERA_HPP_
 
+#include <cmath>
+#include <cstdint>
 #include <vector>
 
 // GL Includes
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Bounds.hpp"
 
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
@@ -23,51 +28,150 @@ const GLfloat PITCH = 0.0f;
 const GLfloat SPEED = 3.0f;
 const GLfloat SENSITIVTY = 0.25f;
 const GLfloat ZOOM = 45.0f;
+const GLfloat ASPECT = 4.0f / 3.0f;
+const GLfloat NEAR_PLANE = 0.1f;
+const GLfloat FAR_PLANE = 100.0f;
+// Time in seconds for the smoothed orientation and position to catch up with the input, 0 follows it directly
+const GLfloat ROTATION_SMOOTHING = 0.04f;
+const GLfloat MOVEMENT_SMOOTHING = 0.12f;
 
+// Moves value towards target as a critically damped spring, the fastest approach without overshoot. Exact for any
+// step, so the result only depends on the total time when the target holds still.
+template <typename T>
+void CriticallyDamped(T& value, T& velocity, const T& target, GLfloat smoothTime, GLfloat deltaTime)
+{
+    if (smoothTime <= 0.0f)
+    {
+        value = target;
+        velocity = T(0.0f);
+        return;
+    }
+    const GLfloat omega = 2.0f / smoothTime;
+    const GLfloat decay = std::exp(-omega * deltaTime);
+    const T change = value - target;
+    const T temp = (velocity + omega * change) * deltaTime;
+    velocity = (velocity - omega * temp) * decay;
+    value = target + (change + temp) * decay;
+}
 
-// An abstract camera class that processes input and calculates the corresponding Eular Angles, Vectors and Matrices for use in OpenGL
+// An abstract camera class that processes input and calculates the corresponding Eular Angles, Vectors and Matrices for use in OpenGL.
+// Input only moves the target yaw, pitch and position. Step() advances the smoothed camera towards them by a fixed time
+// step and keeps the previous step, the rendered camera is interpolated between the two so the motion stays even at
+// any frame rate. The orientation is a quaternion, the basis vectors are read from it without trigonometry.
+// Every change of the rendered camera bumps the version, the matrices are only rebuilt when they are asked for after
+// a change, so a still camera costs nothing.
 class Camera
 {
 
     // Camera Attributes
     glm::vec3 Position;
-    glm::vec3 Front;
-    glm::vec3 Up;
-    glm::vec3 Right;
+    glm::quat Orientation;
     glm::vec3 WorldUp;
-    // Eular Angles
+    // Input targets and spring velocities
+    glm::vec3 TargetPosition;
+    glm::vec3 PositionVelocity;
+    glm::vec2 TargetAngles;
+    glm::vec2 AngleVelocity;
+    // Eular Angles, smoothed
     GLfloat Yaw;
     GLfloat Pitch;
+    // State of the previous step and the rendered state interpolated from both
+    glm::vec3 PreviousPosition;
+    glm::quat PreviousOrientation;
+    glm::vec3 RenderPosition;
+    glm::quat RenderOrientation;
     // Camera options
     GLfloat MovementSpeed;
     GLfloat MouseSensitivity;
+    GLfloat RotationSmoothing;
+    GLfloat MovementSmoothing;
     GLfloat Zoom;
+    // Projection options
+    GLfloat Aspect;
+    GLfloat ZNear;
+    GLfloat ZFar;
+
+    // Incremented on every change
+    std::uint64_t Version;
+    // Version of the cached matrices, projection only changes with zoom and the projection options
+    std::uint64_t MatricesVersion;
+    std::uint64_t ProjectionVersion;
+    std::uint64_t CachedProjectionVersion;
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::mat4 ViewProjection;
+    glm::mat4 InverseView;
+    glm::mat4 InverseProjection;
+    glm::mat4 InverseViewProjection;
+    Frustum ViewFrustum;
 
 public:
 
     // Constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM)
+    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH) : MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY),
+        RotationSmoothing(ROTATION_SMOOTHING), MovementSmoothing(MOVEMENT_SMOOTHING), Zoom(ZOOM), Aspect(ASPECT), ZNear(NEAR_PLANE), ZFar(FAR_PLANE), Version(1), MatricesVersion(0), ProjectionVersion(1), CachedProjectionVersion(0)
     {
-        this->Position = position;
         this->WorldUp = up;
-        this->Yaw = yaw;
-        this->Pitch = pitch;
-        this->updateCameraVectors();
+        this->reset(position, yaw, pitch);
     }
     // Constructor with scalar values
-    Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM)
+    Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch) : MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY),
+        RotationSmoothing(ROTATION_SMOOTHING), MovementSmoothing(MOVEMENT_SMOOTHING), Zoom(ZOOM), Aspect(ASPECT), ZNear(NEAR_PLANE), ZFar(FAR_PLANE), Version(1), MatricesVersion(0), ProjectionVersion(1), CachedProjectionVersion(0)
     {
-        this->Position = glm::vec3(posX, posY, posZ);
         this->WorldUp = glm::vec3(upX, upY, upZ);
-        this->Yaw = yaw;
-        this->Pitch = pitch;
-        this->updateCameraVectors();
+        this->reset(glm::vec3(posX, posY, posZ), yaw, pitch);
+    }
+
+    // Returns the view matrix of the rendered position and orientation
+    const glm::mat4& GetViewMatrix()
+    {
+        this->updateMatrices();
+        return this->View;
+    }
+
+    // Perspective projection from Zoom and the projection options
+    const glm::mat4& GetProjectionMatrix()
+    {
+        this->updateMatrices();
+        return this->Projection;
+    }
+
+    const glm::mat4& GetViewProjectionMatrix()
+    {
+        this->updateMatrices();
+        return this->ViewProjection;
+    }
+
+    const glm::mat4& GetInverseViewMatrix()
+    {
+        this->updateMatrices();
+        return this->InverseView;
+    }
+
+    const glm::mat4& GetInverseProjectionMatrix()
+    {
+        this->updateMatrices();
+        return this->InverseProjection;
+    }
+
+    const glm::mat4& GetInverseViewProjectionMatrix()
+    {
+        this->updateMatrices();
+        return this->InverseViewProjection;
     }
 
-    // Returns the view matrix calculated using Eular Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix()
+    // World space planes of the view projection
+    const Frustum& GetFrustum()
     {
-        return glm::lookAt(this->Position, this->Position + this->Front, this->Up);
+        this->updateMatrices();
+        return this->ViewFrustum;
+    }
+
+    // Changes with every change of position, angles, zoom or projection options, so results derived from the camera
+    // can be kept while it holds still
+    std::uint64_t GetVersion() const
+    {
+        return this->Version;
     }
 
     GLfloat GetZoom() const
@@ -75,67 +179,199 @@ public:
         return this->Zoom;
     }
 
+    // Rendered position
+    const glm::vec3& GetPosition() const
+    {
+        return this->RenderPosition;
+    }
+
+    const glm::quat& GetOrientation() const
+    {
+        return this->RenderOrientation;
+    }
+
+    glm::vec3 GetFront() const
+    {
+        return this->RenderOrientation * glm::vec3(0.0f, 0.0f, -1.0f);
+    }
+
+    // Moves the camera without smoothing
+    void SetPosition(const glm::vec3& position)
+    {
+        if (position == this->RenderPosition && position == this->TargetPosition)
+            return;
+        this->TargetPosition = this->Position = this->PreviousPosition = this->RenderPosition = position;
+        this->PositionVelocity = glm::vec3(0.0f);
+        this->Version++;
+    }
+
+    void SetPerspective(GLfloat aspect, GLfloat zNear, GLfloat zFar)
+    {
+        if (aspect == this->Aspect && zNear == this->ZNear && zFar == this->ZFar)
+            return;
+        this->Aspect = aspect;
+        this->ZNear = zNear;
+        this->ZFar = zFar;
+        this->Version++;
+        this->ProjectionVersion++;
+    }
+
+    GLfloat GetAspect() const
+    {
+        return this->Aspect;
+    }
+
+    GLfloat GetNear() const
+    {
+        return this->ZNear;
+    }
+
+    GLfloat GetFar() const
+    {
+        return this->ZFar;
+    }
+
+    // Smoothing times in seconds, 0 to follow the input directly
+    void SetSmoothing(GLfloat rotation, GLfloat movement)
+    {
+        this->RotationSmoothing = rotation;
+        this->MovementSmoothing = movement;
+    }
+
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
+    // Moves the target along the direction the input aims at, call it with the fixed time step before Step().
     void ProcessKeyboard(Camera_Movement direction, GLfloat deltaTime)
     {
         GLfloat velocity = this->MovementSpeed * deltaTime;
+        if (velocity == 0.0f)
+            return;
+        const glm::quat target = this->orientationFromAngles(this->TargetAngles.x, this->TargetAngles.y);
+        const glm::vec3 front = target * glm::vec3(0.0f, 0.0f, -1.0f);
+        const glm::vec3 right = target * glm::vec3(1.0f, 0.0f, 0.0f);
         if (direction == FORWARD)
-            this->Position += this->Front * velocity;
+            this->TargetPosition += front * velocity;
         if (direction == BACKWARD)
-            this->Position -= this->Front * velocity;
+            this->TargetPosition -= front * velocity;
         if (direction == LEFT)
-            this->Position -= this->Right * velocity;
+            this->TargetPosition -= right * velocity;
         if (direction == RIGHT)
-            this->Position += this->Right * velocity;
+            this->TargetPosition += right * velocity;
     }
 
     // Processes input received from a mouse input system. Expects the offset value in both the x and y direction.
+    // Only the target angles change here, the camera turns towards them in Step().
     void ProcessMouseMovement(GLfloat xoffset, GLfloat yoffset, GLboolean constrainPitch = true)
     {
         xoffset *= this->MouseSensitivity;
         yoffset *= this->MouseSensitivity;
 
-        this->Yaw += xoffset;
-        this->Pitch += yoffset;
+        this->TargetAngles.x += xoffset;
+        this->TargetAngles.y += yoffset;
 
         // Make sure that when pitch is out of bounds, screen doesn't get flipped
         if (constrainPitch)
-        {
-            if (this->Pitch > 89.0f)
-                this->Pitch = 89.0f;
-            if (this->Pitch < -89.0f)
-                this->Pitch = -89.0f;
-        }
-
-        // Update Front, Right and Up Vectors using the updated Eular angles
-        this->updateCameraVectors();
+            this->TargetAngles.y = glm::clamp(this->TargetAngles.y, -89.0f, 89.0f);
     }
 
     // Processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
     void ProcessMouseScroll(GLfloat yoffset)
     {
+        GLfloat zoom = this->Zoom;
         if (this->Zoom >= 1.0f && this->Zoom <= 45.0f)
             this->Zoom -= yoffset;
         if (this->Zoom <= 1.0f)
             this->Zoom = 1.0f;
         if (this->Zoom >= 45.0f)
             this->Zoom = 45.0f;
+        if (this->Zoom != zoom)
+        {
+            this->Version++;
+            this->ProjectionVersion++;
+        }
+    }
+
+    // Advances the smoothed camera by one fixed time step
+    void Step(GLfloat deltaTime)
+    {
+        this->PreviousPosition = this->Position;
+        this->PreviousOrientation = this->Orientation;
+
+        glm::vec2 angles(this->Yaw, this->Pitch);
+        CriticallyDamped(angles, this->AngleVelocity, this->TargetAngles, this->RotationSmoothing, deltaTime);
+        CriticallyDamped(this->Position, this->PositionVelocity, this->TargetPosition, this->MovementSmoothing, deltaTime);
+
+        // Settled, so a camera at rest stops producing new versions
+        const GLfloat EPSILON = 1e-4f;
+        if (glm::all(glm::lessThan(glm::abs(angles - this->TargetAngles), glm::vec2(EPSILON))) && glm::all(glm::lessThan(glm::abs(this->AngleVelocity), glm::vec2(EPSILON))))
+        {
+            angles = this->TargetAngles;
+            this->AngleVelocity = glm::vec2(0.0f);
+        }
+        if (glm::all(glm::lessThan(glm::abs(this->Position - this->TargetPosition), glm::vec3(EPSILON))) && glm::all(glm::lessThan(glm::abs(this->PositionVelocity), glm::vec3(EPSILON))))
+        {
+            this->Position = this->TargetPosition;
+            this->PositionVelocity = glm::vec3(0.0f);
+        }
+        if (angles.x != this->Yaw || angles.y != this->Pitch)
+        {
+            this->Yaw = angles.x;
+            this->Pitch = angles.y;
+            this->Orientation = this->orientationFromAngles(this->Yaw, this->Pitch);
+        }
+    }
+
+    // Renders the camera alpha (0 to 1) of the way from the previous step to the current one
+    void SetInterpolation(GLfloat alpha)
+    {
+        const glm::vec3 position = glm::mix(this->PreviousPosition, this->Position, alpha);
+        const glm::quat orientation = glm::slerp(this->PreviousOrientation, this->Orientation, alpha);
+        if (position == this->RenderPosition && orientation == this->RenderOrientation)
+            return;
+        this->RenderPosition = position;
+        this->RenderOrientation = orientation;
+        this->Version++;
     }
 
 private:
-    // Calculates the front vector from the Camera's (updated) Eular Angles
-    void updateCameraVectors()
-    {
-        // Calculate the new Front vector
-        glm::vec3 front;
-        front.x = cos(glm::radians(this->Yaw)) * cos(glm::radians(this->Pitch));
-        front.y = sin(glm::radians(this->Pitch));
-        front.z = sin(glm::radians(this->Yaw)) * cos(glm::radians(this->Pitch));
-        this->Front = glm::normalize(front);
-        // Also re-calculate the Right and Up vector
-        this->Right = glm::normalize(glm::cross(this->Front, this->WorldUp));  // Normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
-        this->Up = glm::normalize(glm::cross(this->Right, this->Front));
+    void reset(const glm::vec3& position, GLfloat yaw, GLfloat pitch)
+    {
+        this->Yaw = yaw;
+        this->Pitch = pitch;
+        this->TargetAngles = glm::vec2(yaw, pitch);
+        this->AngleVelocity = glm::vec2(0.0f);
+        this->Orientation = this->PreviousOrientation = this->RenderOrientation = this->orientationFromAngles(yaw, pitch);
+        this->Position = this->TargetPosition = this->PreviousPosition = this->RenderPosition = position;
+        this->PositionVelocity = glm::vec3(0.0f);
+    }
+
+    // Yaw about WorldUp, then pitch about the local right axis. At yaw -90 and pitch 0 the camera looks down -z.
+    glm::quat orientationFromAngles(GLfloat yaw, GLfloat pitch) const
+    {
+        return glm::angleAxis(glm::radians(-yaw - 90.0f), this->WorldUp) * glm::angleAxis(glm::radians(pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    // Rebuilds the cached matrices and frustum planes if the camera changed since the last call
+    void updateMatrices()
+    {
+        if (this->MatricesVersion == this->Version)
+            return;
+        this->MatricesVersion = this->Version;
+
+        // The inverse of a rotation is its conjugate, the view is the inverse of the camera's rigid transform
+        const glm::mat4 rotation = glm::mat4_cast(this->RenderOrientation);
+        this->InverseView = rotation;
+        this->InverseView[3] = glm::vec4(this->RenderPosition, 1.0f);
+        this->View = glm::translate(glm::mat4_cast(glm::conjugate(this->RenderOrientation)), -this->RenderPosition);
+        if (this->CachedProjectionVersion != this->ProjectionVersion)
+        {
+            this->CachedProjectionVersion = this->ProjectionVersion;
+            this->Projection = glm::perspective(this->Zoom, this->Aspect, this->ZNear, this->ZFar);
+            this->InverseProjection = glm::inverse(this->Projection);
+        }
+        this->ViewProjection = this->Projection * this->View;
+        this->InverseViewProjection = this->InverseView * this->InverseProjection;
+        this->ViewFrustum = Frustum(this->ViewProjection);
     }
 };
 
-#endif //__CAMERA_HPP_
\ No newline at end of file
+#endif //__CAMERA_HPP_
@@ -0,0 +1,231 @@
+#include "DeferredRenderer.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+DeferredRenderer::DeferredRenderer():
+    m_width{0}, m_height{0}, m_fbo{0}, m_outputFramebuffer{0}, m_textures{0, 0, 0},
+    m_emptyVAO{0}, m_volumeVAO{0}, m_volumeVBO{0}, m_volumeEBO{0}, m_instanceVBO{0}
+{
+
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteTextures(3, m_textures);
+        glDeleteVertexArrays(1, &m_emptyVAO);
+        glDeleteVertexArrays(1, &m_volumeVAO);
+        glDeleteBuffers(1, &m_volumeVBO);
+        glDeleteBuffers(1, &m_volumeEBO);
+        glDeleteBuffers(1, &m_instanceVBO);
+    }
+}
+
+bool DeferredRenderer::Init(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+
+    if (!m_geometryProgram.InitWithFiles("vertex_shader_clustered.vs", "fragment_shader_gbuffer.frag"))
+    {
+        m_error = m_geometryProgram.GetError();
+        return false;
+    }
+    if (!m_ambientProgram.InitWithFiles("vertex_shader_fullscreen.vs", "fragment_shader_deferred_ambient.frag"))
+    {
+        m_error = m_ambientProgram.GetError();
+        return false;
+    }
+    if (!m_lightProgram.InitWithFiles("vertex_shader_deferred_light.vs", "fragment_shader_deferred_light.frag"))
+    {
+        m_error = m_lightProgram.GetError();
+        return false;
+    }
+
+    static const GLenum internalFormats[3] = { GL_RGBA8, GL_RGBA16F, GL_DEPTH_COMPONENT24 };
+    static const GLenum formats[3] = { GL_RGBA, GL_RGBA, GL_DEPTH_COMPONENT };
+    static const GLenum types[3] = { GL_UNSIGNED_BYTE, GL_FLOAT, GL_FLOAT };
+    static const GLenum attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_DEPTH_ATTACHMENT };
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glGenTextures(3, m_textures);
+    for (int i = 0; i < 3; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, formats[i], types[i], nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[i], GL_TEXTURE_2D, m_textures[i], 0);
+    }
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        m_error = "G-buffer framebuffer is incomplete";
+        return false;
+    }
+
+    // Light volume: unit cube with consistent outward CCW winding so back faces can be selected
+    static const GLfloat corners[] = {
+        -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f
+    };
+    static const GLushort indices[] = {
+        0, 4, 6,  0, 6, 2,
+        1, 3, 7,  1, 7, 5,
+        0, 1, 5,  0, 5, 4,
+        2, 6, 7,  2, 7, 3,
+        0, 2, 3,  0, 3, 1,
+        4, 5, 7,  4, 7, 6
+    };
+
+    glGenVertexArrays(1, &m_emptyVAO);
+    glGenVertexArrays(1, &m_volumeVAO);
+    glBindVertexArray(m_volumeVAO);
+    {
+        glGenBuffers(1, &m_volumeVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_volumeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+
+        glGenBuffers(1, &m_volumeEBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_volumeEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        // Per light instance data: position + radius, color
+        glGenBuffers(1, &m_instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (GLvoid*)0);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (GLvoid*)sizeof(glm::vec4));
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+const std::string& DeferredRenderer::GetError() const
+{
+    return m_error;
+}
+
+GLProgram& DeferredRenderer::BeginGeometryPass(const glm::mat4& view, const glm::mat4& projection)
+{
+    m_geometryTimer.Begin();
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_outputFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_width, m_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_BLEND);
+
+    m_geometryProgram.Use();
+    GLuint program = m_geometryProgram.GetProgram();
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(glGetUniformLocation(program, "emissive"), 0.0f);
+    return m_geometryProgram;
+}
+
+void DeferredRenderer::EndGeometryPass()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+    m_geometryTimer.End();
+}
+
+void DeferredRenderer::LightingPass(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& ambientColor,
+    const ShadowMaps& shadows)
+{
+    m_lightingTimer.Begin();
+
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_ALWAYS);
+
+    glm::mat4 viewProjection = projection * view;
+    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+
+    // Ambient term, sun and emissive surfaces, one full screen triangle. It also copies the G-buffer
+    // depth into the default framebuffer so transparent geometry can be depth tested afterwards.
+    m_ambientProgram.Use();
+    GLuint ambientProgram = m_ambientProgram.GetProgram();
+    BindGBufferTextures(ambientProgram);
+    shadows.Bind(ambientProgram, 3);
+    glUniform3fv(glGetUniformLocation(ambientProgram, "ambientColor"), 1, glm::value_ptr(ambientColor));
+    glUniformMatrix4fv(glGetUniformLocation(ambientProgram, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+    glUniformMatrix4fv(glGetUniformLocation(ambientProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glBindVertexArray(m_emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    // Point lights, additive. Only back faces are drawn so every covered pixel is shaded once per
+    // light, including when the camera is inside the volume.
+    m_instances.resize(lights.size() * 2);
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        m_instances[i * 2 + 0] = glm::vec4(lights[i].position, lights[i].radius);
+        m_instances[i * 2 + 1] = glm::vec4(lights[i].color, 0.0f);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(glm::vec4), m_instances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_lightProgram.Use();
+    GLuint program = m_lightProgram.GetProgram();
+    BindGBufferTextures(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniformMatrix4fv(glGetUniformLocation(program, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+    glUniform2f(glGetUniformLocation(program, "screenSize"), GLfloat(m_width), GLfloat(m_height));
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glBindVertexArray(m_volumeVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, (GLvoid*)0, GLsizei(lights.size()));
+    glBindVertexArray(0);
+
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+
+    m_lightingTimer.End();
+}
+
+double DeferredRenderer::GetGeometryMilliseconds() const
+{
+    return m_geometryTimer.GetMilliseconds();
+}
+
+double DeferredRenderer::GetLightingMilliseconds() const
+{
+    return m_lightingTimer.GetMilliseconds();
+}
+
+void DeferredRenderer::BindGBufferTextures(GLuint program)
+{
+    static const char* samplers[3] = { "gAlbedo", "gNormal", "gDepth" };
+    for (int i = 0; i < 3; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,90 @@
+#ifndef DEFERRED_RENDERER_HPP
+#define DEFERRED_RENDERER_HPP
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLProgram.hpp"
+#include "GPUTimer.hpp"
+#include "LightClusters.hpp"
+#include "ShadowMaps.hpp"
+
+// Deferred shading path: geometry is written once into a G-buffer (albedo, normal, depth), then every
+// point light is accumulated by rasterizing its bounding volume, so fragment work scales with the
+// lit pixels instead of overdraw x lights.
+class DeferredRenderer
+{
+public:
+
+    DeferredRenderer();
+
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    bool Init(int width, int height);
+
+    const std::string& GetError() const;
+
+    // Binds the G-buffer and the geometry program with view/projection already set.
+    // Callers set "model", "objectColor" and "emissive" and draw.
+    GLProgram& BeginGeometryPass(const glm::mat4& view, const glm::mat4& projection);
+
+    void EndGeometryPass();
+
+    // Resolves the G-buffer into the framebuffer bound before the geometry pass, depth included. The sun
+    // and its shadows are applied with the ambient term.
+    void LightingPass(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& ambientColor,
+        const ShadowMaps& shadows);
+
+    double GetGeometryMilliseconds() const;
+
+    double GetLightingMilliseconds() const;
+
+private:
+
+    void BindGBufferTextures(GLuint program);
+
+private:
+
+    int m_width;
+
+    int m_height;
+
+    GLuint m_fbo;
+
+    // Bound again once the geometry pass is done, the default one or the HDR scene target
+    GLint m_outputFramebuffer;
+
+    // albedo (RGBA8, alpha = emissive), normal (RGBA16F), depth (DEPTH_COMPONENT24)
+    GLuint m_textures[3];
+
+    GLProgram m_geometryProgram;
+
+    GLProgram m_ambientProgram;
+
+    GLProgram m_lightProgram;
+
+    GLuint m_emptyVAO;
+
+    GLuint m_volumeVAO;
+
+    GLuint m_volumeVBO;
+
+    GLuint m_volumeEBO;
+
+    GLuint m_instanceVBO;
+
+    std::vector<glm::vec4> m_instances;
+
+    GPUTimer m_geometryTimer;
+
+    GPUTimer m_lightingTimer;
+
+    std::string m_error;
+};
+#endif
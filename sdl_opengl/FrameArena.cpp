@@ -0,0 +1,210 @@
+#include "FrameArena.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    std::atomic<std::uint64_t> s_nextArenaId{ 1 };
+
+    // Last arena used by this thread, saves the lookup under the lock on every allocation
+    struct ThreadCache
+    {
+        std::uint64_t arena;
+        void* threadArena;
+    };
+
+    thread_local ThreadCache s_cache = { 0, nullptr };
+}
+
+FrameArena::FrameArena(int frameCount, size_t blockSize):
+    m_id{s_nextArenaId++}, m_frameCount{std::max(frameCount, 2)}, m_blockSize{blockSize}, m_frame{0},
+    m_mallocs{0}, m_frameMallocs{0}, m_reservedBytes{0}, m_lastFrameMallocs{0}, m_lastFrameBytes{0}, m_peakFrameBytes{0}
+{
+
+}
+
+FrameArena::~FrameArena()
+{
+
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+    Region& region = GetThreadArena().frames[m_frame];
+    while (true)
+    {
+        if (region.block < region.blocks.size())
+        {
+            Block& block = region.blocks[region.block];
+            const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data.get());
+            const std::uintptr_t aligned = (base + region.offset + alignment - 1) & ~std::uintptr_t(alignment - 1);
+            if (aligned + bytes <= base + block.size)
+            {
+                region.used += aligned + bytes - (base + region.offset);
+                region.offset = aligned + bytes - base;
+                return reinterpret_cast<void*>(aligned);
+            }
+            // The rest of the block is wasted for this frame, the next one may already exist
+            region.block++;
+            region.offset = 0;
+            continue;
+        }
+
+        // Oversized requests get a block of their own, kept for the next frames like the others
+        const size_t size = std::max(m_blockSize, bytes + alignment);
+        region.blocks.push_back(Block{ std::unique_ptr<char[]>(new char[size]), size });
+        m_mallocs++;
+        m_frameMallocs++;
+        m_reservedBytes += size;
+    }
+}
+
+void FrameArena::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t used = 0;
+    for (auto& thread: m_threads)
+        used += thread->frames[m_frame].used;
+    m_lastFrameBytes = used;
+    m_peakFrameBytes = std::max(m_peakFrameBytes, used);
+    m_lastFrameMallocs = m_frameMallocs.exchange(0);
+
+    // The frame allocated frameCount frames ago is no longer in use
+    m_frame = (m_frame + 1) % m_frameCount;
+    for (auto& thread: m_threads)
+    {
+        Region& region = thread->frames[m_frame];
+        region.block = 0;
+        region.offset = 0;
+        region.used = 0;
+    }
+}
+
+int FrameArena::GetFrameCount() const
+{
+    return m_frameCount;
+}
+
+size_t FrameArena::GetLastFrameBytes() const
+{
+    return m_lastFrameBytes;
+}
+
+size_t FrameArena::GetPeakFrameBytes() const
+{
+    return m_peakFrameBytes;
+}
+
+size_t FrameArena::GetReservedBytes() const
+{
+    return m_reservedBytes;
+}
+
+size_t FrameArena::GetLastFrameMallocCount() const
+{
+    return m_lastFrameMallocs;
+}
+
+size_t FrameArena::GetMallocCount() const
+{
+    return m_mallocs;
+}
+
+FrameArena::ThreadArena& FrameArena::GetThreadArena()
+{
+    if (s_cache.arena == m_id)
+        return *static_cast<ThreadArena*>(s_cache.threadArena);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::thread::id self = std::this_thread::get_id();
+    auto found = std::find_if(m_threads.begin(), m_threads.end(), [&self](const std::unique_ptr<ThreadArena>& thread) { return thread->thread == self; });
+    if (found == m_threads.end())
+    {
+        m_threads.emplace_back(new ThreadArena());
+        m_threads.back()->thread = self;
+        m_threads.back()->frames.resize(m_frameCount);
+        found = m_threads.end() - 1;
+    }
+    s_cache.arena = m_id;
+    s_cache.threadArena = found->get();
+    return **found;
+}
+
+void FrameArena::RunBenchmark()
+{
+    const int WARMUP = 5;
+    const int FRAMES = 100;
+    const size_t LISTS = 64;
+    const size_t PACKETS = 2000;
+
+    // A typical transient record: a transform, a sort key and a few handles
+    struct Packet
+    {
+        glm::mat4 model;
+        float depth;
+        unsigned program, vao, count;
+    };
+
+    JobSystem jobs;
+    FrameArena arena;
+    std::vector<float> checksums(LISTS);
+
+    // Every job builds a list by growing a vector, as code without a known size up front does
+    auto buildList = [&](size_t list, auto&& packets)
+    {
+        for (size_t i = 0; i < PACKETS; ++i)
+        {
+            Packet packet;
+            packet.model = glm::mat4(float(i));
+            packet.depth = float(list * PACKETS + i);
+            packet.program = packet.vao = packet.count = unsigned(i);
+            packets.push_back(packet);
+        }
+        checksums[list] = packets.back().depth;
+    };
+
+    auto heapFrame = [&]()
+    {
+        jobs.ParallelFor(LISTS, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t list = begin; list < end; ++list)
+                buildList(list, std::vector<Packet>());
+        });
+    };
+    auto arenaFrame = [&]()
+    {
+        arena.BeginFrame();
+        jobs.ParallelFor(LISTS, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t list = begin; list < end; ++list)
+                buildList(list, FrameVector<Packet>(FrameAllocator<Packet>(&arena)));
+        });
+    };
+
+    std::cout << "FrameArena benchmark, " << LISTS << " lists of " << PACKETS << " packets of " << sizeof(Packet)
+        << " bytes per frame, x" << jobs.GetThreadCount() << " threads, average of " << FRAMES << " frames" << std::endl;
+
+    for (int frame = 0; frame < WARMUP; ++frame)
+        heapFrame();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame)
+        heapFrame();
+    std::cout << "  heap:  " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / FRAMES
+        << " ms" << std::endl;
+
+    for (int frame = 0; frame < WARMUP; ++frame)
+        arenaFrame();
+    const size_t warmupMallocs = arena.GetMallocCount();
+    start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame)
+        arenaFrame();
+    std::cout << "  arena: " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / FRAMES
+        << " ms, peak " << arena.GetPeakFrameBytes() / 1024 << " KB per frame, " << arena.GetReservedBytes() / 1024 << " KB reserved, "
+        << warmupMallocs << " block allocations while warming up, " << arena.GetMallocCount() - warmupMallocs << " after" << std::endl;
+}
@@ -0,0 +1,173 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Bump pointer allocator for data that lives for one frame (draw packets, sort keys, culling
+// results). Memory is never freed one allocation at a time: BeginFrame() rewinds the whole frame.
+// The arena is split per frame in flight, so what was allocated during the previous frameCount - 1
+// frames stays valid, and per thread so jobs allocate without locking. Blocks are kept across
+// frames, once the arena has grown to the peak frame there are no more heap allocations.
+class FrameArena
+{
+public:
+
+    // frameCount is 2 (double buffered) or more, blockSize the size of each heap block
+    explicit FrameArena(int frameCount = 2, size_t blockSize = 256 * 1024);
+
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Allocates from the calling thread's part of the current frame, thread safe
+    void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Ends the current frame and rewinds the oldest one for reuse. No allocation may run concurrently.
+    void BeginFrame();
+
+    int GetFrameCount() const;
+
+    // Bytes allocated during the last completed frame, all threads together
+    size_t GetLastFrameBytes() const;
+
+    size_t GetPeakFrameBytes() const;
+
+    // Size of the heap blocks owned by the arena
+    size_t GetReservedBytes() const;
+
+    // Heap blocks allocated during the last completed frame, 0 in steady state
+    size_t GetLastFrameMallocCount() const;
+
+    size_t GetMallocCount() const;
+
+    // Prints the time to build per frame vectors on the heap and in the arena, and the arena's heap use
+    static void RunBenchmark();
+
+private:
+
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    // One thread's allocations for one frame in flight
+    struct Region
+    {
+        std::vector<Block> blocks;
+        size_t block = 0;
+        size_t offset = 0;
+        size_t used = 0;
+    };
+
+    struct ThreadArena
+    {
+        std::thread::id thread;
+        std::vector<Region> frames;
+    };
+
+    ThreadArena& GetThreadArena();
+
+private:
+
+    // Identifies the arena in the per thread cache, an address could be reused by a later arena
+    const std::uint64_t m_id;
+
+    const int m_frameCount;
+
+    const size_t m_blockSize;
+
+    int m_frame;
+
+    std::mutex m_mutex;
+
+    std::vector<std::unique_ptr<ThreadArena>> m_threads;
+
+    std::atomic<size_t> m_mallocs;
+
+    std::atomic<size_t> m_frameMallocs;
+
+    std::atomic<size_t> m_reservedBytes;
+
+    size_t m_lastFrameMallocs;
+
+    size_t m_lastFrameBytes;
+
+    size_t m_peakFrameBytes;
+};
+
+// STL allocator over a FrameArena, deallocation is a no-op. Without an arena it falls back to the
+// heap so containers can be switched to an arena at run time.
+template <typename T>
+class FrameAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    FrameAllocator(FrameArena* arena = nullptr):m_arena{arena}
+    {
+
+    }
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other):m_arena{other.GetArena()}
+    {
+
+    }
+
+    T* allocate(size_t count)
+    {
+        if (m_arena)
+            return m_arena->AllocateArray<T>(count);
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        if (!m_arena)
+            ::operator delete(pointer);
+    }
+
+    FrameArena* GetArena() const
+    {
+        return m_arena;
+    }
+
+private:
+
+    FrameArena* m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.GetArena() == b.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.GetArena() != b.GetArena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+#endif
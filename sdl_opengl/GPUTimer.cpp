@@ -0,0 +1,41 @@
+#include "GPUTimer.hpp"
+
+GPUTimer::GPUTimer():m_queries{}, m_pending{}, m_current{0}, m_milliseconds{0.0}
+{
+
+}
+
+GPUTimer::~GPUTimer()
+{
+    if (m_queries[0])
+        glDeleteQueries(LATENCY, m_queries);
+}
+
+void GPUTimer::Begin()
+{
+    // Created lazily so timers can live in structures built before the GL context
+    if (!m_queries[0])
+        glGenQueries(LATENCY, m_queries);
+
+    // The slot about to be reused was issued LATENCY frames ago and is normally done by now
+    if (m_pending[m_current])
+    {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(m_queries[m_current], GL_QUERY_RESULT, &elapsed);
+        m_milliseconds = double(elapsed) / 1000000.0;
+        m_pending[m_current] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]);
+}
+
+void GPUTimer::End()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_current] = true;
+    m_current = (m_current + 1) % LATENCY;
+}
+
+double GPUTimer::GetMilliseconds() const
+{
+    return m_milliseconds;
+}
@@ -0,0 +1,38 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <GL/glew.h>
+
+// GL_TIME_ELAPSED query wrapper. Results are read a few frames late from a ring of queries so
+// timing a pass never stalls the pipeline. Timers cannot be nested (a GL restriction).
+class GPUTimer
+{
+public:
+
+    GPUTimer();
+
+    ~GPUTimer();
+
+    GPUTimer(const GPUTimer&) = delete;
+    GPUTimer& operator=(const GPUTimer&) = delete;
+
+    void Begin();
+
+    void End();
+
+    // Latest available result, 0 until the first query completes
+    double GetMilliseconds() const;
+
+    static const int LATENCY = 3;
+
+private:
+
+    GLuint m_queries[LATENCY];
+
+    bool m_pending[LATENCY];
+
+    int m_current;
+
+    double m_milliseconds;
+};
+#endif
@@ -0,0 +1,215 @@
+#include "Input.hpp"
+
+#include <algorithm>
+
+Input::Input():
+    m_eventCount{0}, m_nextEvent{0}, m_relativeMouse{false}, m_mouseDelta{0.0f}, m_oldestEvent{0}, m_frameEvents{0},
+    m_lastEventCount{0}, m_latencyCount{0}, m_latencyIndex{0}, m_lastLatency{0.0}
+{
+
+}
+
+bool Input::SetRelativeMouseMode(bool enabled)
+{
+    if (SDL_SetRelativeMouseMode(enabled ? SDL_TRUE : SDL_FALSE) != 0)
+    {
+        m_error = SDL_GetError();
+        m_relativeMouse = false;
+        return false;
+    }
+    m_relativeMouse = enabled;
+    return true;
+}
+
+bool Input::IsRelativeMouseMode() const
+{
+    return m_relativeMouse;
+}
+
+void Input::BeginFrame()
+{
+    SDL_PumpEvents();
+    m_frameEvents = 0;
+    m_keysPressed.reset();
+    m_keysReleased.reset();
+}
+
+bool Input::PollEvent(SDL_Event& event)
+{
+    while (true)
+    {
+        // The queue is read in batches until it is empty, however many events piled up
+        if (m_nextEvent == m_eventCount)
+        {
+            m_eventCount = SDL_PeepEvents(m_events, BATCH_SIZE, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+            m_nextEvent = 0;
+            if (m_eventCount <= 0)
+            {
+                m_eventCount = 0;
+                return false;
+            }
+        }
+
+        const SDL_Event& next = m_events[m_nextEvent++];
+        m_frameEvents++;
+        switch (next.type)
+        {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+            if (m_oldestEvent == 0)
+            {
+                // Timestamps are SDL_GetTicks() milliseconds, the arrival is moved back on the counter by the event's age
+                const Uint32 age = SDL_GetTicks() - next.common.timestamp;
+                const Uint64 now = SDL_GetPerformanceCounter();
+                m_oldestEvent = now - std::min<Uint64>(now - 1, Uint64(age) * SDL_GetPerformanceFrequency() / 1000);
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (next.type == SDL_MOUSEMOTION)
+        {
+            m_mouseDelta += glm::vec2(float(next.motion.xrel), -float(next.motion.yrel));
+            continue;
+        }
+        if (next.type == SDL_KEYDOWN || next.type == SDL_KEYUP)
+            RecordKey(next.key);
+        // Key up events are lost while the window is in the background
+        else if (next.type == SDL_WINDOWEVENT && next.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+        {
+            m_keysReleased |= m_keysDown;
+            m_keysDown.reset();
+        }
+        event = next;
+        return true;
+    }
+}
+
+void Input::RecordKey(const SDL_KeyboardEvent& event)
+{
+    const SDL_Scancode key = event.keysym.scancode;
+    if (key <= SDL_SCANCODE_UNKNOWN || key >= SDL_NUM_SCANCODES || event.repeat)
+        return;
+    if (event.type == SDL_KEYDOWN)
+    {
+        m_keysDown.set(key);
+        m_keysPressed.set(key);
+    }
+    else
+    {
+        m_keysDown.reset(key);
+        m_keysReleased.set(key);
+    }
+}
+
+bool Input::IsKeyDown(SDL_Scancode key) const
+{
+    return key >= 0 && key < SDL_NUM_SCANCODES && m_keysDown.test(key);
+}
+
+bool Input::WasKeyPressed(SDL_Scancode key) const
+{
+    return key >= 0 && key < SDL_NUM_SCANCODES && m_keysPressed.test(key);
+}
+
+bool Input::WasKeyReleased(SDL_Scancode key) const
+{
+    return key >= 0 && key < SDL_NUM_SCANCODES && m_keysReleased.test(key);
+}
+
+void Input::BindAction(int action, SDL_Scancode key)
+{
+    if (action < 0)
+        return;
+    if (size_t(action) >= m_actions.size())
+        m_actions.resize(action + 1);
+    m_actions[action].push_back(key);
+}
+
+void Input::ClearAction(int action)
+{
+    if (action >= 0 && size_t(action) < m_actions.size())
+        m_actions[action].clear();
+}
+
+bool Input::AnyBound(int action, const KeySet& keys) const
+{
+    if (action < 0 || size_t(action) >= m_actions.size())
+        return false;
+    for (SDL_Scancode key: m_actions[action])
+    {
+        if (key > SDL_SCANCODE_UNKNOWN && key < SDL_NUM_SCANCODES && keys.test(key))
+            return true;
+    }
+    return false;
+}
+
+bool Input::IsActionDown(int action) const
+{
+    return AnyBound(action, m_keysDown);
+}
+
+bool Input::WasActionPressed(int action) const
+{
+    return AnyBound(action, m_keysPressed);
+}
+
+bool Input::WasActionReleased(int action) const
+{
+    return AnyBound(action, m_keysReleased);
+}
+
+glm::vec2 Input::TakeMouseDelta()
+{
+    glm::vec2 delta = m_mouseDelta;
+    m_mouseDelta = glm::vec2(0.0f);
+    return delta;
+}
+
+void Input::EndFrame()
+{
+    m_lastEventCount = m_frameEvents;
+    if (m_oldestEvent == 0)
+        return;
+
+    // The swap has returned, not necessarily reached the display: this is a lower bound by up to a refresh
+    m_lastLatency = double(SDL_GetPerformanceCounter() - m_oldestEvent) * 1000.0 / double(SDL_GetPerformanceFrequency());
+    m_oldestEvent = 0;
+    m_latencies[m_latencyIndex] = m_lastLatency;
+    m_latencyIndex = (m_latencyIndex + 1) % LATENCY_FRAMES;
+    if (m_latencyCount < LATENCY_FRAMES)
+        m_latencyCount++;
+}
+
+double Input::GetLastLatencyMilliseconds() const
+{
+    return m_lastLatency;
+}
+
+double Input::GetAverageLatencyMilliseconds() const
+{
+    double sum = 0.0;
+    for (int i = 0; i < m_latencyCount; ++i)
+        sum += m_latencies[i];
+    return m_latencyCount > 0 ? sum / m_latencyCount : 0.0;
+}
+
+double Input::GetMaxLatencyMilliseconds() const
+{
+    return m_latencyCount > 0 ? *std::max_element(m_latencies, m_latencies + m_latencyCount) : 0.0;
+}
+
+int Input::GetLastEventCount() const
+{
+    return m_lastEventCount;
+}
+
+const std::string& Input::GetError() const
+{
+    return m_error;
+}
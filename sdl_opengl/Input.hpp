@@ -0,0 +1,126 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+// Drains the SDL event queue once per frame, right before the frame samples its input. Mouse
+// motion is not handed out event by event: the relative motion (xrel/yrel) of all events since the
+// last frame is summed into one delta. Every input event is stamped on arrival, the age of the
+// oldest one when the frame that consumed it is presented is the input latency.
+//
+// Keys are tracked by scancode (the physical key, a bounded range unlike keycodes) in bitsets of
+// keys down and keys pressed or released during the current frame. Actions are caller defined ids
+// bound to one or more keys, so polling costs one lookup per binding.
+class Input
+{
+public:
+
+    Input();
+
+    Input(const Input&) = delete;
+    Input& operator=(const Input&) = delete;
+
+    // Relative mode hides the cursor and keeps reporting motion at the window edges. Returns false
+    // when the platform has no relative mode, motion is then taken from the cursor instead.
+    bool SetRelativeMouseMode(bool enabled);
+
+    bool IsRelativeMouseMode() const;
+
+    // Fetches everything the platform has queued and starts a new frame of key edges, call once
+    // per frame before PollEvent()
+    void BeginFrame();
+
+    // Next event that is not mouse motion, false once the queue is empty. Key events are recorded
+    // in the key state before they are returned.
+    bool PollEvent(SDL_Event& event);
+
+    bool IsKeyDown(SDL_Scancode key) const;
+
+    // Went down or up during this frame, both may be true for a short tap
+    bool WasKeyPressed(SDL_Scancode key) const;
+
+    bool WasKeyReleased(SDL_Scancode key) const;
+
+    // Adds a key to the action, an action is down while any of its keys is
+    void BindAction(int action, SDL_Scancode key);
+
+    void ClearAction(int action);
+
+    bool IsActionDown(int action) const;
+
+    bool WasActionPressed(int action) const;
+
+    bool WasActionReleased(int action) const;
+
+    // Motion summed since the last call, in pixels, y up
+    glm::vec2 TakeMouseDelta();
+
+    // Call once the frame that consumed the input is presented (after the swap)
+    void EndFrame();
+
+    // Latency of the last frame that had input, and average and maximum over the last frames
+    double GetLastLatencyMilliseconds() const;
+
+    double GetAverageLatencyMilliseconds() const;
+
+    double GetMaxLatencyMilliseconds() const;
+
+    // Events handled during the last frame, motion included
+    int GetLastEventCount() const;
+
+    const std::string& GetError() const;
+
+    static const int LATENCY_FRAMES = 128;
+
+private:
+
+    static const int BATCH_SIZE = 64;
+
+    typedef std::bitset<SDL_NUM_SCANCODES> KeySet;
+
+    void RecordKey(const SDL_KeyboardEvent& event);
+
+    bool AnyBound(int action, const KeySet& keys) const;
+
+    SDL_Event m_events[BATCH_SIZE];
+
+    int m_eventCount;
+
+    int m_nextEvent;
+
+    bool m_relativeMouse;
+
+    glm::vec2 m_mouseDelta;
+
+    KeySet m_keysDown;
+
+    KeySet m_keysPressed;
+
+    KeySet m_keysReleased;
+
+    // Keys of each action id
+    std::vector<std::vector<SDL_Scancode>> m_actions;
+
+    // Performance counter at the arrival of the oldest event not presented yet, 0 if there is none
+    Uint64 m_oldestEvent;
+
+    int m_frameEvents;
+
+    int m_lastEventCount;
+
+    double m_latencies[LATENCY_FRAMES];
+
+    int m_latencyCount;
+
+    int m_latencyIndex;
+
+    double m_lastLatency;
+
+    std::string m_error;
+};
+#endif
@@ -0,0 +1,290 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    // Items of 4 bytes per 64 byte cache line
+    const size_t CACHE_LINE_ITEMS = 16;
+
+    // Chunks per thread in ParallelFor, more balance the load better but cost more queue traffic
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    struct WorkerIdentity
+    {
+        const JobSystem* owner;
+        unsigned index;
+    };
+
+    thread_local WorkerIdentity s_worker = { nullptr, 0 };
+}
+
+JobCounter::JobCounter():m_pending{0}
+{
+
+}
+
+bool JobCounter::IsDone() const
+{
+    return m_pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(unsigned threadCount):m_queued{0}, m_stop{false}
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_queues.emplace_back(new WorkQueue());
+    for (unsigned i = 1; i < threadCount; ++i)
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+    for (auto& worker: m_workers)
+        worker.join();
+}
+
+void JobSystem::Run(std::function<void()> job, JobCounter* signal)
+{
+    if (signal)
+        signal->m_pending.fetch_add(1, std::memory_order_relaxed);
+    Push(Job{ std::move(job), signal });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* signal)
+{
+    if (signal)
+        signal->m_pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        // Finish() decrements under the same lock, so the job is either seen here as ready or
+        // found there in the continuations
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (!dependency.IsDone())
+        {
+            dependency.m_continuations.push_back(JobCounter::Continuation{ std::move(job), signal });
+            return;
+        }
+    }
+    Push(Job{ std::move(job), signal });
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!TryRunJob())
+            std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    const size_t threads = GetThreadCount();
+    size_t chunk = std::max<size_t>(std::max<size_t>(minChunk, 1), (count + threads * CHUNKS_PER_THREAD - 1) / (threads * CHUNKS_PER_THREAD));
+    if (chunk > CACHE_LINE_ITEMS)
+        chunk = (chunk + CACHE_LINE_ITEMS - 1) / CACHE_LINE_ITEMS * CACHE_LINE_ITEMS;
+    const size_t chunks = (count + chunk - 1) / chunk;
+    if (chunks == 1 || threads == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    JobCounter done;
+    for (size_t i = 1; i < chunks; ++i)
+    {
+        size_t begin = i * chunk;
+        size_t end = std::min(count, begin + chunk);
+        Run([&fn, begin, end]() { fn(begin, end); }, &done);
+    }
+
+    // The first chunk always runs on the calling thread
+    fn(0, std::min(count, chunk));
+    Wait(done);
+}
+
+unsigned JobSystem::GetThreadCount() const
+{
+    return static_cast<unsigned>(m_queues.size());
+}
+
+void JobSystem::Push(Job&& job)
+{
+    WorkQueue& queue = *m_queues[GetQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    m_queued.fetch_add(1);
+
+    // Taking the sleep lock orders the increment before a worker's check, so no wakeup is lost
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeup.notify_one();
+}
+
+bool JobSystem::TryRunJob()
+{
+    if (m_queued.load() == 0)
+        return false;
+
+    const unsigned self = GetQueueIndex();
+    const unsigned queueCount = unsigned(m_queues.size());
+    Job job;
+    bool found = false;
+    for (unsigned n = 0; n < queueCount && !found; ++n)
+    {
+        const unsigned index = (self + n) % queueCount;
+        WorkQueue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+        // Newest from the own deque (still in cache), oldest from a victim's (likely the biggest piece)
+        if (n == 0)
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        found = true;
+    }
+    if (!found)
+        return false;
+
+    m_queued.fetch_sub(1);
+    job.fn();
+    Finish(job.signal);
+    return true;
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+    if (!counter)
+        return;
+
+    // Decremented under the lock: a waiter seeing zero then takes the lock before the counter can go
+    // out of scope, by then this thread is done with it
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        continuations.swap(counter->m_continuations);
+    }
+    for (auto& continuation: continuations)
+        Push(Job{ std::move(continuation.job), continuation.signal });
+}
+
+unsigned JobSystem::GetQueueIndex() const
+{
+    return s_worker.owner == this ? s_worker.index : 0;
+}
+
+void JobSystem::WorkerLoop(unsigned index)
+{
+    s_worker.owner = this;
+    s_worker.index = index;
+
+    while (true)
+    {
+        if (TryRunJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeup.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+        if (m_stop)
+            return;
+    }
+}
+
+void JobSystem::RunBenchmark()
+{
+    const int FRAMES = 20;
+    const size_t NODES = 1 << 18;
+    const size_t SMALL_JOBS = 2048;
+
+    // Scene data of the synthetic frame
+    std::vector<glm::mat4> local(NODES), world(NODES);
+    std::vector<float> radius(NODES), visible(NODES);
+    for (size_t i = 0; i < NODES; ++i)
+    {
+        local[i] = glm::mat4(1.0f);
+        local[i][3] = glm::vec4(float(i % 512) - 256.0f, 0.0f, float(i / 512) - 256.0f, 1.0f);
+        radius[i] = 0.5f + float(i % 7) * 0.25f;
+    }
+    std::vector<float> binResults(SMALL_JOBS), listResults(SMALL_JOBS);
+    const glm::mat4 parent(glm::vec4(0.9f, 0.1f, 0.0f, 0.0f), glm::vec4(-0.1f, 0.9f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(1.0f, 2.0f, 3.0f, 1.0f));
+    const glm::vec4 plane(0.0f, 0.0f, 1.0f, 10.0f);
+
+    // Stand in for a small piece of work such as binning a few lights or recording a draw
+    auto smallJob = [](float seed)
+    {
+        float sum = 0.0f;
+        for (int i = 1; i <= 2000; ++i)
+            sum += std::sqrt(seed + float(i));
+        return sum;
+    };
+
+    auto frame = [&](JobSystem& jobs)
+    {
+        // Transform update then culling, two parallel loops
+        jobs.ParallelFor(NODES, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                world[i] = parent * local[i];
+        });
+        jobs.ParallelFor(NODES, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                visible[i] = glm::dot(plane, world[i][3]) + radius[i] > 0.0f ? 1.0f : 0.0f;
+        });
+
+        // Fine grained jobs, the second group only starts once the first one is done
+        JobCounter binned, recorded;
+        for (size_t i = 0; i < SMALL_JOBS; ++i)
+            jobs.Run([&, i]() { binResults[i] = smallJob(float(i)); }, &binned);
+        for (size_t i = 0; i < SMALL_JOBS; ++i)
+            jobs.RunAfter(binned, [&, i]() { listResults[i] = smallJob(binResults[i]); }, &recorded);
+        jobs.Wait(recorded);
+    };
+
+    const unsigned maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::cout << "JobSystem benchmark, " << NODES << " nodes and " << SMALL_JOBS * 2 << " dependent jobs per frame, average of "
+        << FRAMES << " frames" << std::endl;
+    double singleThread = 0.0;
+    for (unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1)
+    {
+        JobSystem jobs(threads);
+        frame(jobs);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < FRAMES; ++i)
+            frame(jobs);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / FRAMES;
+        if (threads == 1)
+            singleThread = ms;
+
+        std::cout << "  x" << jobs.GetThreadCount() << " threads: " << ms << " ms, speedup " << singleThread / ms << std::endl;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Number of unfinished jobs signalling it. Jobs can be made to start once a counter reaches zero
+// (JobSystem::RunAfter) and any thread can wait for it while helping with the queued work.
+class JobCounter
+{
+public:
+
+    JobCounter();
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool IsDone() const;
+
+private:
+
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        std::function<void()> job;
+        JobCounter* signal;
+    };
+
+    std::atomic<int> m_pending;
+
+    std::mutex m_mutex;
+
+    std::vector<Continuation> m_continuations;
+};
+
+// Worker threads with one job deque each. A thread pushes and pops its own deque at the back, so
+// it keeps working on what it just split, and idle threads steal from the front of the others.
+// Threads that are not workers (the main thread) share an extra deque.
+class JobSystem
+{
+public:
+
+    // threadCount includes the calling thread, 0 means one thread per hardware thread
+    explicit JobSystem(unsigned threadCount = 0);
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues a job, signal (if any) counts it until it has run
+    void Run(std::function<void()> job, JobCounter* signal = nullptr);
+
+    // Queues a job once dependency reaches zero, right away if it already has
+    void RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* signal = nullptr);
+
+    // Runs queued jobs until counter reaches zero, afterwards the counter may be destroyed
+    void Wait(JobCounter& counter);
+
+    // Splits [0, count) into chunks of at least minChunk items and runs fn(begin, end) on them.
+    // There are a few chunks per thread so stealing can even out the load, and chunks longer than
+    // a cache line of floats end on a multiple of it so neighbouring chunks do not write the same line.
+    // The calling thread takes part in the work and the call returns when every chunk is done.
+    void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+
+    unsigned GetThreadCount() const;
+
+    // Prints the time of a synthetic frame made of parallel loops and dependent small jobs for 1 to N threads
+    static void RunBenchmark();
+
+private:
+
+    struct Job
+    {
+        std::function<void()> fn;
+        JobCounter* signal;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void Push(Job&& job);
+
+    // Pops from the calling thread's deque, then steals from the others. False when all are empty.
+    bool TryRunJob();
+
+    void Finish(JobCounter* counter);
+
+    unsigned GetQueueIndex() const;
+
+    void WorkerLoop(unsigned index);
+
+private:
+
+    // [0] is shared by the threads that are not workers, worker i owns [i]
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    std::vector<std::thread> m_workers;
+
+    // Jobs in all the deques, workers sleep while it is zero
+    std::atomic<int> m_queued;
+
+    std::mutex m_sleepMutex;
+
+    std::condition_variable m_wakeup;
+
+    bool m_stop;
+};
+#endif
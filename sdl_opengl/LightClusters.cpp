@@ -0,0 +1,324 @@
+#include "LightClusters.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+LightClusters::LightClusters(JobSystem* jobs):
+    m_jobs{jobs}, m_slices(GRID_Z), m_fovY{0.0f}, m_aspect{0.0f}, m_zNear{0.0f}, m_zFar{0.0f}, m_sliceScale{0.0f},
+    m_buffers{0, 0, 0}, m_textures{0, 0, 0}, m_buildMs{0.0}
+{
+
+}
+
+LightClusters::~LightClusters()
+{
+    if (m_textures[0])
+    {
+        glDeleteTextures(3, m_textures);
+        glDeleteBuffers(3, m_buffers);
+    }
+}
+
+void LightClusters::InitGL()
+{
+    static const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+    glGenBuffers(3, m_buffers);
+    glGenTextures(3, m_textures);
+    for (int i = 0; i < 3; ++i)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Build(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect, float zNear, float zFar)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (fovY != m_fovY || aspect != m_aspect || zNear != m_zNear || zFar != m_zFar)
+        UpdateClusterBounds(fovY, aspect, zNear, zFar);
+
+    // SoA arrays padded to a multiple of 4, padding lights have a negative radius and never pass
+    const size_t count = lights.size();
+    const size_t padded = (count + 3) & ~size_t(3);
+    m_viewX.resize(padded);
+    m_viewY.resize(padded);
+    m_viewZ.resize(padded);
+    m_radius.assign(padded, -1.0f);
+    m_sliceMin.resize(count);
+    m_sliceMax.resize(count);
+
+    m_lightData.resize(count * 2);
+    if (m_jobs)
+        m_jobs->ParallelFor(count, 1024, [&](size_t begin, size_t end) { TransformLights(lights, view, begin, end); });
+    else
+        TransformLights(lights, view, 0, count);
+
+    if (m_jobs)
+    {
+        m_jobs->ParallelFor(GRID_Z, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t slice = begin; slice < end; ++slice)
+                BinSlice(int(slice), count);
+        });
+    }
+    else
+    {
+        for (int slice = 0; slice < GRID_Z; ++slice)
+            BinSlice(slice, count);
+    }
+
+    // Concatenate the per slice lists, cluster index = (slice * GRID_Y + y) * GRID_X + x
+    m_grid.resize(CLUSTER_COUNT * 2);
+    m_indices.clear();
+    for (int slice = 0; slice < GRID_Z; ++slice)
+    {
+        const SliceBins& bins = m_slices[slice];
+        std::uint32_t offset = std::uint32_t(m_indices.size());
+        for (int tile = 0; tile < GRID_X * GRID_Y; ++tile)
+        {
+            std::uint32_t cluster = std::uint32_t(slice * GRID_X * GRID_Y + tile);
+            m_grid[cluster * 2 + 0] = offset;
+            m_grid[cluster * 2 + 1] = bins.counts[tile];
+            offset += bins.counts[tile];
+        }
+        m_indices.insert(m_indices.end(), bins.indices.begin(), bins.indices.end());
+    }
+
+    m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void LightClusters::Upload()
+{
+    const void* data[3] = { m_lightData.data(), m_grid.data(), m_indices.data() };
+    const size_t sizes[3] = { m_lightData.size() * sizeof(glm::vec4), m_grid.size() * sizeof(std::uint32_t), m_indices.size() * sizeof(std::uint32_t) };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        // Orphan the old storage so the driver does not wait for the previous frame
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(sizes[i], 16), nullptr, GL_STREAM_DRAW);
+        if (sizes[i])
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, sizes[i], data[i]);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Bind(GLuint program, int firstTextureUnit, int screenWidth, int screenHeight) const
+{
+    static const char* samplers[3] = { "lightData", "clusterGrid", "lightIndices" };
+    for (int i = 0; i < 3; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstTextureUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), firstTextureUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform3i(glGetUniformLocation(program, "gridSize"), GRID_X, GRID_Y, GRID_Z);
+    glUniform2f(glGetUniformLocation(program, "screenSize"), GLfloat(screenWidth), GLfloat(screenHeight));
+    glUniform1f(glGetUniformLocation(program, "zNear"), m_zNear);
+    glUniform1f(glGetUniformLocation(program, "sliceScale"), m_sliceScale);
+}
+
+size_t LightClusters::GetIndexCount() const
+{
+    return m_indices.size();
+}
+
+double LightClusters::GetBuildMilliseconds() const
+{
+    return m_buildMs;
+}
+
+void LightClusters::UpdateClusterBounds(float fovY, float aspect, float zNear, float zFar)
+{
+    m_fovY = fovY;
+    m_aspect = aspect;
+    m_zNear = zNear;
+    m_zFar = zFar;
+    m_sliceScale = GRID_Z / std::log(zFar / zNear);
+
+    const float tanY = std::tan(fovY * 0.5f);
+    const float tanX = tanY * aspect;
+
+    m_bounds.resize(CLUSTER_COUNT);
+    for (int slice = 0; slice < GRID_Z; ++slice)
+    {
+        float dn = zNear * std::pow(zFar / zNear, float(slice) / GRID_Z);
+        float df = zNear * std::pow(zFar / zNear, float(slice + 1) / GRID_Z);
+        for (int y = 0; y < GRID_Y; ++y)
+        {
+            float y0 = (-1.0f + 2.0f * y / GRID_Y) * tanY;
+            float y1 = (-1.0f + 2.0f * (y + 1) / GRID_Y) * tanY;
+            for (int x = 0; x < GRID_X; ++x)
+            {
+                float x0 = (-1.0f + 2.0f * x / GRID_X) * tanX;
+                float x1 = (-1.0f + 2.0f * (x + 1) / GRID_X) * tanX;
+
+                // The froxel is a frustum slab, its AABB spans both depth planes
+                ClusterBounds& b = m_bounds[(slice * GRID_Y + y) * GRID_X + x];
+                b.min = glm::vec3(std::min(x0 * dn, x0 * df), std::min(y0 * dn, y0 * df), dn);
+                b.max = glm::vec3(std::max(x1 * dn, x1 * df), std::max(y1 * dn, y1 * df), df);
+            }
+        }
+    }
+}
+
+void LightClusters::TransformLights(const std::vector<PointLight>& lights, const glm::mat4& view, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const PointLight& light = lights[i];
+        glm::vec4 v = view * glm::vec4(light.position, 1.0f);
+        m_viewX[i] = v.x;
+        m_viewY[i] = v.y;
+        m_viewZ[i] = -v.z;
+        m_radius[i] = light.radius;
+
+        float dmin = -v.z - light.radius;
+        float dmax = -v.z + light.radius;
+        if (dmax < m_zNear || dmin > m_zFar)
+        {
+            m_sliceMin[i] = 1;
+            m_sliceMax[i] = 0;
+        }
+        else
+        {
+            m_sliceMin[i] = std::int16_t(GetSlice(dmin));
+            m_sliceMax[i] = std::int16_t(GetSlice(dmax));
+        }
+
+        m_lightData[i * 2 + 0] = glm::vec4(light.position, light.radius);
+        m_lightData[i * 2 + 1] = glm::vec4(light.color, 0.0f);
+    }
+}
+
+void LightClusters::BinSlice(int slice, size_t lightCount)
+{
+    SliceBins& bins = m_slices[slice];
+    bins.x.clear();
+    bins.y.clear();
+    bins.z.clear();
+    bins.r2.clear();
+    bins.ids.clear();
+    bins.indices.clear();
+
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        if (slice < m_sliceMin[i] || slice > m_sliceMax[i])
+            continue;
+        bins.x.push_back(m_viewX[i]);
+        bins.y.push_back(m_viewY[i]);
+        bins.z.push_back(m_viewZ[i]);
+        bins.r2.push_back(m_radius[i] * m_radius[i]);
+        bins.ids.push_back(std::uint32_t(i));
+    }
+    // Pad the candidates to whole SIMD groups, r2 < 0 never passes the distance test
+    const size_t candidates = bins.ids.size();
+    while (bins.x.size() & 3)
+    {
+        bins.x.push_back(0.0f);
+        bins.y.push_back(0.0f);
+        bins.z.push_back(0.0f);
+        bins.r2.push_back(-1.0f);
+    }
+
+    for (int tile = 0; tile < GRID_X * GRID_Y; ++tile)
+    {
+        const ClusterBounds& b = m_bounds[slice * GRID_X * GRID_Y + tile];
+        const std::uint32_t before = std::uint32_t(bins.indices.size());
+        size_t i = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minX = _mm_set1_ps(b.min.x), maxX = _mm_set1_ps(b.max.x);
+        const __m128 minY = _mm_set1_ps(b.min.y), maxY = _mm_set1_ps(b.max.y);
+        const __m128 minZ = _mm_set1_ps(b.min.z), maxZ = _mm_set1_ps(b.max.z);
+        for (; i < bins.x.size(); i += 4)
+        {
+            // Squared distance from the sphere center to the box, one light per lane
+            __m128 x = _mm_loadu_ps(&bins.x[i]);
+            __m128 y = _mm_loadu_ps(&bins.y[i]);
+            __m128 z = _mm_loadu_ps(&bins.z[i]);
+            __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+            __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+            __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_loadu_ps(&bins.r2[i])));
+            while (mask)
+            {
+                int lane = 0;
+                while (!(mask & (1 << lane)))
+                    ++lane;
+                mask &= ~(1 << lane);
+                bins.indices.push_back(bins.ids[i + lane]);
+            }
+        }
+#endif
+        for (; i < candidates; ++i)
+        {
+            float dx = std::max(std::max(b.min.x - bins.x[i], bins.x[i] - b.max.x), 0.0f);
+            float dy = std::max(std::max(b.min.y - bins.y[i], bins.y[i] - b.max.y), 0.0f);
+            float dz = std::max(std::max(b.min.z - bins.z[i], bins.z[i] - b.max.z), 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= bins.r2[i])
+                bins.indices.push_back(bins.ids[i]);
+        }
+        bins.counts[tile] = std::uint32_t(bins.indices.size()) - before;
+    }
+}
+
+int LightClusters::GetSlice(float depth) const
+{
+    if (depth <= m_zNear)
+        return 0;
+    int slice = int(std::log(depth / m_zNear) * m_sliceScale);
+    return std::min(slice, GRID_Z - 1);
+}
+
+void LightClusters::RunBenchmark()
+{
+    const int FRAMES = 20;
+    const float FOV = glm::radians(45.0f);
+
+    JobSystem jobs;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> radius(1.0f, 4.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 45.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::cout << "LightClusters benchmark, " << GRID_X << "x" << GRID_Y << "x" << GRID_Z << " clusters, average of " << FRAMES << " frames" << std::endl;
+    for (size_t count = 256; count <= 16384; count *= 4)
+    {
+        std::vector<PointLight> lights(count);
+        for (auto& light: lights)
+        {
+            light.position = glm::vec3(position(rng), position(rng), position(rng));
+            light.radius = radius(rng);
+            light.color = glm::vec3(1.0f);
+        }
+
+        for (int threaded = 0; threaded < 2; ++threaded)
+        {
+            LightClusters clusters(threaded ? &jobs : nullptr);
+            double total = 0.0;
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                clusters.Build(lights, view, FOV, 800.0f / 600.0f, 0.1f, 100.0f);
+                total += clusters.GetBuildMilliseconds();
+            }
+            std::cout << "  " << count << " lights x" << (threaded ? jobs.GetThreadCount() : 1) << " threads: "
+                << total / FRAMES << " ms, " << clusters.GetIndexCount() << " light references" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef LIGHT_CLUSTERS_HPP
+#define LIGHT_CLUSTERS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+struct PointLight
+{
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+};
+
+// Clustered forward shading: point lights are binned on the CPU into a froxel grid (screen tiles x
+// exponential depth slices) and the per cluster light lists are uploaded as texture buffers, so the
+// fragment shader only iterates the lights overlapping its cluster.
+class LightClusters
+{
+public:
+
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    // jobs may be nullptr, then binning runs on the calling thread
+    explicit LightClusters(JobSystem* jobs = nullptr);
+
+    ~LightClusters();
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // Creates the texture buffers, needs a current GL context
+    void InitGL();
+
+    // CPU binning, does not touch GL so it can run (and be benchmarked) without a context
+    void Build(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect, float zNear, float zFar);
+
+    // Streams the last Build() result to the texture buffers
+    void Upload();
+
+    // Binds the buffers to three consecutive texture units and sets the clustered shading uniforms
+    void Bind(GLuint program, int firstTextureUnit, int screenWidth, int screenHeight) const;
+
+    size_t GetIndexCount() const;
+
+    double GetBuildMilliseconds() const;
+
+    // Prints binning time for increasing light counts
+    static void RunBenchmark();
+
+private:
+
+    struct SliceBins
+    {
+        std::vector<float> x, y, z, r2;
+        std::vector<std::uint32_t> ids;
+        std::vector<std::uint32_t> indices;
+        std::uint32_t counts[GRID_X * GRID_Y];
+    };
+
+    struct ClusterBounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    void UpdateClusterBounds(float fovY, float aspect, float zNear, float zFar);
+
+    void TransformLights(const std::vector<PointLight>& lights, const glm::mat4& view, size_t begin, size_t end);
+
+    void BinSlice(int slice, size_t lightCount);
+
+    int GetSlice(float depth) const;
+
+private:
+
+    JobSystem* m_jobs;
+
+    // Light positions in view space with depth stored as a positive distance
+    std::vector<float> m_viewX, m_viewY, m_viewZ, m_radius;
+
+    std::vector<std::int16_t> m_sliceMin, m_sliceMax;
+
+    std::vector<ClusterBounds> m_bounds;
+
+    std::vector<SliceBins> m_slices;
+
+    float m_fovY, m_aspect, m_zNear, m_zFar;
+
+    float m_sliceScale;
+
+    // GPU side layout: two RGBA32F texels per light, RG32UI (offset, count) per cluster, R32UI indices
+    std::vector<glm::vec4> m_lightData;
+
+    std::vector<std::uint32_t> m_grid;
+
+    std::vector<std::uint32_t> m_indices;
+
+    GLuint m_buffers[3];
+
+    GLuint m_textures[3];
+
+    double m_buildMs;
+};
+#endif
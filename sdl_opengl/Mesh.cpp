@@ -0,0 +1,56 @@
+#include "Mesh.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+void Mesh::ComputeBounds()
+{
+    if (vertices.empty())
+    {
+        bounds = AABB();
+        return;
+    }
+    bounds = AABB(vertices[0].position, vertices[0].position);
+    for (auto& vertex: vertices)
+    {
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
+}
+
+Mesh Mesh::CreateSphere(float radius, int rings, int segments)
+{
+    Mesh mesh;
+    mesh.vertices.reserve(size_t(rings + 1) * (segments + 1));
+    for (int ring = 0; ring <= rings; ++ring)
+    {
+        float v = float(ring) / rings;
+        float theta = v * glm::pi<float>();
+        for (int segment = 0; segment <= segments; ++segment)
+        {
+            float u = float(segment) / segments;
+            float phi = u * glm::two_pi<float>();
+            Vertex vertex;
+            vertex.normal = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+            vertex.position = vertex.normal * radius;
+            vertex.uv = glm::vec2(u, v);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    // Counter clockwise seen from outside, the pole rows only have one real triangle per quad
+    const std::uint32_t stride = std::uint32_t(segments + 1);
+    for (int ring = 0; ring < rings; ++ring)
+    {
+        for (int segment = 0; segment < segments; ++segment)
+        {
+            std::uint32_t i0 = ring * stride + segment;
+            std::uint32_t i1 = i0 + stride;
+            if (ring != 0)
+                mesh.indices.insert(mesh.indices.end(), { i0, i0 + 1, i1 });
+            if (ring != rings - 1)
+                mesh.indices.insert(mesh.indices.end(), { i0 + 1, i1 + 1, i1 });
+        }
+    }
+    mesh.ComputeBounds();
+    return mesh;
+}
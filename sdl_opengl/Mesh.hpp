@@ -0,0 +1,36 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+// Interleaved vertex layout shared by every indexed mesh: attribute 0 position, 1 normal, 2 uv
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+// Indexed triangle list in CPU memory
+struct Mesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+    AABB bounds;
+
+    size_t GetTriangleCount() const
+    {
+        return indices.size() / 3;
+    }
+
+    void ComputeBounds();
+
+    // UV sphere centered at the origin, vertices are duplicated along the texture seam
+    static Mesh CreateSphere(float radius, int rings, int segments);
+};
+#endif
@@ -0,0 +1,1183 @@
+#include "MeshImporter.hpp"
+#include "JobSystem.hpp"
+#include "SelfTest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // ---- Number parsing ----
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    const char* SkipLine(const char* p, const char* end)
+    {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        return newline ? newline + 1 : end;
+    }
+
+    // Decimal number with optional exponent. Up to 19 significant digits are accumulated in an
+    // integer and scaled once, which is exact for integers up to 2^53 and far faster than strtod.
+    const char* ParseDouble(const char* p, const char* end, double& value)
+    {
+        static const double powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        p = SkipSpaces(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        std::uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa)
+                    digits++;
+            }
+            else
+                exponent++;
+        }
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if (mantissa)
+                        digits++;
+                    exponent--;
+                }
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                negativeExponent = *p++ == '-';
+            int e = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+                e = std::min(e * 10 + (*p - '0'), 1000);
+            exponent += negativeExponent ? -e : e;
+        }
+
+        double result = double(mantissa);
+        while (exponent > 22)
+        {
+            result *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22)
+        {
+            result /= 1e22;
+            exponent += 22;
+        }
+        result = exponent >= 0 ? result * powers[exponent] : result / powers[-exponent];
+        value = negative ? -result : result;
+        return p;
+    }
+
+    const char* ParseFloat(const char* p, const char* end, float& value)
+    {
+        double result = 0.0;
+        p = ParseDouble(p, end, result);
+        value = float(result);
+        return p;
+    }
+
+    // Saturates at +-INT32_MAX, which no valid index reaches
+    const char* ParseInt(const char* p, const char* end, std::int64_t& value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+        std::int64_t result = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            result = std::min<std::int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+        value = negative ? -result : result;
+        return p;
+    }
+
+    // ---- OBJ ----
+
+    // No uv or normal reference
+    const std::int32_t MISSING = INT32_MIN;
+
+    // One face corner, 0 based global indices
+    struct Corner
+    {
+        std::int32_t v, vt, vn;
+    };
+
+    // Face corner as parsed. Negative OBJ indices count back from the last element read, which may
+    // be in an earlier chunk: they are kept as offsets from the chunk's first element (negative when
+    // they reach into an earlier chunk) and flagged until the chunk bases are known.
+    struct ChunkCorner
+    {
+        Corner index;
+        // RELATIVE_* bits
+        std::uint8_t relative;
+    };
+
+    const std::uint8_t RELATIVE_V = 1;
+    const std::uint8_t RELATIVE_VT = 2;
+    const std::uint8_t RELATIVE_VN = 4;
+
+    struct ObjChunk
+    {
+        const char* begin;
+        const char* end;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<ChunkCorner> corners;
+        size_t positionBase, uvBase, normalBase;
+    };
+
+    // 0 based index, absolute or (flagged in relative) from the chunk's first element. Chunks hold
+    // far fewer than 2^31 elements, so both fit in 32 bits.
+    std::int32_t ToIndex(std::int64_t objIndex, size_t localCount, std::uint8_t flag, std::uint8_t& relative)
+    {
+        if (objIndex > 0)
+            return std::int32_t(objIndex - 1);
+        if (objIndex < 0)
+        {
+            relative |= flag;
+            return std::int32_t(std::int64_t(localCount) + objIndex);
+        }
+        return MISSING;
+    }
+
+    void ParseChunk(ObjChunk& chunk)
+    {
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+        ChunkCorner polygon[64];
+        while (p < end)
+        {
+            p = SkipSpaces(p, end);
+            if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+            {
+                glm::vec3 v;
+                p = ParseFloat(p + 1, end, v.x);
+                p = ParseFloat(p, end, v.y);
+                p = ParseFloat(p, end, v.z);
+                chunk.positions.push_back(v);
+            }
+            else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+            {
+                glm::vec2 uv;
+                p = ParseFloat(p + 2, end, uv.x);
+                p = ParseFloat(p, end, uv.y);
+                chunk.uvs.push_back(uv);
+            }
+            else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+            {
+                glm::vec3 n;
+                p = ParseFloat(p + 2, end, n.x);
+                p = ParseFloat(p, end, n.y);
+                p = ParseFloat(p, end, n.z);
+                chunk.normals.push_back(n);
+            }
+            else if (p + 1 < end && p[0] == 'f' && IsSpace(p[1]))
+            {
+                // v, v/vt, v//vn or v/vt/vn, polygons are triangulated as fans
+                int count = 0;
+                ++p;
+                while (true)
+                {
+                    p = SkipSpaces(p, end);
+                    if (p >= end || *p == '\n' || *p == '#')
+                        break;
+                    std::int64_t v = 0, vt = 0, vn = 0;
+                    const char* start = p;
+                    p = ParseInt(p, end, v);
+                    if (p < end && *p == '/')
+                    {
+                        ++p;
+                        if (p < end && *p != '/')
+                            p = ParseInt(p, end, vt);
+                        if (p < end && *p == '/')
+                            p = ParseInt(p + 1, end, vn);
+                    }
+                    if (p == start)
+                        break;
+                    if (count < 64)
+                    {
+                        ChunkCorner& corner = polygon[count++];
+                        corner.relative = 0;
+                        corner.index.v = ToIndex(v, chunk.positions.size(), RELATIVE_V, corner.relative);
+                        corner.index.vt = ToIndex(vt, chunk.uvs.size(), RELATIVE_VT, corner.relative);
+                        corner.index.vn = ToIndex(vn, chunk.normals.size(), RELATIVE_VN, corner.relative);
+                    }
+                }
+                for (int i = 2; i < count; ++i)
+                {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i - 1]);
+                    chunk.corners.push_back(polygon[i]);
+                }
+            }
+            p = SkipLine(p, end);
+        }
+    }
+
+    // Global index of a parsed one, false when it is outside [0, count)
+    bool Resolve(std::int32_t index, bool relative, size_t base, size_t count, std::int32_t& resolved)
+    {
+        if (index == MISSING)
+        {
+            resolved = MISSING;
+            return true;
+        }
+        const std::int64_t global = relative ? std::int64_t(base) + index : std::int64_t(index);
+        resolved = std::int32_t(global);
+        return global >= 0 && global < std::int64_t(count);
+    }
+
+    // Open addressing (linear probing) map from a corner to its welded vertex index
+    class WeldMap
+    {
+    public:
+
+        explicit WeldMap(size_t expected)
+        {
+            size_t capacity = 1024;
+            while (capacity < expected * 2)
+                capacity *= 2;
+            m_slots.assign(capacity, Slot{ Corner{ 0, 0, 0 }, EMPTY });
+            m_size = 0;
+        }
+
+        // Returns the index stored for the corner, inserting nextIndex when it is new
+        std::uint32_t Insert(const Corner& corner, std::uint32_t nextIndex)
+        {
+            if ((m_size + 1) * 2 > m_slots.size())
+                Grow();
+            size_t mask = m_slots.size() - 1;
+            for (size_t i = Hash(corner) & mask; ; i = (i + 1) & mask)
+            {
+                Slot& slot = m_slots[i];
+                if (slot.value == EMPTY)
+                {
+                    slot.key = corner;
+                    slot.value = nextIndex;
+                    m_size++;
+                    return nextIndex;
+                }
+                if (slot.key.v == corner.v && slot.key.vt == corner.vt && slot.key.vn == corner.vn)
+                    return slot.value;
+            }
+        }
+
+    private:
+
+        static const std::uint32_t EMPTY = 0xFFFFFFFFu;
+
+        struct Slot
+        {
+            Corner key;
+            std::uint32_t value;
+        };
+
+        static size_t Hash(const Corner& c)
+        {
+            std::uint64_t h = std::uint32_t(c.v) * 0x9E3779B97F4A7C15ull;
+            h ^= (std::uint32_t(c.vt) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2));
+            h ^= (std::uint32_t(c.vn) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2));
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            return size_t(h);
+        }
+
+        void Grow()
+        {
+            std::vector<Slot> old;
+            old.swap(m_slots);
+            m_slots.assign(old.size() * 2, Slot{ Corner{ 0, 0, 0 }, EMPTY });
+            size_t mask = m_slots.size() - 1;
+            for (auto& slot: old)
+            {
+                if (slot.value == EMPTY)
+                    continue;
+                size_t i = Hash(slot.key) & mask;
+                while (m_slots[i].value != EMPTY)
+                    i = (i + 1) & mask;
+                m_slots[i] = slot;
+            }
+        }
+
+        std::vector<Slot> m_slots;
+
+        size_t m_size;
+    };
+
+    // Area weighted vertex normals, for files without their own
+    void ComputeNormals(Mesh& mesh)
+    {
+        for (auto& vertex: mesh.vertices)
+            vertex.normal = glm::vec3(0.0f);
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            Vertex& a = mesh.vertices[mesh.indices[i]];
+            Vertex& b = mesh.vertices[mesh.indices[i + 1]];
+            Vertex& c = mesh.vertices[mesh.indices[i + 2]];
+            glm::vec3 n = glm::cross(b.position - a.position, c.position - a.position);
+            a.normal += n;
+            b.normal += n;
+            c.normal += n;
+        }
+        for (auto& vertex: mesh.vertices)
+        {
+            float length = glm::length(vertex.normal);
+            vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    // ---- Minimal JSON, enough for the glTF scene description ----
+
+    struct JsonValue
+    {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type type = Type::Null;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> items;
+        std::vector<std::string> keys;
+
+        // Object member or a null value
+        const JsonValue& operator[](const char* key) const
+        {
+            static const JsonValue null;
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                if (keys[i] == key)
+                    return items[i];
+            }
+            return null;
+        }
+
+        const JsonValue& operator[](size_t index) const
+        {
+            static const JsonValue null;
+            return type == Type::Array && index < items.size() ? items[index] : null;
+        }
+
+        bool IsNull() const
+        {
+            return type == Type::Null;
+        }
+
+        int AsInt(int fallback = 0) const
+        {
+            return type == Type::Number && number >= double(INT_MIN) && number <= double(INT_MAX) ? int(number) : fallback;
+        }
+
+        // Non-negative integer exactly representable in a double (below 2^53), for byte offsets and counts
+        bool AsSize(size_t& value) const
+        {
+            if (type != Type::Number || number < 0.0 || number > 9007199254740992.0 || number != std::floor(number) ||
+                number > double(std::numeric_limits<size_t>::max()))
+                return false;
+            value = size_t(number);
+            return true;
+        }
+
+        // Same, with a fallback when the member is absent
+        bool AsSize(size_t& value, size_t fallback) const
+        {
+            if (IsNull())
+            {
+                value = fallback;
+                return true;
+            }
+            return AsSize(value);
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+
+        JsonParser(const char* begin, const char* end):m_p{begin}, m_end{end}, m_failed{false}
+        {
+        }
+
+        bool Parse(JsonValue& value)
+        {
+            ParseValue(value, 0);
+            SkipWhitespace();
+            return !m_failed;
+        }
+
+    private:
+
+        void SkipWhitespace()
+        {
+            while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+                ++m_p;
+        }
+
+        bool Expect(char c)
+        {
+            SkipWhitespace();
+            if (m_p < m_end && *m_p == c)
+            {
+                ++m_p;
+                return true;
+            }
+            m_failed = true;
+            return false;
+        }
+
+        void ParseString(std::string& out)
+        {
+            if (!Expect('"'))
+                return;
+            while (m_p < m_end && *m_p != '"')
+            {
+                // Escapes are kept verbatim except for the escaped character itself, glTF keys never need more
+                if (*m_p == '\\' && m_p + 1 < m_end)
+                    ++m_p;
+                out += *m_p++;
+            }
+            if (m_p >= m_end)
+                m_failed = true;
+            else
+                ++m_p;
+        }
+
+        void ParseValue(JsonValue& value, int depth)
+        {
+            SkipWhitespace();
+            if (m_p >= m_end || depth > 64)
+            {
+                m_failed = true;
+                return;
+            }
+            char c = *m_p;
+            if (c == '{')
+            {
+                value.type = JsonValue::Type::Object;
+                ++m_p;
+                SkipWhitespace();
+                if (m_p < m_end && *m_p == '}')
+                {
+                    ++m_p;
+                    return;
+                }
+                while (!m_failed)
+                {
+                    value.keys.emplace_back();
+                    ParseString(value.keys.back());
+                    Expect(':');
+                    value.items.emplace_back();
+                    ParseValue(value.items.back(), depth + 1);
+                    SkipWhitespace();
+                    if (m_p < m_end && *m_p == ',')
+                        ++m_p;
+                    else
+                    {
+                        Expect('}');
+                        return;
+                    }
+                }
+            }
+            else if (c == '[')
+            {
+                value.type = JsonValue::Type::Array;
+                ++m_p;
+                SkipWhitespace();
+                if (m_p < m_end && *m_p == ']')
+                {
+                    ++m_p;
+                    return;
+                }
+                while (!m_failed)
+                {
+                    value.items.emplace_back();
+                    ParseValue(value.items.back(), depth + 1);
+                    SkipWhitespace();
+                    if (m_p < m_end && *m_p == ',')
+                        ++m_p;
+                    else
+                    {
+                        Expect(']');
+                        return;
+                    }
+                }
+            }
+            else if (c == '"')
+            {
+                value.type = JsonValue::Type::String;
+                ParseString(value.string);
+            }
+            else if (c == 't' || c == 'f' || c == 'n')
+            {
+                const char* word = c == 't' ? "true" : c == 'f' ? "false" : "null";
+                size_t length = std::strlen(word);
+                if (size_t(m_end - m_p) < length || std::strncmp(m_p, word, length) != 0)
+                {
+                    m_failed = true;
+                    return;
+                }
+                m_p += length;
+                value.type = c == 'n' ? JsonValue::Type::Null : JsonValue::Type::Bool;
+                value.number = c == 't' ? 1.0 : 0.0;
+            }
+            else
+            {
+                // Parsed as a double, byte offsets and counts above 2^24 would not survive a float
+                double number = 0.0;
+                const char* start = m_p;
+                m_p = ParseDouble(m_p, m_end, number);
+                if (m_p == start)
+                    m_failed = true;
+                value.type = JsonValue::Type::Number;
+                value.number = number;
+            }
+        }
+
+    private:
+
+        const char* m_p;
+
+        const char* m_end;
+
+        bool m_failed;
+    };
+
+    // ---- GLB ----
+
+    const std::uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    const std::uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    const std::uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+    const int COMPONENT_UNSIGNED_BYTE = 5121;
+    const int COMPONENT_UNSIGNED_SHORT = 5123;
+    const int COMPONENT_UNSIGNED_INT = 5125;
+    const int COMPONENT_FLOAT = 5126;
+
+    // Resolved accessor: element i starts at data + i * stride
+    struct AccessorView
+    {
+        const unsigned char* data = nullptr;
+        size_t stride = 0;
+        size_t count = 0;
+        int componentType = 0;
+        int components = 0;
+    };
+
+    std::uint32_t ReadU32(const unsigned char* p)
+    {
+        return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+    }
+
+    bool ResolveAccessor(const JsonValue& gltf, int index, const unsigned char* bin, size_t binSize, AccessorView& view)
+    {
+        const JsonValue& accessor = gltf["accessors"][size_t(index)];
+        const JsonValue& bufferView = gltf["bufferViews"][size_t(accessor["bufferView"].AsInt(-1))];
+        if (accessor.IsNull() || bufferView.IsNull() || bufferView["buffer"].AsInt(0) != 0)
+            return false;
+
+        const std::string& type = accessor["type"].string;
+        view.components = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+        view.componentType = accessor["componentType"].AsInt();
+        int componentSize = view.componentType == COMPONENT_UNSIGNED_BYTE ? 1 : view.componentType == COMPONENT_UNSIGNED_SHORT ? 2 : 4;
+        size_t elementSize = size_t(componentSize) * view.components;
+        size_t viewOffset, viewLength, accessorOffset;
+        if (!accessor["count"].AsSize(view.count) || !bufferView["byteStride"].AsSize(view.stride, 0) ||
+            !bufferView["byteOffset"].AsSize(viewOffset, 0) || !bufferView["byteLength"].AsSize(viewLength) ||
+            !accessor["byteOffset"].AsSize(accessorOffset, 0))
+            return false;
+        if (view.stride == 0)
+            view.stride = elementSize;
+
+        // Written so that no sum or product can wrap around
+        if (view.components == 0 || view.count == 0 || viewOffset > binSize || viewLength > binSize - viewOffset ||
+            accessorOffset > viewLength || elementSize > viewLength - accessorOffset ||
+            (view.count - 1) > (viewLength - accessorOffset - elementSize) / view.stride)
+            return false;
+        view.data = bin + viewOffset + accessorOffset;
+        return true;
+    }
+
+    template <typename T>
+    T ReadComponent(const unsigned char* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+}
+
+MeshImporter::MeshImporter(JobSystem* jobs):
+    m_jobs{jobs}, m_readMilliseconds{0.0}, m_parseMilliseconds{0.0}, m_weldMilliseconds{0.0}
+{
+
+}
+
+bool MeshImporter::Load(const std::string& fileName, Mesh& mesh)
+{
+    std::string extension = fileName.substr(fileName.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower(c)); });
+    if (extension == "obj")
+        return LoadOBJ(fileName, mesh);
+    if (extension == "glb")
+        return LoadGLB(fileName, mesh);
+    m_error = "Unsupported mesh format: " + fileName;
+    return false;
+}
+
+bool MeshImporter::LoadOBJ(const std::string& fileName, Mesh& mesh)
+{
+    m_readMilliseconds = m_parseMilliseconds = m_weldMilliseconds = 0.0;
+
+    auto start = Clock::now();
+    std::string text;
+    if (!ReadFile(fileName, text))
+        return false;
+    m_readMilliseconds = MillisecondsSince(start);
+
+    // Chunks of about 1MB, cut after a newline so no line is split
+    start = Clock::now();
+    const size_t CHUNK_SIZE = 1 << 20;
+    std::vector<ObjChunk> chunks;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end)
+    {
+        const char* chunkEnd = p + std::min(CHUNK_SIZE, size_t(end - p));
+        chunkEnd = chunkEnd < end ? SkipLine(chunkEnd, end) : end;
+        chunks.emplace_back();
+        chunks.back().begin = p;
+        chunks.back().end = chunkEnd;
+        p = chunkEnd;
+    }
+    ParallelFor(chunks.size(), 1, [&chunks](size_t begin, size_t last)
+    {
+        for (size_t i = begin; i < last; ++i)
+            ParseChunk(chunks[i]);
+    });
+
+    // Chunk bases turn relative indices into global ones and place every chunk in the shared arrays
+    size_t positionCount = 0, uvCount = 0, normalCount = 0, cornerCount = 0;
+    for (auto& chunk: chunks)
+    {
+        chunk.positionBase = positionCount;
+        chunk.uvBase = uvCount;
+        chunk.normalBase = normalCount;
+        positionCount += chunk.positions.size();
+        uvCount += chunk.uvs.size();
+        normalCount += chunk.normals.size();
+        cornerCount += chunk.corners.size();
+    }
+    if (cornerCount == 0)
+    {
+        m_error = "No triangles in " + fileName;
+        return false;
+    }
+    if (positionCount > size_t(INT32_MAX) || uvCount > size_t(INT32_MAX) || normalCount > size_t(INT32_MAX))
+    {
+        m_error = "Too many vertices in " + fileName;
+        return false;
+    }
+
+    std::vector<glm::vec3> positions(positionCount), normals(normalCount);
+    std::vector<glm::vec2> uvs(uvCount);
+    std::vector<Corner> corners(cornerCount);
+    std::vector<size_t> cornerBase(chunks.size());
+    for (size_t i = 0, base = 0; i < chunks.size(); ++i)
+    {
+        cornerBase[i] = base;
+        base += chunks[i].corners.size();
+    }
+    std::atomic<bool> outOfRange(false);
+    ParallelFor(chunks.size(), 1, [&](size_t begin, size_t last)
+    {
+        for (size_t i = begin; i < last; ++i)
+        {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.uvBase);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+            Corner* out = &corners[cornerBase[i]];
+            for (const ChunkCorner& corner: chunk.corners)
+            {
+                Corner& resolved = *out++;
+                if (corner.index.v == MISSING ||
+                    !Resolve(corner.index.v, (corner.relative & RELATIVE_V) != 0, chunk.positionBase, positionCount, resolved.v) ||
+                    !Resolve(corner.index.vt, (corner.relative & RELATIVE_VT) != 0, chunk.uvBase, uvCount, resolved.vt) ||
+                    !Resolve(corner.index.vn, (corner.relative & RELATIVE_VN) != 0, chunk.normalBase, normalCount, resolved.vn))
+                    outOfRange = true;
+            }
+            chunk.positions = std::vector<glm::vec3>();
+            chunk.uvs = std::vector<glm::vec2>();
+            chunk.normals = std::vector<glm::vec3>();
+            chunk.corners = std::vector<ChunkCorner>();
+        }
+    });
+    m_parseMilliseconds = MillisecondsSince(start);
+    if (outOfRange)
+    {
+        m_error = "Face index out of range in " + fileName;
+        return false;
+    }
+
+    // Welding is sequential, the first occurrence of a corner decides the vertex order
+    start = Clock::now();
+    mesh.vertices.clear();
+    mesh.vertices.reserve(positionCount + positionCount / 4);
+    mesh.indices.resize(cornerCount);
+    WeldMap map(positionCount + positionCount / 4);
+    bool hasNormals = true;
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        const Corner& corner = corners[i];
+        std::uint32_t index = map.Insert(corner, std::uint32_t(mesh.vertices.size()));
+        if (index == mesh.vertices.size())
+        {
+            Vertex vertex;
+            vertex.position = positions[corner.v];
+            vertex.uv = corner.vt != MISSING ? uvs[corner.vt] : glm::vec2(0.0f);
+            vertex.normal = corner.vn != MISSING ? normals[corner.vn] : glm::vec3(0.0f);
+            hasNormals = hasNormals && corner.vn != MISSING;
+            mesh.vertices.push_back(vertex);
+        }
+        mesh.indices[i] = index;
+    }
+    if (!hasNormals)
+        ComputeNormals(mesh);
+    mesh.ComputeBounds();
+    m_weldMilliseconds = MillisecondsSince(start);
+    return true;
+}
+
+bool MeshImporter::LoadGLB(const std::string& fileName, Mesh& mesh)
+{
+    m_readMilliseconds = m_parseMilliseconds = m_weldMilliseconds = 0.0;
+
+    auto start = Clock::now();
+    std::string file;
+    if (!ReadFile(fileName, file))
+        return false;
+    m_readMilliseconds = MillisecondsSince(start);
+
+    start = Clock::now();
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(file.data());
+    if (file.size() < 20 || ReadU32(data) != GLB_MAGIC || ReadU32(data + 4) != 2)
+    {
+        m_error = "Not a glTF 2.0 binary file: " + fileName;
+        return false;
+    }
+    const unsigned char* json = nullptr;
+    const unsigned char* bin = nullptr;
+    size_t jsonSize = 0, binSize = 0;
+    for (size_t offset = 12; offset + 8 <= file.size(); )
+    {
+        size_t length = ReadU32(data + offset);
+        std::uint32_t type = ReadU32(data + offset + 4);
+        // The loop condition guarantees offset + 8 <= size, compare without wrapping
+        size_t available = file.size() - offset - 8;
+        if (length > available)
+            break;
+        if (type == GLB_CHUNK_JSON && !json)
+        {
+            json = data + offset + 8;
+            jsonSize = length;
+        }
+        else if (type == GLB_CHUNK_BIN && !bin)
+        {
+            bin = data + offset + 8;
+            binSize = length;
+        }
+        // Chunks are 4 byte aligned, the padding may run past the end of the file
+        size_t padded = length + ((4 - length % 4) % 4);
+        if (padded > available)
+            break;
+        offset += 8 + padded;
+    }
+
+    JsonValue gltf;
+    if (!json || !JsonParser(reinterpret_cast<const char*>(json), reinterpret_cast<const char*>(json) + jsonSize).Parse(gltf))
+    {
+        m_error = "Invalid glTF JSON chunk in " + fileName;
+        return false;
+    }
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    const JsonValue& primitives = gltf["meshes"][size_t(0)]["primitives"];
+    bool hasNormals = true;
+    for (const JsonValue& primitive: primitives.items)
+    {
+        // Only indexed or plain triangle lists
+        if (primitive["mode"].AsInt(4) != 4)
+            continue;
+        const JsonValue& attributes = primitive["attributes"];
+        AccessorView position, normal, uv, indices;
+        if (!ResolveAccessor(gltf, attributes["POSITION"].AsInt(-1), bin, binSize, position) ||
+            position.componentType != COMPONENT_FLOAT || position.components != 3)
+        {
+            m_error = "Missing or unsupported POSITION accessor in " + fileName;
+            return false;
+        }
+        bool withNormals = ResolveAccessor(gltf, attributes["NORMAL"].AsInt(-1), bin, binSize, normal) &&
+            normal.componentType == COMPONENT_FLOAT && normal.components == 3 && normal.count == position.count;
+        bool withUVs = ResolveAccessor(gltf, attributes["TEXCOORD_0"].AsInt(-1), bin, binSize, uv) &&
+            uv.componentType == COMPONENT_FLOAT && uv.components == 2 && uv.count == position.count;
+        hasNormals = hasNormals && withNormals;
+
+        // Vertices are converted to the interleaved layout in parallel ranges
+        const size_t firstVertex = mesh.vertices.size();
+        mesh.vertices.resize(firstVertex + position.count);
+        Vertex* vertices = mesh.vertices.data() + firstVertex;
+        ParallelFor(position.count, 16384, [&](size_t begin, size_t last)
+        {
+            for (size_t i = begin; i < last; ++i)
+            {
+                std::memcpy(&vertices[i].position, position.data + i * position.stride, sizeof(glm::vec3));
+                if (withNormals)
+                    std::memcpy(&vertices[i].normal, normal.data + i * normal.stride, sizeof(glm::vec3));
+                else
+                    vertices[i].normal = glm::vec3(0.0f);
+                if (withUVs)
+                    std::memcpy(&vertices[i].uv, uv.data + i * uv.stride, sizeof(glm::vec2));
+                else
+                    vertices[i].uv = glm::vec2(0.0f);
+            }
+        });
+
+        const size_t firstIndex = mesh.indices.size();
+        if (primitive["indices"].IsNull())
+        {
+            mesh.indices.resize(firstIndex + position.count / 3 * 3);
+            for (size_t i = firstIndex; i < mesh.indices.size(); ++i)
+                mesh.indices[i] = std::uint32_t(firstVertex + i - firstIndex);
+            continue;
+        }
+        if (!ResolveAccessor(gltf, primitive["indices"].AsInt(-1), bin, binSize, indices) || indices.components != 1)
+        {
+            m_error = "Unsupported index accessor in " + fileName;
+            return false;
+        }
+        mesh.indices.resize(firstIndex + indices.count / 3 * 3);
+        std::uint32_t* out = mesh.indices.data() + firstIndex;
+        std::atomic<bool> outOfRange(false);
+        const size_t indexCount = mesh.indices.size() - firstIndex;
+        ParallelFor(indexCount, 65536, [&](size_t begin, size_t last)
+        {
+            for (size_t i = begin; i < last; ++i)
+            {
+                const unsigned char* p = indices.data + i * indices.stride;
+                std::uint32_t index = indices.componentType == COMPONENT_UNSIGNED_INT ? ReadComponent<std::uint32_t>(p) :
+                    indices.componentType == COMPONENT_UNSIGNED_SHORT ? ReadComponent<std::uint16_t>(p) : *p;
+                if (index >= position.count)
+                    outOfRange = true;
+                out[i] = std::uint32_t(firstVertex) + index;
+            }
+        });
+        if (outOfRange)
+        {
+            m_error = "Index out of range in " + fileName;
+            return false;
+        }
+    }
+    if (mesh.indices.empty())
+    {
+        m_error = "No triangles in " + fileName;
+        return false;
+    }
+    if (!hasNormals)
+        ComputeNormals(mesh);
+    mesh.ComputeBounds();
+    m_parseMilliseconds = MillisecondsSince(start);
+    return true;
+}
+
+const std::string& MeshImporter::GetError() const
+{
+    return m_error;
+}
+
+double MeshImporter::GetReadMilliseconds() const
+{
+    return m_readMilliseconds;
+}
+
+double MeshImporter::GetParseMilliseconds() const
+{
+    return m_parseMilliseconds;
+}
+
+double MeshImporter::GetWeldMilliseconds() const
+{
+    return m_weldMilliseconds;
+}
+
+double MeshImporter::GetTotalMilliseconds() const
+{
+    return m_readMilliseconds + m_parseMilliseconds + m_weldMilliseconds;
+}
+
+bool MeshImporter::ReadFile(const std::string& fileName, std::string& contents)
+{
+    FILE* file = std::fopen(fileName.c_str(), "rb");
+    if (!file)
+    {
+        m_error = "Unable to open " + fileName;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? size_t(size) : 0);
+    size_t read = contents.empty() ? 0 : std::fread(&contents[0], 1, contents.size(), file);
+    std::fclose(file);
+    if (size < 0 || read != contents.size())
+    {
+        m_error = "Unable to read " + fileName;
+        return false;
+    }
+    return true;
+}
+
+void MeshImporter::ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn)
+{
+    if (m_jobs)
+        m_jobs->ParallelFor(count, minChunk, fn);
+    else if (count > 0)
+        fn(0, count);
+}
+
+void MeshImporter::RunBenchmark()
+{
+    // (GRID + 1)^2 vertices, 2 * GRID^2 = 1002528 triangles
+    const int GRID = 708;
+    const int VERTICES = (GRID + 1) * (GRID + 1);
+    const char* objFile = "mesh_import_benchmark.obj";
+    const char* glbFile = "mesh_import_benchmark.glb";
+
+    auto vertexAt = [](int x, int z)
+    {
+        Vertex vertex;
+        float u = float(x) / GRID, v = float(z) / GRID;
+        vertex.position = glm::vec3(u * 10.0f - 5.0f, 0.25f * glm::sin(u * 20.0f) * glm::cos(v * 20.0f), v * 10.0f - 5.0f);
+        vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        vertex.uv = glm::vec2(u, v);
+        return vertex;
+    };
+
+    // OBJ, written with fwrite in large blocks
+    FILE* file = std::fopen(objFile, "wb");
+    if (!file)
+    {
+        std::cout << "MeshImporter benchmark: unable to write " << objFile << std::endl;
+        return;
+    }
+    std::string block;
+    char line[128];
+    auto flush = [&](bool force)
+    {
+        if (force || block.size() > (1 << 20))
+        {
+            std::fwrite(block.data(), 1, block.size(), file);
+            block.clear();
+        }
+    };
+    for (int z = 0; z <= GRID; ++z)
+    {
+        for (int x = 0; x <= GRID; ++x)
+        {
+            Vertex vertex = vertexAt(x, z);
+            block.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0 1 0\n",
+                vertex.position.x, vertex.position.y, vertex.position.z, vertex.uv.x, vertex.uv.y));
+            flush(false);
+        }
+    }
+    for (int z = 0; z < GRID; ++z)
+    {
+        for (int x = 0; x < GRID; ++x)
+        {
+            int i0 = z * (GRID + 1) + x + 1, i1 = i0 + 1, i2 = i0 + GRID + 1, i3 = i2 + 1;
+            block.append(line, std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                i0, i0, i0, i2, i2, i2, i3, i3, i3, i1, i1, i1));
+            flush(false);
+        }
+    }
+    flush(true);
+    std::fclose(file);
+
+    // GLB with the same grid: positions, normals, uvs and 32-bit indices back to back in the BIN chunk
+    std::vector<Vertex> vertices(VERTICES);
+    for (int z = 0; z <= GRID; ++z)
+        for (int x = 0; x <= GRID; ++x)
+            vertices[z * (GRID + 1) + x] = vertexAt(x, z);
+    std::vector<std::uint32_t> indices;
+    indices.reserve(size_t(GRID) * GRID * 6);
+    for (int z = 0; z < GRID; ++z)
+    {
+        for (int x = 0; x < GRID; ++x)
+        {
+            std::uint32_t i0 = z * (GRID + 1) + x, i1 = i0 + 1, i2 = i0 + GRID + 1, i3 = i2 + 1;
+            indices.insert(indices.end(), { i0, i2, i3, i0, i3, i1 });
+        }
+    }
+    const size_t vertexBytes = vertices.size() * sizeof(Vertex);
+    const size_t indexBytes = indices.size() * sizeof(std::uint32_t);
+    std::snprintf(line, sizeof(line), "%d", VERTICES);
+    std::string vertexCount = line;
+    std::string json = std::string("{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":") + std::to_string(vertexBytes + indexBytes) + "}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(vertexBytes) + ",\"byteStride\":" + std::to_string(sizeof(Vertex)) + "},"
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexBytes) + ",\"byteLength\":" + std::to_string(indexBytes) + "}],"
+        "\"accessors\":[{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":" + vertexCount + ",\"type\":\"VEC3\"},"
+        "{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":" + vertexCount + ",\"type\":\"VEC3\"},"
+        "{\"bufferView\":0,\"byteOffset\":24,\"componentType\":5126,\"count\":" + vertexCount + ",\"type\":\"VEC2\"},"
+        "{\"bufferView\":1,\"componentType\":5125,\"count\":" + std::to_string(indices.size()) + ",\"type\":\"SCALAR\"}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}]}";
+    while (json.size() % 4)
+        json += ' ';
+    file = std::fopen(glbFile, "wb");
+    if (!file)
+    {
+        std::cout << "MeshImporter benchmark: unable to write " << glbFile << std::endl;
+        std::remove(objFile);
+        return;
+    }
+    auto writeU32 = [file](std::uint32_t value)
+    {
+        unsigned char bytes[4] = { static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+            static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24) };
+        std::fwrite(bytes, 1, 4, file);
+    };
+    writeU32(GLB_MAGIC);
+    writeU32(2);
+    writeU32(std::uint32_t(12 + 8 + json.size() + 8 + vertexBytes + indexBytes));
+    writeU32(std::uint32_t(json.size()));
+    writeU32(GLB_CHUNK_JSON);
+    std::fwrite(json.data(), 1, json.size(), file);
+    writeU32(std::uint32_t(vertexBytes + indexBytes));
+    writeU32(GLB_CHUNK_BIN);
+    std::fwrite(vertices.data(), 1, vertexBytes, file);
+    std::fwrite(indices.data(), 1, indexBytes, file);
+    std::fclose(file);
+
+    JobSystem jobs;
+    std::cout << "MeshImporter benchmark, " << indices.size() / 3 << " triangle grid, budget "
+        << BUDGET_MS_PER_MILLION_TRIANGLES << " ms per million triangles" << std::endl;
+    for (const char* fileName: { objFile, glbFile })
+    {
+        for (int threaded = 0; threaded < 2; ++threaded)
+        {
+            MeshImporter importer(threaded ? &jobs : nullptr);
+            Mesh mesh;
+            if (!importer.Load(fileName, mesh))
+            {
+                std::cout << "  " << importer.GetError() << std::endl;
+                continue;
+            }
+            double budget = BUDGET_MS_PER_MILLION_TRIANGLES * mesh.GetTriangleCount() / 1e6;
+            std::cout << "  " << fileName << " x" << (threaded ? jobs.GetThreadCount() : 1) << ": read " << importer.GetReadMilliseconds()
+                << " ms, parse " << importer.GetParseMilliseconds() << " ms, weld " << importer.GetWeldMilliseconds() << " ms, "
+                << mesh.vertices.size() << " vertices, " << mesh.GetTriangleCount() << " triangles"
+                << (importer.GetTotalMilliseconds() > budget ? "  OVER BUDGET" : "") << std::endl;
+        }
+    }
+    std::remove(objFile);
+    std::remove(glbFile);
+}
+
+bool MeshImporter::RunTests()
+{
+    SelfTest test("MeshImporter");
+
+    // 32769 vertex lines of 32 bytes put the last vertex and the face after the first 1MB chunk,
+    // the face's relative indices reach back into the first chunk
+    const char* objFile = "mesh_import_test.obj";
+    const int VERTEX_COUNT = 32769;
+    auto writeObj = [objFile](int vertexCount, const char* face)
+    {
+        FILE* file = std::fopen(objFile, "wb");
+        if (!file)
+            return false;
+        char line[64];
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            int length = std::snprintf(line, sizeof(line), "v %10d %10d 0.00000\n", i, i);
+            std::fwrite(line, 1, size_t(length), file);
+        }
+        std::fputs(face, file);
+        std::fclose(file);
+        return true;
+    };
+    MeshImporter importer;
+    Mesh mesh;
+    if (writeObj(VERTEX_COUNT, "f -3 -2 -1\n"))
+    {
+        test.Check(importer.Load(objFile, mesh), "relative indices across a chunk boundary load");
+        test.Check(mesh.indices.size() == 3 && mesh.vertices.size() == 3 &&
+            mesh.vertices[mesh.indices[0]].position.x == float(VERTEX_COUNT - 3) &&
+            mesh.vertices[mesh.indices[1]].position.x == float(VERTEX_COUNT - 2) &&
+            mesh.vertices[mesh.indices[2]].position.x == float(VERTEX_COUNT - 1),
+            "relative indices across a chunk boundary resolve to the last three vertices");
+    }
+    if (writeObj(VERTEX_COUNT, "f 1 -1 -32769\n"))
+    {
+        test.Check(importer.Load(objFile, mesh) && mesh.vertices[mesh.indices[2]].position.x == 0.0f,
+            "relative index back to the first vertex of the file");
+    }
+    if (writeObj(3, "f -4 -2 -1\n"))
+        test.Check(!importer.Load(objFile, mesh), "relative index before the first vertex is rejected");
+    if (writeObj(VERTEX_COUNT, "f -32770 -2 -1\n"))
+        test.Check(!importer.Load(objFile, mesh), "relative index before the first vertex of an earlier chunk is rejected");
+    std::remove(objFile);
+
+    // glTF numbers are doubles, offsets above 2^24 stay exact and fractions or negatives are not sizes
+    const std::string json = "{\"byteOffset\":67108868,\"count\":16777217,\"half\":1.5,\"negative\":-4,\"huge\":1e300}";
+    JsonValue value;
+    size_t size = 0;
+    test.Check(JsonParser(json.data(), json.data() + json.size()).Parse(value), "JSON parses");
+    test.Check(value["byteOffset"].AsSize(size) && size == 67108868, "byte offset above 2^24 is exact");
+    test.Check(value["count"].AsSize(size) && size == 16777217, "count above 2^24 is exact");
+    test.Check(!value["half"].AsSize(size), "fraction is not a size");
+    test.Check(!value["negative"].AsSize(size), "negative number is not a size");
+    test.Check(!value["huge"].AsSize(size) && value["huge"].AsInt(-1) == -1, "number above 2^53 is not a size or an int");
+    test.Check(value["missing"].AsSize(size, 7) && size == 7, "absent member takes the fallback");
+
+    return test.Finish();
+}
@@ -0,0 +1,70 @@
+#ifndef MESH_IMPORTER_HPP
+#define MESH_IMPORTER_HPP
+
+#include <functional>
+#include <string>
+
+#include "Mesh.hpp"
+
+class JobSystem;
+
+// Loads Wavefront OBJ and binary glTF 2.0 (.glb) files into an interleaved Mesh ready for upload.
+// Files are read with a single fread. OBJ text is split at line boundaries into chunks that are
+// parsed in parallel with a hand written number parser, then (position, uv, normal) triples are
+// welded into unique vertices through an open addressing hash map. GLB accessors are converted
+// in parallel vertex ranges.
+class MeshImporter
+{
+public:
+
+    // Import time the benchmark is expected to stay under for every million triangles
+    static constexpr double BUDGET_MS_PER_MILLION_TRIANGLES = 1500.0;
+
+    // jobs may be nullptr, then parsing runs on the calling thread
+    explicit MeshImporter(JobSystem* jobs = nullptr);
+
+    // Picks the format from the extension
+    bool Load(const std::string& fileName, Mesh& mesh);
+
+    bool LoadOBJ(const std::string& fileName, Mesh& mesh);
+
+    // Every triangle primitive of the first mesh, node transforms are not applied
+    bool LoadGLB(const std::string& fileName, Mesh& mesh);
+
+    const std::string& GetError() const;
+
+    // Timings of the last load
+    double GetReadMilliseconds() const;
+
+    double GetParseMilliseconds() const;
+
+    double GetWeldMilliseconds() const;
+
+    double GetTotalMilliseconds() const;
+
+    // Writes and imports a generated ~1M triangle grid in both formats
+    static void RunBenchmark();
+
+    // Checks relative OBJ indices across parse chunks and large glTF byte offsets, prints the
+    // failures and returns false if there is any
+    static bool RunTests();
+
+private:
+
+    bool ReadFile(const std::string& fileName, std::string& contents);
+
+    void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+
+private:
+
+    JobSystem* m_jobs;
+
+    std::string m_error;
+
+    double m_readMilliseconds;
+
+    double m_parseMilliseconds;
+
+    double m_weldMilliseconds;
+};
+#endif
@@ -0,0 +1,207 @@
+#include "MeshLOD.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+MeshLOD::MeshLOD():m_vao{0}, m_vbo{0}, m_ebo{0}, m_buildMilliseconds{0.0}
+{
+
+}
+
+MeshLOD::~MeshLOD()
+{
+    if (m_vao)
+    {
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_ebo);
+    }
+}
+
+void MeshLOD::Build(const Mesh& mesh, int levelCount)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    m_mesh = mesh;
+    m_indices = mesh.indices;
+    m_levels.clear();
+    m_levels.push_back(Level{ 0, mesh.indices.size(), 0.0f });
+
+    // One simplifier for the whole chain so the quadrics keep measuring against the original
+    MeshSimplifier simplifier(mesh);
+    std::vector<std::uint32_t> indices;
+    levelCount = std::min(levelCount, int(MAX_LEVELS));
+    while (int(m_levels.size()) < levelCount)
+    {
+        size_t previous = m_levels.back().indexCount / 3;
+        float error = simplifier.Simplify(previous / 2);
+        if (simplifier.GetTriangleCount() >= previous || simplifier.GetTriangleCount() == 0)
+            break;
+        simplifier.GetIndices(indices);
+        m_levels.push_back(Level{ m_indices.size(), indices.size(), error });
+        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+    }
+
+    m_buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MeshLOD::Upload()
+{
+    if (!m_vao)
+    {
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vbo);
+        glGenBuffers(1, &m_ebo);
+    }
+    glBindVertexArray(m_vao);
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, m_mesh.vertices.size() * sizeof(Vertex), m_mesh.vertices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, uv));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(std::uint32_t), m_indices.data(), GL_STATIC_DRAW);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_positionTransform = glm::mat4();
+}
+
+void MeshLOD::Upload(const CompressedVertices& vertices)
+{
+    if (!m_vao)
+    {
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vbo);
+        glGenBuffers(1, &m_ebo);
+    }
+    glBindVertexArray(m_vao);
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.data.size(), vertices.data.data(), GL_STATIC_DRAW);
+        VertexCompressor::SetupAttributes(vertices.format);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(std::uint32_t), m_indices.data(), GL_STATIC_DRAW);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_positionTransform = vertices.GetPositionTransform();
+}
+
+const Mesh& MeshLOD::GetMesh() const
+{
+    return m_mesh;
+}
+
+const glm::mat4& MeshLOD::GetPositionTransform() const
+{
+    return m_positionTransform;
+}
+
+int MeshLOD::GetLevelCount() const
+{
+    return int(m_levels.size());
+}
+
+size_t MeshLOD::GetTriangleCount(int level) const
+{
+    return m_levels[level].indexCount / 3;
+}
+
+float MeshLOD::GetError(int level) const
+{
+    return m_levels[level].error;
+}
+
+GLuint MeshLOD::GetVAO() const
+{
+    return m_vao;
+}
+
+GLsizei MeshLOD::GetIndexCount(int level) const
+{
+    return GLsizei(m_levels[level].indexCount);
+}
+
+GLsizeiptr MeshLOD::GetIndexOffset(int level) const
+{
+    return GLsizeiptr(m_levels[level].firstIndex * sizeof(std::uint32_t));
+}
+
+const AABB& MeshLOD::GetBounds() const
+{
+    return m_mesh.bounds;
+}
+
+int MeshLOD::SelectLevel(float distance, float pixelsPerUnit, float maxPixelError, int currentLevel) const
+{
+    const float scale = pixelsPerUnit / std::max(distance, 1e-4f);
+    currentLevel = glm::clamp(currentLevel, 0, GetLevelCount() - 1);
+
+    // Errors grow with the level, so the first level over a limit ends the search
+    auto coarsestUnder = [&](float limit)
+    {
+        int level = 0;
+        while (level + 1 < GetLevelCount() && m_levels[level + 1].error * scale <= limit)
+            level++;
+        return level;
+    };
+
+    if (m_levels[currentLevel].error * scale > maxPixelError)
+        return coarsestUnder(maxPixelError);
+    return std::max(currentLevel, coarsestUnder(maxPixelError * (1.0f - HYSTERESIS)));
+}
+
+double MeshLOD::GetBuildMilliseconds() const
+{
+    return m_buildMilliseconds;
+}
+
+void MeshLOD::RunBenchmark()
+{
+    const int FIELD = 32;
+    const float SPACING = 3.0f;
+    const float SCREEN_HEIGHT = 600.0f;
+    const float MAX_PIXEL_ERROR = 1.0f;
+
+    MeshLOD lod;
+    lod.Build(Mesh::CreateSphere(1.0f, 64, 128), 6);
+
+    std::cout << "MeshLOD benchmark, " << FIELD << "x" << FIELD << " spheres, built " << lod.GetLevelCount()
+        << " levels in " << lod.GetBuildMilliseconds() << " ms" << std::endl;
+    for (int level = 0; level < lod.GetLevelCount(); ++level)
+        std::cout << "  level " << level << ": " << lod.GetTriangleCount(level) << " triangles, error " << lod.GetError(level) << std::endl;
+
+    // The camera backs away along the field's diagonal, the whole field stays in view
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+    const float pixelsPerUnit = projection[1][1] * SCREEN_HEIGHT * 0.5f;
+    std::vector<int> levels(FIELD * FIELD, 0);
+    for (float height = 10.0f; height <= 640.0f; height *= 2.0f)
+    {
+        glm::vec3 eye(0.0f, height, height);
+        size_t full = 0, selected = 0;
+        for (int z = 0; z < FIELD; ++z)
+        {
+            for (int x = 0; x < FIELD; ++x)
+            {
+                glm::vec3 center((x - FIELD / 2) * SPACING, 0.0f, (z - FIELD / 2) * SPACING);
+                int& level = levels[z * FIELD + x];
+                level = lod.SelectLevel(glm::length(center - eye) - 1.0f, pixelsPerUnit, MAX_PIXEL_ERROR, level);
+                full += lod.GetTriangleCount(0);
+                selected += lod.GetTriangleCount(level);
+            }
+        }
+        std::cout << "  distance " << glm::length(eye) << ": " << full << " triangles without LOD, " << selected << " with" << std::endl;
+    }
+}
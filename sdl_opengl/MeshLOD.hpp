@@ -0,0 +1,99 @@
+#ifndef MESH_LOD_HPP
+#define MESH_LOD_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Mesh.hpp"
+#include "VertexCompression.hpp"
+
+// Discrete levels of detail of one mesh. Levels are generated at load time with MeshSimplifier,
+// each with about half the triangles of the previous one, and share a single vertex buffer; only
+// their index ranges differ. A level is selected by how many pixels its simplification error
+// covers on screen, with a hysteresis band so objects near a threshold do not flicker.
+class MeshLOD
+{
+public:
+
+    static const int MAX_LEVELS = 8;
+
+    // Switch to a coarser level only once its error is this much below the threshold
+    static constexpr float HYSTERESIS = 0.25f;
+
+    MeshLOD();
+
+    ~MeshLOD();
+
+    MeshLOD(const MeshLOD&) = delete;
+    MeshLOD& operator=(const MeshLOD&) = delete;
+
+    // CPU only. Stops early when the simplifier cannot reach the next target.
+    void Build(const Mesh& mesh, int levelCount);
+
+    // Creates the VAO (attribute 0 position, 1 normal, 2 uv) and the shared vertex/index buffers
+    void Upload();
+
+    // Same as Upload() with vertices encoded from GetMesh(). Multiply the model matrix by
+    // GetPositionTransform() when the positions are quantized.
+    void Upload(const CompressedVertices& vertices);
+
+    const Mesh& GetMesh() const;
+
+    // Identity unless the uploaded positions are quantized
+    const glm::mat4& GetPositionTransform() const;
+
+    int GetLevelCount() const;
+
+    size_t GetTriangleCount(int level) const;
+
+    // Object space distance to the original surface
+    float GetError(int level) const;
+
+    GLuint GetVAO() const;
+
+    GLsizei GetIndexCount(int level) const;
+
+    // Byte offset into the element buffer
+    GLsizeiptr GetIndexOffset(int level) const;
+
+    const AABB& GetBounds() const;
+
+    // pixelsPerUnit is the screen size in pixels of one unit at distance one, i.e.
+    // projection[1][1] * screenHeight / 2. Returns the coarsest level whose error stays under
+    // maxPixelError, keeping currentLevel while it is within the hysteresis band.
+    int SelectLevel(float distance, float pixelsPerUnit, float maxPixelError, int currentLevel) const;
+
+    double GetBuildMilliseconds() const;
+
+    // Triangles submitted for a sphere field seen from increasing distances, with and without LOD
+    static void RunBenchmark();
+
+private:
+
+    struct Level
+    {
+        size_t firstIndex;
+        size_t indexCount;
+        float error;
+    };
+
+    Mesh m_mesh;
+
+    // All levels, concatenated
+    std::vector<std::uint32_t> m_indices;
+
+    std::vector<Level> m_levels;
+
+    GLuint m_vao;
+
+    GLuint m_vbo;
+
+    GLuint m_ebo;
+
+    glm::mat4 m_positionTransform;
+
+    double m_buildMilliseconds;
+};
+#endif
@@ -0,0 +1,336 @@
+#include "MeshSimplifier.hpp"
+#include "SelfTest.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+    // Constraint planes along open borders, relative to the face planes
+    const double BORDER_WEIGHT = 100.0;
+
+    // Collapses that turn a face normal by more than ~80 degrees are rejected
+    const float MIN_NORMAL_DOT = 0.2f;
+
+    std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+    {
+        return a < b ? (std::uint64_t(a) << 32) | b : (std::uint64_t(b) << 32) | a;
+    }
+}
+
+MeshSimplifier::Quadric::Quadric():m{}
+{
+
+}
+
+MeshSimplifier::Quadric::Quadric(const glm::dvec3& n, double d, double weight)
+{
+    m[0] = n.x * n.x * weight; m[1] = n.x * n.y * weight; m[2] = n.x * n.z * weight; m[3] = n.x * d * weight;
+    m[4] = n.y * n.y * weight; m[5] = n.y * n.z * weight; m[6] = n.y * d * weight;
+    m[7] = n.z * n.z * weight; m[8] = n.z * d * weight;
+    m[9] = d * d * weight;
+}
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& other)
+{
+    for (int i = 0; i < 10; ++i)
+        m[i] += other.m[i];
+    return *this;
+}
+
+double MeshSimplifier::Quadric::Evaluate(const glm::vec3& p) const
+{
+    const double x = p.x, y = p.y, z = p.z;
+    return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x
+         + m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y
+         + m[7] * z * z + 2.0 * m[8] * z
+         + m[9];
+}
+
+MeshSimplifier::MeshSimplifier(const Mesh& mesh):
+    m_positions(mesh.vertices.size()), m_indices(mesh.indices), m_faceRemoved(mesh.GetTriangleCount(), false),
+    m_vertexFaces(mesh.vertices.size()), m_vertexRemoved(mesh.vertices.size(), false), m_quadrics(mesh.vertices.size()),
+    m_versions(mesh.vertices.size(), 0), m_triangleCount{mesh.GetTriangleCount()}, m_maxError{0.0f}
+{
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+        m_positions[i] = mesh.vertices[i].position;
+
+    // Face planes, and how many faces use every edge
+    std::unordered_map<std::uint64_t, int> edgeUse;
+    for (size_t face = 0; face < m_triangleCount; ++face)
+    {
+        const std::uint32_t* tri = &m_indices[face * 3];
+        glm::dvec3 p0 = glm::dvec3(m_positions[tri[0]]), p1 = glm::dvec3(m_positions[tri[1]]), p2 = glm::dvec3(m_positions[tri[2]]);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(normal);
+        if (length > 0.0)
+        {
+            normal /= length;
+            Quadric plane(normal, -glm::dot(normal, p0), 1.0);
+            for (int k = 0; k < 3; ++k)
+                m_quadrics[tri[k]] += plane;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            m_vertexFaces[tri[k]].push_back(std::uint32_t(face));
+            edgeUse[EdgeKey(tri[k], tri[(k + 1) % 3])]++;
+        }
+    }
+
+    // Borders: a plane through the edge, perpendicular to its only face
+    for (size_t face = 0; face < m_triangleCount; ++face)
+    {
+        const std::uint32_t* tri = &m_indices[face * 3];
+        glm::dvec3 p0 = glm::dvec3(m_positions[tri[0]]), p1 = glm::dvec3(m_positions[tri[1]]), p2 = glm::dvec3(m_positions[tri[2]]);
+        glm::dvec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+        for (int k = 0; k < 3; ++k)
+        {
+            std::uint32_t a = tri[k], b = tri[(k + 1) % 3];
+            if (edgeUse[EdgeKey(a, b)] != 1)
+                continue;
+            glm::dvec3 pa = glm::dvec3(m_positions[a]);
+            glm::dvec3 normal = glm::cross(glm::dvec3(m_positions[b]) - pa, faceNormal);
+            double length = glm::length(normal);
+            if (length == 0.0)
+                continue;
+            normal /= length;
+            Quadric plane(normal, -glm::dot(normal, pa), BORDER_WEIGHT);
+            m_quadrics[a] += plane;
+            m_quadrics[b] += plane;
+        }
+    }
+
+    for (auto& edge: edgeUse)
+        PushEdge(std::uint32_t(edge.first >> 32), std::uint32_t(edge.first & 0xFFFFFFFFu));
+}
+
+float MeshSimplifier::Simplify(size_t targetTriangles)
+{
+    while (m_triangleCount > targetTriangles && !m_queue.empty())
+    {
+        Collapse collapse = m_queue.top();
+        m_queue.pop();
+        if (m_vertexRemoved[collapse.from] || m_vertexRemoved[collapse.to] ||
+            m_versions[collapse.from] != collapse.fromVersion || m_versions[collapse.to] != collapse.toVersion)
+            continue;
+        // Dropped for now, it is queued again when a neighbour collapse changes the area
+        if (CausesFlip(collapse.from, collapse.to) || BreaksLink(collapse.from, collapse.to))
+            continue;
+
+        m_maxError = std::max(m_maxError, float(std::sqrt(std::max(collapse.cost, 0.0))));
+        CollapseEdge(collapse.from, collapse.to);
+    }
+    return m_maxError;
+}
+
+size_t MeshSimplifier::GetTriangleCount() const
+{
+    return m_triangleCount;
+}
+
+void MeshSimplifier::GetIndices(std::vector<std::uint32_t>& indices) const
+{
+    indices.clear();
+    indices.reserve(m_triangleCount * 3);
+    for (size_t face = 0; face < m_faceRemoved.size(); ++face)
+    {
+        if (!m_faceRemoved[face])
+            indices.insert(indices.end(), m_indices.begin() + face * 3, m_indices.begin() + face * 3 + 3);
+    }
+}
+
+void MeshSimplifier::PushEdge(std::uint32_t a, std::uint32_t b)
+{
+    // Half edge collapse: try both directions, the merged quadric is evaluated at the kept vertex
+    Quadric merged = m_quadrics[a];
+    merged += m_quadrics[b];
+    double toB = merged.Evaluate(m_positions[b]);
+    double toA = merged.Evaluate(m_positions[a]);
+    if (toB <= toA)
+        m_queue.push(Collapse{ toB, a, b, m_versions[a], m_versions[b] });
+    else
+        m_queue.push(Collapse{ toA, b, a, m_versions[b], m_versions[a] });
+}
+
+bool MeshSimplifier::CausesFlip(std::uint32_t from, std::uint32_t to) const
+{
+    for (std::uint32_t face: m_vertexFaces[from])
+    {
+        if (m_faceRemoved[face])
+            continue;
+        const std::uint32_t* tri = &m_indices[face * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+            continue;
+
+        glm::vec3 before[3], after[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            before[k] = m_positions[tri[k]];
+            after[k] = tri[k] == from ? m_positions[to] : before[k];
+        }
+        glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+        float oldLength = glm::length(oldNormal), newLength = glm::length(newNormal);
+        if (newLength == 0.0f || glm::dot(oldNormal, newNormal) < MIN_NORMAL_DOT * oldLength * newLength)
+            return true;
+    }
+    return false;
+}
+
+bool MeshSimplifier::BreaksLink(std::uint32_t from, std::uint32_t to) const
+{
+    std::vector<std::uint32_t> fromNeighbours;
+    size_t sharedFaces = 0;
+    for (std::uint32_t face: m_vertexFaces[from])
+    {
+        if (m_faceRemoved[face])
+            continue;
+        const std::uint32_t* tri = &m_indices[face * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+            sharedFaces++;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (tri[k] != from && tri[k] != to && std::find(fromNeighbours.begin(), fromNeighbours.end(), tri[k]) == fromNeighbours.end())
+                fromNeighbours.push_back(tri[k]);
+        }
+    }
+
+    // Every face on the edge brings one opposite vertex, two inside the mesh and one on a border
+    std::vector<std::uint32_t> common;
+    for (std::uint32_t face: m_vertexFaces[to])
+    {
+        if (m_faceRemoved[face])
+            continue;
+        const std::uint32_t* tri = &m_indices[face * 3];
+        for (int k = 0; k < 3; ++k)
+        {
+            if (std::find(fromNeighbours.begin(), fromNeighbours.end(), tri[k]) != fromNeighbours.end() &&
+                std::find(common.begin(), common.end(), tri[k]) == common.end())
+                common.push_back(tri[k]);
+        }
+    }
+    return common.size() > sharedFaces;
+}
+
+void MeshSimplifier::CollapseEdge(std::uint32_t from, std::uint32_t to)
+{
+    for (std::uint32_t face: m_vertexFaces[from])
+    {
+        if (m_faceRemoved[face])
+            continue;
+        std::uint32_t* tri = &m_indices[face * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+        {
+            m_faceRemoved[face] = true;
+            m_triangleCount--;
+            continue;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            if (tri[k] == from)
+                tri[k] = to;
+        }
+        m_vertexFaces[to].push_back(face);
+    }
+    m_vertexRemoved[from] = true;
+    m_vertexFaces[from].clear();
+    m_quadrics[to] += m_quadrics[from];
+    m_versions[to]++;
+
+    // Drop dead faces and requeue every edge around the kept vertex with its new quadric
+    std::vector<std::uint32_t>& faces = m_vertexFaces[to];
+    faces.erase(std::remove_if(faces.begin(), faces.end(), [this](std::uint32_t face) { return m_faceRemoved[face]; }), faces.end());
+    std::vector<std::uint32_t> neighbours;
+    for (std::uint32_t face: faces)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            std::uint32_t v = m_indices[face * 3 + k];
+            if (v != to && std::find(neighbours.begin(), neighbours.end(), v) == neighbours.end())
+                neighbours.push_back(v);
+        }
+    }
+    for (std::uint32_t v: neighbours)
+        PushEdge(to, v);
+}
+
+bool MeshSimplifier::RunTests()
+{
+    SelfTest test("MeshSimplifier");
+
+    // Closed torus, 32 x 16 quads. Its thin tube is where collapses pinch the surface first.
+    const int RINGS = 32;
+    const int SIDES = 16;
+    Mesh torus;
+    for (int ring = 0; ring < RINGS; ++ring)
+    {
+        for (int side = 0; side < SIDES; ++side)
+        {
+            float u = ring * glm::two_pi<float>() / RINGS;
+            float v = side * glm::two_pi<float>() / SIDES;
+            Vertex vertex;
+            vertex.position = glm::vec3((1.0f + 0.3f * std::cos(v)) * std::cos(u), 0.3f * std::sin(v), (1.0f + 0.3f * std::cos(v)) * std::sin(u));
+            torus.vertices.push_back(vertex);
+        }
+    }
+    for (int ring = 0; ring < RINGS; ++ring)
+    {
+        for (int side = 0; side < SIDES; ++side)
+        {
+            std::uint32_t i00 = ring * SIDES + side;
+            std::uint32_t i10 = ((ring + 1) % RINGS) * SIDES + side;
+            std::uint32_t i11 = ((ring + 1) % RINGS) * SIDES + (side + 1) % SIDES;
+            std::uint32_t i01 = ring * SIDES + (side + 1) % SIDES;
+            torus.indices.insert(torus.indices.end(), { i00, i01, i11, i00, i11, i10 });
+        }
+    }
+
+    // Every edge in exactly two faces, once in each direction, and V - E + F = 0 for a torus
+    auto isClosedTorus = [](const std::vector<std::uint32_t>& indices)
+    {
+        std::map<std::pair<std::uint32_t, std::uint32_t>, int> edges;
+        std::vector<std::uint32_t> used(indices);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                std::uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if (a == b)
+                    return false;
+                edges[std::make_pair(a, b)]++;
+            }
+        }
+        for (auto& edge: edges)
+        {
+            if (edge.second != 1 || edges.count(std::make_pair(edge.first.second, edge.first.first)) == 0)
+                return false;
+        }
+        std::sort(used.begin(), used.end());
+        used.erase(std::unique(used.begin(), used.end()), used.end());
+        return long(used.size()) - long(edges.size() / 2) + long(indices.size() / 3) == 0;
+    };
+    test.Check(isClosedTorus(torus.indices), "the generated torus is closed");
+
+    MeshSimplifier simplifier(torus);
+    const size_t triangles = torus.GetTriangleCount();
+    std::vector<std::uint32_t> indices;
+    for (size_t target: { triangles / 4, triangles / 16, triangles / 32 })
+    {
+        simplifier.Simplify(target);
+        simplifier.GetIndices(indices);
+        test.Check(simplifier.GetTriangleCount() <= target, "the torus simplifies down to the target");
+        test.Check(isClosedTorus(indices), "the simplified torus stays a closed manifold of genus 1");
+    }
+
+    // Far below what a torus can be made of, the link condition stops the collapses first
+    simplifier.Simplify(8);
+    simplifier.GetIndices(indices);
+    test.Check(simplifier.GetTriangleCount() > 8, "collapses stop before the tube is pinched");
+    test.Check(isClosedTorus(indices), "the fully simplified torus stays a closed manifold of genus 1");
+
+    return test.Finish();
+}
@@ -0,0 +1,100 @@
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+
+// Quadric error metric decimation (Garland & Heckbert). Edges are collapsed onto one of their end
+// points, so every simplified level still indexes the original vertex array and all levels of a
+// mesh can share one vertex buffer. Open borders (including texture seams) get heavily weighted
+// constraint planes so the outline is kept.
+class MeshSimplifier
+{
+public:
+
+    explicit MeshSimplifier(const Mesh& mesh);
+
+    // Collapses edges until at most targetTriangles remain or no collapse is possible without
+    // flipping a triangle or pinching the surface into a non-manifold edge. Can be called
+    // repeatedly with decreasing targets. Returns the largest collapse error so far, an estimate
+    // of the distance to the original surface.
+    float Simplify(size_t targetTriangles);
+
+    size_t GetTriangleCount() const;
+
+    // Remaining triangles, indexing the original vertices
+    void GetIndices(std::vector<std::uint32_t>& indices) const;
+
+    // Simplifies a closed torus and checks it stays a closed manifold of genus 1, false when a check fails
+    static bool RunTests();
+
+private:
+
+    // Symmetric 4x4 matrix, upper triangle
+    struct Quadric
+    {
+        double m[10];
+
+        Quadric();
+
+        // Squared distance to the plane dot(normal, p) + d = 0, times weight
+        Quadric(const glm::dvec3& normal, double d, double weight);
+
+        Quadric& operator+=(const Quadric& other);
+
+        double Evaluate(const glm::vec3& p) const;
+    };
+
+    struct Collapse
+    {
+        double cost;
+        std::uint32_t from;
+        std::uint32_t to;
+        std::uint32_t fromVersion;
+        std::uint32_t toVersion;
+
+        bool operator>(const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    void PushEdge(std::uint32_t a, std::uint32_t b);
+
+    bool CausesFlip(std::uint32_t from, std::uint32_t to) const;
+
+    // Link condition: the end points may only share the vertices opposite the edge, any other
+    // common neighbour would be pinched into a non-manifold edge
+    bool BreaksLink(std::uint32_t from, std::uint32_t to) const;
+
+    void CollapseEdge(std::uint32_t from, std::uint32_t to);
+
+private:
+
+    std::vector<glm::vec3> m_positions;
+
+    std::vector<std::uint32_t> m_indices;
+
+    std::vector<bool> m_faceRemoved;
+
+    std::vector<std::vector<std::uint32_t>> m_vertexFaces;
+
+    std::vector<bool> m_vertexRemoved;
+
+    std::vector<Quadric> m_quadrics;
+
+    // Bumped on every change so stale queue entries can be recognized
+    std::vector<std::uint32_t> m_versions;
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_queue;
+
+    size_t m_triangleCount;
+
+    float m_maxError;
+};
+#endif
@@ -0,0 +1,172 @@
+#include "OcclusionCuller.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+OcclusionCuller::OcclusionCuller():
+    m_proxyVAO{0}, m_proxyVertexCount{0}, m_proxyModelLoc{-1}, m_queryActive{false},
+    m_visibleCount{0}, m_conditionalCount{0}, m_culledCount{0}
+{
+
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (auto& object: m_objects)
+        glDeleteQueries(QUERY_SLOTS, object.queries);
+}
+
+bool OcclusionCuller::Init(GLuint proxyVAO, GLsizei proxyVertexCount)
+{
+    if (!m_proxyProgram.InitWithFiles("vertex_shade_lighting.vs", "fragment_shader_depth.frag"))
+    {
+        m_error = m_proxyProgram.GetError();
+        return false;
+    }
+    m_proxyModelLoc = glGetUniformLocation(m_proxyProgram.GetProgram(), "model");
+    m_proxyVAO = proxyVAO;
+    m_proxyVertexCount = proxyVertexCount;
+    return true;
+}
+
+const std::string& OcclusionCuller::GetError() const
+{
+    return m_error;
+}
+
+void OcclusionCuller::BeginFrame()
+{
+    m_visibleCount = 0;
+    m_conditionalCount = 0;
+    m_culledCount = 0;
+
+    // Queries complete in order, so stop at the first one that is not ready
+    for (auto& object: m_objects)
+    {
+        while (object.count > 0)
+        {
+            GLuint query = object.queries[object.first];
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint anySamples = GL_FALSE;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &anySamples);
+            object.visible = anySamples != GL_FALSE;
+            object.first = (object.first + 1) % QUERY_SLOTS;
+            object.count--;
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(int id) const
+{
+    return id < 0 || size_t(id) >= m_objects.size() || m_objects[id].visible;
+}
+
+void OcclusionCuller::BeginVisibleDraw(int id)
+{
+    m_visibleCount++;
+    m_queryActive = BeginQuery(GetObject(id));
+}
+
+void OcclusionCuller::EndVisibleDraw()
+{
+    if (m_queryActive)
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    m_queryActive = false;
+}
+
+GLuint OcclusionCuller::GetConditionQuery(int id)
+{
+    // Called before the proxy pass, so anything in flight was issued in an earlier frame
+    ObjectState& object = GetObject(id);
+    if (object.count == 0)
+    {
+        m_culledCount++;
+        return 0;
+    }
+    m_conditionalCount++;
+    return object.queries[(object.first + object.count - 1) % QUERY_SLOTS];
+}
+
+void OcclusionCuller::BeginProxyPass(const glm::mat4& view, const glm::mat4& projection)
+{
+    m_cameraPosition = glm::vec3(glm::inverse(view)[3]);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+
+    m_proxyProgram.Use();
+    GLuint program = m_proxyProgram.GetProgram();
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glBindVertexArray(m_proxyVAO);
+}
+
+void OcclusionCuller::TestBounds(int id, const AABB& bounds)
+{
+    ObjectState& object = GetObject(id);
+
+    // The near plane would clip the proxy's front faces and the back faces could be hidden behind
+    // the object itself, so a camera inside the (slightly grown) box always sees the object
+    glm::vec3 margin(0.2f);
+    if (AABB(bounds.min - margin, bounds.max + margin).Contains(m_cameraPosition))
+    {
+        object.visible = true;
+        return;
+    }
+
+    if (!BeginQuery(object))
+        return;
+    glm::mat4 model = glm::translate(glm::mat4(), bounds.GetCenter());
+    model = glm::scale(model, bounds.GetExtents() * 2.0f);
+    glUniformMatrix4fv(m_proxyModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glDrawArrays(GL_TRIANGLES, 0, m_proxyVertexCount);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+}
+
+void OcclusionCuller::EndProxyPass()
+{
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+int OcclusionCuller::GetVisibleCount() const
+{
+    return m_visibleCount;
+}
+
+int OcclusionCuller::GetConditionalCount() const
+{
+    return m_conditionalCount;
+}
+
+int OcclusionCuller::GetCulledCount() const
+{
+    return m_culledCount;
+}
+
+OcclusionCuller::ObjectState& OcclusionCuller::GetObject(int id)
+{
+    while (m_objects.size() <= size_t(id))
+    {
+        ObjectState object;
+        glGenQueries(QUERY_SLOTS, object.queries);
+        object.first = 0;
+        object.count = 0;
+        object.visible = true;
+        m_objects.push_back(object);
+    }
+    return m_objects[id];
+}
+
+bool OcclusionCuller::BeginQuery(ObjectState& object)
+{
+    if (object.count == QUERY_SLOTS)
+        return false;
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, object.queries[(object.first + object.count) % QUERY_SLOTS]);
+    object.count++;
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "GLProgram.hpp"
+
+// Hardware occlusion culling with GL_ANY_SAMPLES_PASSED queries. Objects are identified by a small
+// integer id that stays the same across frames. Visible objects wrap their real draw in a query,
+// occluded ones have their bounding box rendered as a proxy. Results are only read once available,
+// one or two frames late, so the CPU never waits: an occluded object whose last query is still in
+// flight is drawn under glBeginConditionalRender, one with a resolved query is skipped.
+class OcclusionCuller
+{
+public:
+
+    OcclusionCuller();
+
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // The proxy is a unit cube centered at the origin drawn with glDrawArrays
+    bool Init(GLuint proxyVAO, GLsizei proxyVertexCount);
+
+    const std::string& GetError() const;
+
+    // Collects finished query results without waiting and resets the per frame counters
+    void BeginFrame();
+
+    // Last known result, objects never tested are visible
+    bool IsVisible(int id) const;
+
+    // Wraps the draw of a visible object so it is noticed when it becomes hidden
+    void BeginVisibleDraw(int id);
+
+    void EndVisibleDraw();
+
+    // For an occluded object: the in flight query to condition its draw on, or 0 when the object is
+    // known to be hidden and is culled for this frame
+    GLuint GetConditionQuery(int id);
+
+    // Renders the bounds of occluded objects with color and depth writes off, after the opaque pass
+    void BeginProxyPass(const glm::mat4& view, const glm::mat4& projection);
+
+    void TestBounds(int id, const AABB& bounds);
+
+    void EndProxyPass();
+
+    // Counters of the last frame
+    int GetVisibleCount() const;
+
+    int GetConditionalCount() const;
+
+    int GetCulledCount() const;
+
+private:
+
+    static const int QUERY_SLOTS = 2;
+
+    struct ObjectState
+    {
+        GLuint queries[QUERY_SLOTS];
+        // Ring of in flight queries, oldest first
+        int first;
+        int count;
+        bool visible;
+    };
+
+    ObjectState& GetObject(int id);
+
+    // Starts a query in the next free slot, false when all slots are in flight
+    bool BeginQuery(ObjectState& object);
+
+private:
+
+    std::vector<ObjectState> m_objects;
+
+    GLProgram m_proxyProgram;
+
+    GLuint m_proxyVAO;
+
+    GLsizei m_proxyVertexCount;
+
+    GLint m_proxyModelLoc;
+
+    glm::vec3 m_cameraPosition;
+
+    bool m_queryActive;
+
+    int m_visibleCount;
+
+    int m_conditionalCount;
+
+    int m_culledCount;
+
+    std::string m_error;
+};
+#endif
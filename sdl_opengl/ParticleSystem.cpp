@@ -0,0 +1,539 @@
+#include "ParticleSystem.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/noise.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    // Grid cells per noise unit, the field repeats every FIELD_SIZE / FIELD_RESOLUTION noise units
+    const float FIELD_RESOLUTION = 4.0f;
+
+    const float PARTICLE_SIZE = 0.02f;
+
+    // Corners of the camera facing quad, drawn as a triangle strip
+    const GLfloat QUAD_CORNERS[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+    // std::floor is a library call without SSE4.1, this is the hot path of the force sampling
+    int FloorToInt(float x)
+    {
+        int i = int(x);
+        return i - (x < float(i) ? 1 : 0);
+    }
+
+    double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+ParticleSystem::ParticleSystem(JobSystem* jobs):
+    m_jobs{jobs}, m_capacity{0}, m_count{0}, m_rng{1234}, m_simd{GLM_ARCH & GLM_ARCH_SSE2_BIT ? true : false},
+    m_vao{0}, m_quadBuffer{0}, m_instanceBuffer{0}, m_uploadedCount{0},
+    m_emitMs{0.0}, m_simulateMs{0.0}, m_compactMs{0.0}, m_uploadMs{0.0}
+{
+
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    if (m_vao)
+    {
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteBuffers(1, &m_quadBuffer);
+        glDeleteBuffers(1, &m_instanceBuffer);
+    }
+}
+
+void ParticleSystem::Init(size_t capacity, const ParticleForces& forces)
+{
+    m_forces = forces;
+    m_capacity = capacity;
+    m_count = 0;
+
+    // Whole chunks so the SIMD loops never need a scalar tail
+    const size_t chunks = (capacity + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const size_t padded = chunks * CHUNK_SIZE;
+    for (auto array: { &m_posX, &m_posY, &m_posZ, &m_velX, &m_velY, &m_velZ, &m_life })
+        array->assign(padded, 0.0f);
+    m_lifetime.assign(padded, 1.0f);
+    m_chunkLive.assign(chunks, 0);
+
+    BakeField();
+}
+
+bool ParticleSystem::InitGL()
+{
+    if (!m_program.InitWithFiles("vertex_shader_particles.vs", "fragment_shader_particles.frag"))
+    {
+        m_error = m_program.GetError();
+        return false;
+    }
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_quadBuffer);
+    glGenBuffers(1, &m_instanceBuffer);
+
+    glBindVertexArray(m_vao);
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_quadBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+
+        // Position and remaining life fraction, one vec4 per particle
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+const std::string& ParticleSystem::GetError() const
+{
+    return m_error;
+}
+
+size_t ParticleSystem::AddEmitter(const ParticleEmitter& emitter)
+{
+    m_emitters.push_back(emitter);
+    return m_emitters.size() - 1;
+}
+
+ParticleEmitter& ParticleSystem::GetEmitter(size_t index)
+{
+    return m_emitters[index];
+}
+
+void ParticleSystem::Update(float dt)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto& emitter: m_emitters)
+        Emit(emitter, dt);
+    m_emitMs = ElapsedMs(start);
+
+    // Integration also packs the live particles to the front of their chunk while they are in cache
+    start = std::chrono::high_resolution_clock::now();
+    const size_t chunks = (m_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    if (m_jobs)
+    {
+        m_jobs->ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; ++chunk)
+                SimulateChunk(chunk, dt);
+        });
+    }
+    else
+    {
+        for (size_t chunk = 0; chunk < chunks; ++chunk)
+            SimulateChunk(chunk, dt);
+    }
+    m_simulateMs = ElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    Compact();
+    m_compactMs = ElapsedMs(start);
+}
+
+void ParticleSystem::Upload()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // GL 3.3 has no persistent mapping: orphan the old storage so the driver does not wait for the
+    // previous frame's draw, then map the new one write only
+    const size_t bytes = std::max<size_t>(m_count * 4 * sizeof(float), 16);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    m_uploadedCount = 0;
+    if (m_count)
+    {
+        float* out = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (out)
+        {
+            if (m_jobs)
+                m_jobs->ParallelFor(m_count, 16384, [&](size_t begin, size_t end) { WriteInstances(out, begin, end); });
+            else
+                WriteInstances(out, 0, m_count);
+            // The contents are undefined when unmapping fails (e.g. a mode switch), skip the frame
+            if (glUnmapBuffer(GL_ARRAY_BUFFER))
+                m_uploadedCount = m_count;
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_uploadMs = ElapsedMs(start);
+}
+
+void ParticleSystem::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+    m_drawTimer.Begin();
+    if (m_uploadedCount)
+    {
+        m_program.Use();
+        GLuint program = m_program.GetProgram();
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(glGetUniformLocation(program, "size"), PARTICLE_SIZE);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(m_vao);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(m_uploadedCount));
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+    m_drawTimer.End();
+}
+
+size_t ParticleSystem::GetCount() const
+{
+    return m_count;
+}
+
+size_t ParticleSystem::GetCapacity() const
+{
+    return m_capacity;
+}
+
+void ParticleSystem::SetSimdEnabled(bool enabled)
+{
+    m_simd = enabled && (GLM_ARCH & GLM_ARCH_SSE2_BIT);
+}
+
+bool ParticleSystem::IsSimdEnabled() const
+{
+    return m_simd;
+}
+
+double ParticleSystem::GetEmitMilliseconds() const
+{
+    return m_emitMs;
+}
+
+double ParticleSystem::GetSimulateMilliseconds() const
+{
+    return m_simulateMs;
+}
+
+double ParticleSystem::GetCompactMilliseconds() const
+{
+    return m_compactMs;
+}
+
+double ParticleSystem::GetUploadMilliseconds() const
+{
+    return m_uploadMs;
+}
+
+double ParticleSystem::GetDrawMilliseconds() const
+{
+    return m_drawTimer.GetMilliseconds();
+}
+
+void ParticleSystem::BakeField()
+{
+    // Three decorrelated noise channels form the vector potential, its curl has no divergence so the
+    // particles swirl without bunching up in sinks
+    const glm::vec3 offsetY(31.4f, 17.9f, 5.3f);
+    const glm::vec3 offsetZ(-11.7f, 43.1f, 27.2f);
+    const float EPSILON = 0.01f;
+    const glm::vec3 dx(EPSILON, 0.0f, 0.0f), dy(0.0f, EPSILON, 0.0f), dz(0.0f, 0.0f, EPSILON);
+
+    auto bakeSlice = [&](size_t z)
+    {
+        for (int y = 0; y < FIELD_SIZE; ++y)
+        {
+            for (int x = 0; x < FIELD_SIZE; ++x)
+            {
+                glm::vec3 p = glm::vec3(float(x), float(y), float(z)) / FIELD_RESOLUTION;
+                float dPzdy = glm::simplex(p + offsetZ + dy) - glm::simplex(p + offsetZ - dy);
+                float dPydz = glm::simplex(p + offsetY + dz) - glm::simplex(p + offsetY - dz);
+                float dPxdz = glm::simplex(p + dz) - glm::simplex(p - dz);
+                float dPzdx = glm::simplex(p + offsetZ + dx) - glm::simplex(p + offsetZ - dx);
+                float dPydx = glm::simplex(p + offsetY + dx) - glm::simplex(p + offsetY - dx);
+                float dPxdy = glm::simplex(p + dy) - glm::simplex(p - dy);
+                m_field[(z * FIELD_SIZE + y) * FIELD_SIZE + x] = glm::vec4(dPzdy - dPydz, dPxdz - dPzdx, dPydx - dPxdy, 0.0f) / (2.0f * EPSILON);
+            }
+        }
+    };
+
+    m_field.resize(FIELD_SIZE * FIELD_SIZE * FIELD_SIZE);
+    if (m_jobs)
+    {
+        m_jobs->ParallelFor(FIELD_SIZE, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t z = begin; z < end; ++z)
+                bakeSlice(z);
+        });
+    }
+    else
+    {
+        for (size_t z = 0; z < FIELD_SIZE; ++z)
+            bakeSlice(z);
+    }
+}
+
+glm::vec3 ParticleSystem::SampleField(float x, float y, float z) const
+{
+    const float scale = m_forces.curlFrequency * FIELD_RESOLUTION;
+    x *= scale;
+    y *= scale;
+    z *= scale;
+    const int ix = FloorToInt(x), iy = FloorToInt(y), iz = FloorToInt(z);
+    const float tx = x - float(ix), ty = y - float(iy), tz = z - float(iz);
+
+    // FIELD_SIZE is a power of two, the mask wraps negative cells too
+    const int MASK = FIELD_SIZE - 1;
+    const int x0 = ix & MASK, x1 = (ix + 1) & MASK;
+    const int y0 = (iy & MASK) * FIELD_SIZE, y1 = ((iy + 1) & MASK) * FIELD_SIZE;
+    const glm::vec4* c0 = &m_field[(iz & MASK) * FIELD_SIZE * FIELD_SIZE];
+    const glm::vec4* c1 = &m_field[((iz + 1) & MASK) * FIELD_SIZE * FIELD_SIZE];
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    if (m_simd)
+    {
+        // One corner per register, the 7 lerps run on all three components at once
+        auto lerp = [](__m128 a, __m128 b, __m128 t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)); };
+        auto load = [](const glm::vec4* cells, int index) { return _mm_loadu_ps(&cells[index].x); };
+        const __m128 wx = _mm_set1_ps(tx), wy = _mm_set1_ps(ty), wz = _mm_set1_ps(tz);
+        __m128 c00 = lerp(load(c0, y0 + x0), load(c0, y0 + x1), wx);
+        __m128 c10 = lerp(load(c0, y1 + x0), load(c0, y1 + x1), wx);
+        __m128 c01 = lerp(load(c1, y0 + x0), load(c1, y0 + x1), wx);
+        __m128 c11 = lerp(load(c1, y1 + x0), load(c1, y1 + x1), wx);
+        glm::vec4 result;
+        _mm_storeu_ps(&result.x, lerp(lerp(c00, c10, wy), lerp(c01, c11, wy), wz));
+        return glm::vec3(result);
+    }
+#endif
+    glm::vec4 c00 = glm::mix(c0[y0 + x0], c0[y0 + x1], tx);
+    glm::vec4 c10 = glm::mix(c0[y1 + x0], c0[y1 + x1], tx);
+    glm::vec4 c01 = glm::mix(c1[y0 + x0], c1[y0 + x1], tx);
+    glm::vec4 c11 = glm::mix(c1[y1 + x0], c1[y1 + x1], tx);
+    return glm::vec3(glm::mix(glm::mix(c00, c10, ty), glm::mix(c01, c11, ty), tz));
+}
+
+void ParticleSystem::Emit(ParticleEmitter& emitter, float dt)
+{
+    emitter.accumulator += emitter.rate * dt;
+    size_t spawn = size_t(emitter.accumulator);
+    emitter.accumulator -= float(spawn);
+    spawn = std::min(spawn, m_capacity - m_count);
+
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (size_t n = 0; n < spawn; ++n, ++m_count)
+    {
+        glm::vec3 offset;
+        do
+        {
+            offset = glm::vec3(unit(m_rng), unit(m_rng), unit(m_rng));
+        } while (glm::dot(offset, offset) > 1.0f);
+
+        const size_t i = m_count;
+        m_posX[i] = emitter.position.x + offset.x * emitter.radius;
+        m_posY[i] = emitter.position.y + offset.y * emitter.radius;
+        m_posZ[i] = emitter.position.z + offset.z * emitter.radius;
+        m_velX[i] = emitter.velocity.x + unit(m_rng) * emitter.spread;
+        m_velY[i] = emitter.velocity.y + unit(m_rng) * emitter.spread;
+        m_velZ[i] = emitter.velocity.z + unit(m_rng) * emitter.spread;
+        m_lifetime[i] = emitter.lifetime * (1.0f + 0.25f * unit(m_rng));
+        m_life[i] = m_lifetime[i];
+    }
+}
+
+void ParticleSystem::SimulateChunk(size_t chunk, float dt)
+{
+    const size_t first = chunk * CHUNK_SIZE;
+    const size_t last = std::min(first + CHUNK_SIZE, m_count);
+    const float damping = std::max(1.0f - m_forces.drag * dt, 0.0f);
+    const glm::vec3 gravity = m_forces.gravity * dt;
+    const float curl = m_forces.curlStrength * dt;
+
+    float forceX[BATCH_SIZE], forceY[BATCH_SIZE], forceZ[BATCH_SIZE];
+    for (size_t batch = first; batch < last; batch += BATCH_SIZE)
+    {
+        // The field lookups are gathers, they stay scalar
+        const size_t count = std::min(last - batch, size_t(BATCH_SIZE));
+        for (size_t j = 0; j < count; ++j)
+        {
+            glm::vec3 force = SampleField(m_posX[batch + j], m_posY[batch + j], m_posZ[batch + j]);
+            forceX[j] = force.x;
+            forceY[j] = force.y;
+            forceZ[j] = force.z;
+        }
+        for (size_t j = count; j < BATCH_SIZE && (j & 3); ++j)
+            forceX[j] = forceY[j] = forceZ[j] = 0.0f;
+
+        // v = v * damping + (gravity + curl force) * dt, p += v * dt, life -= dt
+        size_t j = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        if (m_simd)
+        {
+            const __m128 damping4 = _mm_set1_ps(damping), curl4 = _mm_set1_ps(curl), dt4 = _mm_set1_ps(dt);
+            const __m128 gravityX = _mm_set1_ps(gravity.x), gravityY = _mm_set1_ps(gravity.y), gravityZ = _mm_set1_ps(gravity.z);
+            // The pool is padded to whole chunks, lanes past the last particle are harmless
+            for (; j < count; j += 4)
+            {
+                const size_t i = batch + j;
+                __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_velX[i]), damping4), _mm_add_ps(gravityX, _mm_mul_ps(_mm_loadu_ps(&forceX[j]), curl4)));
+                __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_velY[i]), damping4), _mm_add_ps(gravityY, _mm_mul_ps(_mm_loadu_ps(&forceY[j]), curl4)));
+                __m128 vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_velZ[i]), damping4), _mm_add_ps(gravityZ, _mm_mul_ps(_mm_loadu_ps(&forceZ[j]), curl4)));
+                _mm_storeu_ps(&m_velX[i], vx);
+                _mm_storeu_ps(&m_velY[i], vy);
+                _mm_storeu_ps(&m_velZ[i], vz);
+                _mm_storeu_ps(&m_posX[i], _mm_add_ps(_mm_loadu_ps(&m_posX[i]), _mm_mul_ps(vx, dt4)));
+                _mm_storeu_ps(&m_posY[i], _mm_add_ps(_mm_loadu_ps(&m_posY[i]), _mm_mul_ps(vy, dt4)));
+                _mm_storeu_ps(&m_posZ[i], _mm_add_ps(_mm_loadu_ps(&m_posZ[i]), _mm_mul_ps(vz, dt4)));
+                _mm_storeu_ps(&m_life[i], _mm_sub_ps(_mm_loadu_ps(&m_life[i]), dt4));
+            }
+        }
+#endif
+        for (; j < count; ++j)
+        {
+            const size_t i = batch + j;
+            m_velX[i] = m_velX[i] * damping + (gravity.x + forceX[j] * curl);
+            m_velY[i] = m_velY[i] * damping + (gravity.y + forceY[j] * curl);
+            m_velZ[i] = m_velZ[i] * damping + (gravity.z + forceZ[j] * curl);
+            m_posX[i] += m_velX[i] * dt;
+            m_posY[i] += m_velY[i] * dt;
+            m_posZ[i] += m_velZ[i] * dt;
+            m_life[i] -= dt;
+        }
+    }
+
+    // Keep the order of the survivors so the particles do not flicker between draw orders
+    size_t live = first;
+    for (size_t i = first; i < last; ++i)
+    {
+        if (m_life[i] <= 0.0f)
+            continue;
+        if (live != i)
+        {
+            m_posX[live] = m_posX[i];
+            m_posY[live] = m_posY[i];
+            m_posZ[live] = m_posZ[i];
+            m_velX[live] = m_velX[i];
+            m_velY[live] = m_velY[i];
+            m_velZ[live] = m_velZ[i];
+            m_life[live] = m_life[i];
+            m_lifetime[live] = m_lifetime[i];
+        }
+        live++;
+    }
+    m_chunkLive[chunk] = live - first;
+}
+
+void ParticleSystem::Compact()
+{
+    // Moves each chunk's survivors down behind the previous chunk's, memmove as the ranges can overlap
+    const size_t chunks = (m_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    size_t count = 0;
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        const size_t first = chunk * CHUNK_SIZE;
+        const size_t live = m_chunkLive[chunk];
+        if (count != first && live)
+        {
+            for (auto array: { &m_posX, &m_posY, &m_posZ, &m_velX, &m_velY, &m_velZ, &m_life, &m_lifetime })
+                std::memmove(&(*array)[count], &(*array)[first], live * sizeof(float));
+        }
+        count += live;
+    }
+    m_count = count;
+}
+
+void ParticleSystem::WriteInstances(float* out, size_t begin, size_t end) const
+{
+    size_t i = begin;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    if (m_simd)
+    {
+        // Transposes 4 particles into 4 interleaved vec4, whole 16 byte stores suit write combined memory
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&m_posX[i]);
+            __m128 y = _mm_loadu_ps(&m_posY[i]);
+            __m128 z = _mm_loadu_ps(&m_posZ[i]);
+            __m128 w = _mm_div_ps(_mm_loadu_ps(&m_life[i]), _mm_loadu_ps(&m_lifetime[i]));
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(out + i * 4 + 0, x);
+            _mm_storeu_ps(out + i * 4 + 4, y);
+            _mm_storeu_ps(out + i * 4 + 8, z);
+            _mm_storeu_ps(out + i * 4 + 12, w);
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        out[i * 4 + 0] = m_posX[i];
+        out[i * 4 + 1] = m_posY[i];
+        out[i * 4 + 2] = m_posZ[i];
+        out[i * 4 + 3] = m_life[i] / m_lifetime[i];
+    }
+}
+
+void ParticleSystem::RunBenchmark()
+{
+    const size_t CAPACITY = 1 << 20;
+    const float LIFETIME = 4.0f;
+    const float DT = 1.0f / 50.0f;
+    const int FRAMES = 20;
+
+    JobSystem jobs;
+    std::vector<float> instances(CAPACITY * 4);
+
+    std::cout << "ParticleSystem benchmark, " << CAPACITY << " particles, average of " << FRAMES << " frames" << std::endl;
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            ParticleSystem particles(threaded ? &jobs : nullptr);
+            particles.SetSimdEnabled(simd != 0);
+            if (simd && !particles.IsSimdEnabled())
+                continue;
+            particles.Init(CAPACITY);
+
+            // Emits faster than the particles die, so the pool stays full once warmed up
+            ParticleEmitter emitter;
+            emitter.radius = 1.0f;
+            emitter.velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+            emitter.rate = CAPACITY / LIFETIME * 1.25f;
+            emitter.lifetime = LIFETIME;
+            particles.AddEmitter(emitter);
+            for (float time = 0.0f; time < LIFETIME * 1.5f; time += 0.25f)
+                particles.Update(0.25f);
+
+            double emit = 0.0, simulate = 0.0, compact = 0.0, pack = 0.0;
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                particles.Update(DT);
+                emit += particles.GetEmitMilliseconds();
+                simulate += particles.GetSimulateMilliseconds();
+                compact += particles.GetCompactMilliseconds();
+
+                // The CPU side of Upload(), into ordinary memory instead of a mapped buffer
+                auto start = std::chrono::high_resolution_clock::now();
+                if (threaded)
+                    jobs.ParallelFor(particles.GetCount(), 16384, [&](size_t begin, size_t end) { particles.WriteInstances(instances.data(), begin, end); });
+                else
+                    particles.WriteInstances(instances.data(), 0, particles.GetCount());
+                pack += ElapsedMs(start);
+            }
+            std::cout << "  " << (simd ? "simd  " : "scalar") << " x" << (threaded ? jobs.GetThreadCount() : 1) << "  "
+                << particles.GetCount() << " live, emit " << emit / FRAMES << " ms, simulate " << simulate / FRAMES
+                << " ms, compact " << compact / FRAMES << " ms, pack " << pack / FRAMES << " ms" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef PARTICLE_SYSTEM_HPP
+#define PARTICLE_SYSTEM_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLProgram.hpp"
+#include "GPUTimer.hpp"
+
+class JobSystem;
+
+// Spawns particles at a constant rate inside a sphere
+struct ParticleEmitter
+{
+    glm::vec3 position;
+    float radius = 0.1f;
+    // Initial velocity, each component jittered by +-spread
+    glm::vec3 velocity;
+    float spread = 0.5f;
+    // Particles per second
+    float rate = 1000.0f;
+    // Seconds, jittered by +-25%
+    float lifetime = 4.0f;
+
+    // Fractional particles carried over to the next frame
+    float accumulator = 0.0f;
+};
+
+// Applied to every particle
+struct ParticleForces
+{
+    glm::vec3 gravity = glm::vec3(0.0f, -0.5f, 0.0f);
+    // Fraction of the velocity lost per second
+    float drag = 0.5f;
+    // Acceleration along the curl noise field
+    float curlStrength = 2.0f;
+    // Noise features per world unit
+    float curlFrequency = 0.25f;
+};
+
+// CPU simulated particles drawn as camera facing quads with one instanced draw. Particles live in a
+// fixed capacity pool stored as structure of arrays, integrated 4 at a time with SSE2 in parallel
+// chunks and compacted so the live ones are always [0, count). The divergence free force field is
+// the curl of a simplex noise potential, baked once into a repeating grid and sampled trilinearly.
+class ParticleSystem
+{
+public:
+
+    // jobs may be nullptr, then the simulation runs on the calling thread
+    explicit ParticleSystem(JobSystem* jobs = nullptr);
+
+    ~ParticleSystem();
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    // Allocates the pool and bakes the force field, emission stops once capacity particles are alive
+    void Init(size_t capacity, const ParticleForces& forces = ParticleForces());
+
+    // Creates the shader and buffers, needs a current GL context
+    bool InitGL();
+
+    const std::string& GetError() const;
+
+    size_t AddEmitter(const ParticleEmitter& emitter);
+
+    ParticleEmitter& GetEmitter(size_t index);
+
+    // Emits, integrates and removes the dead particles. Does not touch GL.
+    void Update(float dt);
+
+    // Streams the live particles into a fresh (orphaned) instance buffer
+    void Upload();
+
+    // Additive blending, depth tested against the scene but not written
+    void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+    size_t GetCount() const;
+
+    size_t GetCapacity() const;
+
+    void SetSimdEnabled(bool enabled);
+
+    bool IsSimdEnabled() const;
+
+    // CPU phases of the last Update() and Upload(), GPU time of the last available Draw()
+    double GetEmitMilliseconds() const;
+
+    double GetSimulateMilliseconds() const;
+
+    double GetCompactMilliseconds() const;
+
+    double GetUploadMilliseconds() const;
+
+    double GetDrawMilliseconds() const;
+
+    // Prints the per phase times of a steady state 1M particle system
+    static void RunBenchmark();
+
+private:
+
+    static const int FIELD_SIZE = 32;
+    // Particles per simulation and compaction chunk, a multiple of 4
+    static const size_t CHUNK_SIZE = 16384;
+    // Particles per force sampling batch inside a chunk
+    static const size_t BATCH_SIZE = 256;
+
+    void BakeField();
+
+    glm::vec3 SampleField(float x, float y, float z) const;
+
+    void Emit(ParticleEmitter& emitter, float dt);
+
+    void SimulateChunk(size_t chunk, float dt);
+
+    void Compact();
+
+    void WriteInstances(float* out, size_t begin, size_t end) const;
+
+private:
+
+    JobSystem* m_jobs;
+
+    ParticleForces m_forces;
+
+    std::vector<ParticleEmitter> m_emitters;
+
+    size_t m_capacity;
+
+    size_t m_count;
+
+    // The pool: SoA attributes with capacity rounded up to a whole chunk
+    std::vector<float> m_posX, m_posY, m_posZ;
+
+    std::vector<float> m_velX, m_velY, m_velZ;
+
+    // Remaining and initial lifetime in seconds
+    std::vector<float> m_life, m_lifetime;
+
+    // Live particles left in each chunk by SimulateChunk, before they are moved together
+    std::vector<size_t> m_chunkLive;
+
+    // FIELD_SIZE^3 curl vectors padded to 16 bytes, x fastest
+    std::vector<glm::vec4> m_field;
+
+    std::mt19937 m_rng;
+
+    bool m_simd;
+
+    GLProgram m_program;
+
+    GLuint m_vao;
+
+    GLuint m_quadBuffer;
+
+    GLuint m_instanceBuffer;
+
+    // Particles in the instance buffer, m_count may have changed since Upload()
+    size_t m_uploadedCount;
+
+    GPUTimer m_drawTimer;
+
+    double m_emitMs, m_simulateMs, m_compactMs, m_uploadMs;
+
+    std::string m_error;
+};
+#endif
@@ -0,0 +1,165 @@
+#include "PostEffects.hpp"
+
+#include <algorithm>
+
+Bloom::Bloom():
+    m_levels{0}, m_threshold{1.0f}, m_knee{0.5f}, m_intensity{0.5f}
+{
+    std::fill(m_mips, m_mips + MAX_LEVELS, nullptr);
+}
+
+bool Bloom::Init(int levels)
+{
+    if (levels < 1 || levels > MAX_LEVELS)
+    {
+        m_error = "Bloom needs 1 to " + std::to_string(MAX_LEVELS) + " levels";
+        return false;
+    }
+    if (!m_downsampleProgram.InitWithFiles("vertex_shader_fullscreen.vs", "fragment_shader_bloom_downsample.frag"))
+    {
+        m_error = m_downsampleProgram.GetError();
+        return false;
+    }
+    if (!m_upsampleProgram.InitWithFiles("vertex_shader_fullscreen.vs", "fragment_shader_bloom_upsample.frag"))
+    {
+        m_error = m_upsampleProgram.GetError();
+        return false;
+    }
+    if (!m_compositeProgram.InitWithFiles("vertex_shader_fullscreen.vs", "fragment_shader_bloom_composite.frag"))
+    {
+        m_error = m_compositeProgram.GetError();
+        return false;
+    }
+    m_levels = levels;
+    return true;
+}
+
+const std::string& Bloom::GetError() const
+{
+    return m_error;
+}
+
+void Bloom::SetThreshold(float threshold, float knee)
+{
+    m_threshold = threshold;
+    m_knee = std::max(knee, 0.0f);
+}
+
+void Bloom::SetIntensity(float intensity)
+{
+    m_intensity = intensity;
+}
+
+int Bloom::GetLevelCount() const
+{
+    return m_levels;
+}
+
+void Bloom::Apply(const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain)
+{
+    RenderTargetPool& pool = chain.GetPool();
+    int levels = 0;
+    int width = input.width;
+    int height = input.height;
+    while (levels < m_levels && width > 1 && height > 1)
+    {
+        width /= 2;
+        height /= 2;
+        m_mips[levels] = pool.Acquire(width, height, GL_RGBA16F);
+        if (!m_mips[levels])
+            break;
+        levels++;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    if (levels > 0)
+    {
+        m_downsampleProgram.Use();
+        GLuint program = m_downsampleProgram.GetProgram();
+        glUniform1i(glGetUniformLocation(program, "source"), 0);
+        glUniform1f(glGetUniformLocation(program, "threshold"), m_threshold);
+        glUniform1f(glGetUniformLocation(program, "knee"), m_knee);
+        GLint prefilterLoc = glGetUniformLocation(program, "prefilter");
+        GLint texelSizeLoc = glGetUniformLocation(program, "texelSize");
+        const RenderTarget* source = &input;
+        for (int i = 0; i < levels; ++i)
+        {
+            chain.BindTarget(m_mips[i]);
+            glBindTexture(GL_TEXTURE_2D, source->texture);
+            glUniform1i(prefilterLoc, i == 0);
+            glUniform2f(texelSizeLoc, 1.0f / source->width, 1.0f / source->height);
+            chain.DrawFullscreen();
+            source = m_mips[i];
+        }
+
+        // Each level is added into the one above it, which ends up with the sum of all the blurs
+        m_upsampleProgram.Use();
+        program = m_upsampleProgram.GetProgram();
+        glUniform1i(glGetUniformLocation(program, "source"), 0);
+        texelSizeLoc = glGetUniformLocation(program, "texelSize");
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (int i = levels - 1; i > 0; --i)
+        {
+            chain.BindTarget(m_mips[i - 1]);
+            glBindTexture(GL_TEXTURE_2D, m_mips[i]->texture);
+            glUniform2f(texelSizeLoc, 1.0f / m_mips[i]->width, 1.0f / m_mips[i]->height);
+            chain.DrawFullscreen();
+            pool.Release(m_mips[i]);
+        }
+        glDisable(GL_BLEND);
+    }
+
+    // Without a pyramid (no target or a tiny input) the input is copied as is
+    chain.BindTarget(output);
+    m_compositeProgram.Use();
+    GLuint program = m_compositeProgram.GetProgram();
+    glUniform1i(glGetUniformLocation(program, "scene"), 0);
+    glUniform1i(glGetUniformLocation(program, "bloom"), 1);
+    glUniform1f(glGetUniformLocation(program, "intensity"), levels > 0 ? m_intensity : 0.0f);
+    glBindTexture(GL_TEXTURE_2D, input.texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, levels > 0 ? m_mips[0]->texture : input.texture);
+    chain.DrawFullscreen();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    if (levels > 0)
+        pool.Release(m_mips[0]);
+}
+
+ToneMapper::ToneMapper():
+    m_exposure{1.0f}
+{
+
+}
+
+bool ToneMapper::Init()
+{
+    if (!m_program.InitWithFiles("vertex_shader_fullscreen.vs", "fragment_shader_tonemap.frag"))
+    {
+        m_error = m_program.GetError();
+        return false;
+    }
+    return true;
+}
+
+const std::string& ToneMapper::GetError() const
+{
+    return m_error;
+}
+
+void ToneMapper::SetExposure(float exposure)
+{
+    m_exposure = exposure;
+}
+
+void ToneMapper::Apply(const RenderTarget& input, const RenderTarget*, PostProcessChain& chain)
+{
+    m_program.Use();
+    GLuint program = m_program.GetProgram();
+    glUniform1i(glGetUniformLocation(program, "hdr"), 0);
+    glUniform1f(glGetUniformLocation(program, "exposure"), m_exposure);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input.texture);
+    chain.DrawFullscreen();
+}
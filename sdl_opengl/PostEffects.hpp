@@ -0,0 +1,87 @@
+#ifndef POST_EFFECTS_HPP
+#define POST_EFFECTS_HPP
+
+#include <string>
+
+#include "GLProgram.hpp"
+#include "PostProcess.hpp"
+
+// Bloom from a mip pyramid: the first downsample keeps what is above the threshold, every level
+// halves the previous one, then the levels are upsampled with a tent filter and added into the
+// next larger one. Wide blurs cost a few small passes instead of large kernels. The pyramid
+// targets come from the chain's pool and go back to it within the pass.
+class Bloom
+{
+public:
+
+    static const int MAX_LEVELS = 8;
+
+    Bloom();
+
+    Bloom(const Bloom&) = delete;
+    Bloom& operator=(const Bloom&) = delete;
+
+    // levels from 1 to MAX_LEVELS, the first is half the input size
+    bool Init(int levels);
+
+    const std::string& GetError() const;
+
+    // Brightness where the bloom starts, with a soft knee of that width around it
+    void SetThreshold(float threshold, float knee);
+
+    void SetIntensity(float intensity);
+
+    int GetLevelCount() const;
+
+    // PostProcessChain::Pass: the input with the bloom added into output
+    void Apply(const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain);
+
+private:
+
+    GLProgram m_downsampleProgram;
+
+    GLProgram m_upsampleProgram;
+
+    GLProgram m_compositeProgram;
+
+    int m_levels;
+
+    float m_threshold;
+
+    float m_knee;
+
+    float m_intensity;
+
+    const RenderTarget* m_mips[MAX_LEVELS];
+
+    std::string m_error;
+};
+
+// Maps the HDR input into [0, 1) with an exposure curve and gamma corrects it
+class ToneMapper
+{
+public:
+
+    ToneMapper();
+
+    ToneMapper(const ToneMapper&) = delete;
+    ToneMapper& operator=(const ToneMapper&) = delete;
+
+    bool Init();
+
+    const std::string& GetError() const;
+
+    void SetExposure(float exposure);
+
+    // PostProcessChain::Pass
+    void Apply(const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain);
+
+private:
+
+    GLProgram m_program;
+
+    float m_exposure;
+
+    std::string m_error;
+};
+#endif
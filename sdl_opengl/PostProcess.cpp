@@ -0,0 +1,323 @@
+#include "PostProcess.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    bool CreateTarget(RenderTarget& target, int width, int height, GLenum format)
+    {
+        target.width = width;
+        target.height = height;
+        target.format = format;
+
+        glGenTextures(1, &target.texture);
+        glBindTexture(GL_TEXTURE_2D, target.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &target.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return status == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void DestroyTarget(RenderTarget& target)
+    {
+        glDeleteFramebuffers(1, &target.fbo);
+        glDeleteTextures(1, &target.texture);
+        target.fbo = 0;
+        target.texture = 0;
+    }
+}
+
+RenderTargetPool::RenderTargetPool():
+    m_budget{64 * 1024 * 1024}, m_allocatedBytes{0}, m_peakBytes{0}, m_createdCount{0}, m_frame{0}
+{
+
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+    while (!m_entries.empty())
+        Destroy(m_entries.size() - 1);
+}
+
+void RenderTargetPool::SetBudget(size_t bytes)
+{
+    m_budget = bytes;
+    EvictOverBudget();
+}
+
+void RenderTargetPool::BeginFrame()
+{
+    m_frame++;
+    for (size_t i = m_entries.size(); i-- > 0;)
+    {
+        if (!m_entries[i]->inUse && m_frame - m_entries[i]->lastUsed > MAX_IDLE_FRAMES)
+            Destroy(i);
+    }
+}
+
+const RenderTarget* RenderTargetPool::Acquire(int width, int height, GLenum format)
+{
+    for (auto& entry: m_entries)
+    {
+        const RenderTarget& target = entry->target;
+        if (!entry->inUse && target.width == width && target.height == height && target.format == format)
+        {
+            entry->inUse = true;
+            entry->lastUsed = m_frame;
+            return &target;
+        }
+    }
+
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->inUse = true;
+    entry->lastUsed = m_frame;
+    if (!CreateTarget(entry->target, width, height, format))
+    {
+        DestroyTarget(entry->target);
+        return nullptr;
+    }
+    m_allocatedBytes += GetBytes(entry->target);
+    m_createdCount++;
+    m_entries.push_back(std::move(entry));
+    // Targets in use are never evicted, they alone may keep the pool over budget
+    EvictOverBudget();
+    m_peakBytes = std::max(m_peakBytes, m_allocatedBytes);
+    return &m_entries.back()->target;
+}
+
+void RenderTargetPool::Release(const RenderTarget* target)
+{
+    for (auto& entry: m_entries)
+    {
+        if (&entry->target == target)
+        {
+            entry->inUse = false;
+            entry->lastUsed = m_frame;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::EvictOverBudget()
+{
+    while (m_allocatedBytes > m_budget)
+    {
+        size_t oldest = m_entries.size();
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            if (!m_entries[i]->inUse && (oldest == m_entries.size() || m_entries[i]->lastUsed < m_entries[oldest]->lastUsed))
+                oldest = i;
+        }
+        if (oldest == m_entries.size())
+            return;
+        Destroy(oldest);
+    }
+}
+
+void RenderTargetPool::Destroy(size_t index)
+{
+    m_allocatedBytes -= GetBytes(m_entries[index]->target);
+    DestroyTarget(m_entries[index]->target);
+    m_entries.erase(m_entries.begin() + index);
+}
+
+size_t RenderTargetPool::GetBytes(const RenderTarget& target)
+{
+    size_t bytesPerPixel = 4;
+    if (target.format == GL_RGBA16F)
+        bytesPerPixel = 8;
+    else if (target.format == GL_RGBA32F)
+        bytesPerPixel = 16;
+    return size_t(target.width) * target.height * bytesPerPixel;
+}
+
+size_t RenderTargetPool::GetTargetCount() const
+{
+    return m_entries.size();
+}
+
+size_t RenderTargetPool::GetAllocatedBytes() const
+{
+    return m_allocatedBytes;
+}
+
+size_t RenderTargetPool::GetPeakBytes() const
+{
+    return m_peakBytes;
+}
+
+size_t RenderTargetPool::GetCreatedCount() const
+{
+    return m_createdCount;
+}
+
+PostProcessChain::PostProcessChain():
+    m_width{0}, m_height{0}, m_sceneDepth{0}, m_emptyVAO{0}
+{
+
+}
+
+PostProcessChain::~PostProcessChain()
+{
+    if (m_scene.fbo)
+    {
+        DestroyTarget(m_scene);
+        glDeleteRenderbuffers(1, &m_sceneDepth);
+        glDeleteVertexArrays(1, &m_emptyVAO);
+    }
+}
+
+bool PostProcessChain::Init(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+
+    if (!CreateTarget(m_scene, width, height, GL_RGBA16F))
+    {
+        m_error = "HDR scene framebuffer is incomplete";
+        return false;
+    }
+    glGenRenderbuffers(1, &m_sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_scene.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_sceneDepth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        m_error = "HDR scene framebuffer is incomplete with its depth buffer";
+        return false;
+    }
+
+    // The full screen triangle is generated from gl_VertexID, a VAO still has to be bound
+    glGenVertexArrays(1, &m_emptyVAO);
+    return true;
+}
+
+const std::string& PostProcessChain::GetError() const
+{
+    return m_error;
+}
+
+void PostProcessChain::AddPass(const std::string& name, GLenum outputFormat, const Pass& pass)
+{
+    std::unique_ptr<PassEntry> entry(new PassEntry());
+    entry->name = name;
+    entry->outputFormat = outputFormat;
+    entry->pass = pass;
+    m_passes.push_back(std::move(entry));
+}
+
+void PostProcessChain::BeginScene()
+{
+    BindTarget(&m_scene);
+}
+
+void PostProcessChain::Execute()
+{
+    m_pool.BeginFrame();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    if (m_passes.empty())
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_scene.fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    const RenderTarget* input = &m_scene;
+    for (size_t i = 0; i < m_passes.size(); ++i)
+    {
+        const RenderTarget* output = nullptr;
+        if (i + 1 < m_passes.size())
+        {
+            output = m_pool.Acquire(m_width, m_height, m_passes[i]->outputFormat);
+            // Out of targets: the passes left in between are skipped, only the last one may draw
+            // into the default framebuffer (an intermediate pass would show untonemapped HDR)
+            if (!output)
+            {
+                m_error = "No render target for post-process pass " + m_passes[i]->name;
+                i = m_passes.size() - 1;
+            }
+        }
+        PassEntry& entry = *m_passes[i];
+
+        entry.timer.Begin();
+        BindTarget(output);
+        entry.pass(*input, output, *this);
+        entry.timer.End();
+
+        if (input != &m_scene)
+            m_pool.Release(input);
+        // Without a target the pass has drawn into the default framebuffer, the chain ends there
+        if (!output)
+            break;
+        input = output;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void PostProcessChain::BindTarget(const RenderTarget* target)
+{
+    if (target)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+        glViewport(0, 0, target->width, target->height);
+    }
+    else
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_width, m_height);
+    }
+}
+
+void PostProcessChain::DrawFullscreen()
+{
+    glBindVertexArray(m_emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+RenderTargetPool& PostProcessChain::GetPool()
+{
+    return m_pool;
+}
+
+int PostProcessChain::GetWidth() const
+{
+    return m_width;
+}
+
+int PostProcessChain::GetHeight() const
+{
+    return m_height;
+}
+
+size_t PostProcessChain::GetPassCount() const
+{
+    return m_passes.size();
+}
+
+const std::string& PostProcessChain::GetPassName(size_t pass) const
+{
+    return m_passes[pass]->name;
+}
+
+double PostProcessChain::GetPassMilliseconds(size_t pass) const
+{
+    return m_passes[pass]->timer.GetMilliseconds();
+}
@@ -0,0 +1,167 @@
+#ifndef POST_PROCESS_HPP
+#define POST_PROCESS_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "GPUTimer.hpp"
+
+// Color texture with its framebuffer, sampled with linear filtering and clamped to the edge
+struct RenderTarget
+{
+    GLuint fbo{ 0 };
+    GLuint texture{ 0 };
+    int width{ 0 };
+    int height{ 0 };
+    GLenum format{ GL_RGBA16F };
+};
+
+// Transient render targets for the post-process passes. A released target goes back to the pool
+// and is handed out again to the next request of the same size and format, so a chain that runs
+// every frame stops allocating after its first frame. Idle targets are deleted once they have not
+// been used for MAX_IDLE_FRAMES frames, or right away (least recently used first) when the pool
+// grows over its budget, so the memory held is bounded by the budget or by the targets in use.
+class RenderTargetPool
+{
+public:
+
+    RenderTargetPool();
+
+    ~RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    void SetBudget(size_t bytes);
+
+    // Call once per frame before the first Acquire(), deletes the targets idle for too long
+    void BeginFrame();
+
+    // Free target of that size and format, created when there is none. nullptr if GL cannot create it.
+    const RenderTarget* Acquire(int width, int height, GLenum format);
+
+    void Release(const RenderTarget* target);
+
+    size_t GetTargetCount() const;
+
+    size_t GetAllocatedBytes() const;
+
+    size_t GetPeakBytes() const;
+
+    // Targets created since the start, stays flat once the passes reuse their targets
+    size_t GetCreatedCount() const;
+
+    static const unsigned MAX_IDLE_FRAMES = 120;
+
+private:
+
+    struct Entry
+    {
+        RenderTarget target;
+        bool inUse;
+        unsigned lastUsed;
+    };
+
+    static size_t GetBytes(const RenderTarget& target);
+
+    void EvictOverBudget();
+
+    void Destroy(size_t index);
+
+    std::vector<std::unique_ptr<Entry>> m_entries;
+
+    size_t m_budget;
+
+    size_t m_allocatedBytes;
+
+    size_t m_peakBytes;
+
+    size_t m_createdCount;
+
+    unsigned m_frame;
+};
+
+// HDR post-process chain: the scene is drawn into a half float target with its own depth buffer,
+// then the passes run in the order they were added. Each pass reads the previous one's output and
+// draws into a target acquired from the pool (the last one draws into the default framebuffer),
+// the input goes back to the pool as soon as the pass is done. Every pass is timed on the GPU.
+class PostProcessChain
+{
+public:
+
+    // Draws input into the bound output. The chain binds output and sets the viewport before the
+    // call, passes that draw elsewhere in between bind it again with BindTarget(output).
+    typedef std::function<void(const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain)> Pass;
+
+    PostProcessChain();
+
+    ~PostProcessChain();
+
+    PostProcessChain(const PostProcessChain&) = delete;
+    PostProcessChain& operator=(const PostProcessChain&) = delete;
+
+    bool Init(int width, int height);
+
+    const std::string& GetError() const;
+
+    // outputFormat is the format of the pass's target, unused for the last pass
+    void AddPass(const std::string& name, GLenum outputFormat, const Pass& pass);
+
+    // Binds the scene target, what is drawn up to Execute() is post-processed
+    void BeginScene();
+
+    // Runs the passes, leaves the default framebuffer bound. When a target cannot be created the
+    // passes before the last are skipped and GetError() tells which one failed.
+    void Execute();
+
+    // Binds the target's framebuffer and sets the viewport to it, nullptr is the default framebuffer
+    void BindTarget(const RenderTarget* target);
+
+    // One triangle covering the viewport, for the program in use
+    void DrawFullscreen();
+
+    RenderTargetPool& GetPool();
+
+    int GetWidth() const;
+
+    int GetHeight() const;
+
+    size_t GetPassCount() const;
+
+    const std::string& GetPassName(size_t pass) const;
+
+    double GetPassMilliseconds(size_t pass) const;
+
+private:
+
+    struct PassEntry
+    {
+        std::string name;
+        GLenum outputFormat;
+        Pass pass;
+        GPUTimer timer;
+    };
+
+private:
+
+    int m_width;
+
+    int m_height;
+
+    RenderTarget m_scene;
+
+    GLuint m_sceneDepth;
+
+    GLuint m_emptyVAO;
+
+    std::vector<std::unique_ptr<PassEntry>> m_passes;
+
+    RenderTargetPool m_pool;
+
+    std::string m_error;
+};
+#endif
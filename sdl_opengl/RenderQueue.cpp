@@ -0,0 +1,321 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    void DrawGeometry(const DrawItem& item)
+    {
+        if (item.indexCount > 0)
+            glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, (GLvoid*)item.indexOffset);
+        else
+            glDrawArrays(GL_TRIANGLES, 0, item.vertexCount);
+    }
+
+    // Replaces the storage with a block of the arena's current frame as large as the last frame needed
+    template <typename T>
+    void MoveToFrame(FrameVector<T>& items, FrameArena* arena)
+    {
+        FrameVector<T> frameItems{ FrameAllocator<T>(arena) };
+        frameItems.reserve(items.size());
+        items = std::move(frameItems);
+    }
+}
+
+RenderQueue::RenderQueue():m_occlusionCuller{nullptr}, m_frameArena{nullptr}, m_depthPrepass{false}, m_samplesQueries{}, m_samplesPixels{}, m_currentQuery{0}, m_overdrawActive{false}, m_overdraw{0.0}
+{
+
+}
+
+RenderQueue::~RenderQueue()
+{
+    if (m_samplesQueries[0])
+        glDeleteQueries(QUERY_LATENCY, m_samplesQueries);
+}
+
+bool RenderQueue::Init()
+{
+    if (!m_depthProgram.InitWithFiles("vertex_shade_lighting.vs", "fragment_shader_depth.frag"))
+    {
+        m_error = m_depthProgram.GetError();
+        return false;
+    }
+    glGenQueries(QUERY_LATENCY, m_samplesQueries);
+    return true;
+}
+
+const std::string& RenderQueue::GetError() const
+{
+    return m_error;
+}
+
+void RenderQueue::Clear()
+{
+    if (!m_frameArena)
+    {
+        m_opaque.clear();
+        m_transparent.clear();
+        return;
+    }
+
+    // Last frame's storage belongs to an older frame of the arena, it is left behind rather than reused
+    MoveToFrame(m_opaque, m_frameArena);
+    MoveToFrame(m_transparent, m_frameArena);
+    MoveToFrame(m_opaqueOrder, m_frameArena);
+    MoveToFrame(m_transparentOrder, m_frameArena);
+    MoveToFrame(m_visibleOrder, m_frameArena);
+    MoveToFrame(m_occludedOrder, m_frameArena);
+}
+
+void RenderQueue::Submit(const DrawItem& item)
+{
+    if (item.opacity < 1.0f)
+        m_transparent.push_back(item);
+    else
+        m_opaque.push_back(item);
+}
+
+void RenderQueue::Sort(const glm::mat4& view)
+{
+    // View space looks down -Z, so depth = -z grows away from the camera
+    auto build = [&view](const FrameVector<DrawItem>& items, FrameVector<SortEntry>& order)
+    {
+        order.resize(items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            glm::vec4 center = view * glm::vec4(items[i].bounds.GetCenter(), 1.0f);
+            order[i].depth = -center.z;
+            order[i].index = i;
+        }
+    };
+    build(m_opaque, m_opaqueOrder);
+    build(m_transparent, m_transparentOrder);
+
+    std::sort(m_opaqueOrder.begin(), m_opaqueOrder.end(), [](const SortEntry& a, const SortEntry& b) { return a.depth < b.depth; });
+    std::sort(m_transparentOrder.begin(), m_transparentOrder.end(), [](const SortEntry& a, const SortEntry& b) { return a.depth > b.depth; });
+}
+
+void RenderQueue::Execute(const glm::mat4& view, const glm::mat4& projection, int viewportPixels, const ProgramSetup& setup)
+{
+    if (m_depthPrepass)
+        DepthPrepass(view, projection);
+
+    BeginOverdrawQuery();
+
+    if (m_depthPrepass)
+    {
+        // Depth is final already, only the visible fragment of every pixel passes
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+    }
+    DrawOpaque(view, projection, setup);
+    if (m_depthPrepass)
+    {
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+    DrawTransparent(view, projection, setup);
+
+    EndOverdrawQuery(viewportPixels);
+}
+
+void RenderQueue::DrawOpaque(const glm::mat4& view, const glm::mat4& projection, const ProgramSetup& setup, GLProgram* overrideProgram)
+{
+    glDisable(GL_BLEND);
+    if (!m_occlusionCuller)
+    {
+        Draw(m_opaqueOrder, m_opaque, view, projection, setup, overrideProgram);
+        return;
+    }
+
+    m_occlusionCuller->BeginFrame();
+    m_visibleOrder.clear();
+    m_occludedOrder.clear();
+    for (auto& entry: m_opaqueOrder)
+    {
+        if (m_occlusionCuller->IsVisible(m_opaque[entry.index].occlusionId))
+            m_visibleOrder.push_back(entry);
+        else
+            m_occludedOrder.push_back(entry);
+    }
+
+    // Visible set first so the proxies are tested against a complete depth buffer
+    Draw(m_visibleOrder, m_opaque, view, projection, setup, overrideProgram);
+    Draw(m_occludedOrder, m_opaque, view, projection, setup, overrideProgram, true);
+
+    m_occlusionCuller->BeginProxyPass(view, projection);
+    for (auto& entry: m_occludedOrder)
+        m_occlusionCuller->TestBounds(m_opaque[entry.index].occlusionId, m_opaque[entry.index].bounds);
+    m_occlusionCuller->EndProxyPass();
+}
+
+void RenderQueue::DrawTransparent(const glm::mat4& view, const glm::mat4& projection, const ProgramSetup& setup)
+{
+    if (m_transparentOrder.empty())
+        return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    Draw(m_transparentOrder, m_transparent, view, projection, setup, nullptr);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
+
+void RenderQueue::BeginOverdrawQuery()
+{
+    // Only one occlusion query may be active at a time, the culler's per object queries win
+    m_overdrawActive = !m_occlusionCuller;
+    if (!m_overdrawActive)
+    {
+        m_overdraw = 0.0;
+        return;
+    }
+
+    // The slot about to be reused was issued QUERY_LATENCY frames ago, so its result is normally ready
+    GLuint query = m_samplesQueries[m_currentQuery];
+    if (m_samplesPixels[m_currentQuery] > 0)
+    {
+        GLuint samples = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+        m_overdraw = double(samples) / m_samplesPixels[m_currentQuery];
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, query);
+}
+
+void RenderQueue::EndOverdrawQuery(int viewportPixels)
+{
+    if (!m_overdrawActive)
+        return;
+    m_overdrawActive = false;
+    glEndQuery(GL_SAMPLES_PASSED);
+    m_samplesPixels[m_currentQuery] = viewportPixels;
+    m_currentQuery = (m_currentQuery + 1) % QUERY_LATENCY;
+}
+
+void RenderQueue::SetOcclusionCuller(OcclusionCuller* culler)
+{
+    m_occlusionCuller = culler;
+}
+
+OcclusionCuller* RenderQueue::GetOcclusionCuller() const
+{
+    return m_occlusionCuller;
+}
+
+void RenderQueue::SetFrameArena(FrameArena* arena)
+{
+    m_frameArena = arena;
+}
+
+void RenderQueue::SetDepthPrepass(bool enabled)
+{
+    m_depthPrepass = enabled;
+}
+
+bool RenderQueue::IsDepthPrepassEnabled() const
+{
+    return m_depthPrepass;
+}
+
+double RenderQueue::GetOverdraw() const
+{
+    return m_overdraw;
+}
+
+size_t RenderQueue::GetOpaqueCount() const
+{
+    return m_opaque.size();
+}
+
+size_t RenderQueue::GetTransparentCount() const
+{
+    return m_transparent.size();
+}
+
+void RenderQueue::DepthPrepass(const glm::mat4& view, const glm::mat4& projection)
+{
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDisable(GL_BLEND);
+
+    m_depthProgram.Use();
+    GLuint program = m_depthProgram.GetProgram();
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    GLint modelLoc = glGetUniformLocation(program, "model");
+
+    GLuint boundVAO = 0;
+    for (auto& entry: m_opaqueOrder)
+    {
+        const DrawItem& item = m_opaque[entry.index];
+        if (item.vao != boundVAO)
+        {
+            glBindVertexArray(item.vao);
+            boundVAO = item.vao;
+        }
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+        DrawGeometry(item);
+    }
+    glBindVertexArray(0);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void RenderQueue::Draw(const FrameVector<SortEntry>& order, const FrameVector<DrawItem>& items, const glm::mat4& view, const glm::mat4& projection,
+    const ProgramSetup& setup, GLProgram* overrideProgram, bool occluded)
+{
+    GLProgram* current = nullptr;
+    GLuint boundVAO = 0;
+    GLint modelLoc = -1, colorLoc = -1, opacityLoc = -1, emissiveLoc = -1;
+
+    for (auto& entry: order)
+    {
+        const DrawItem& item = items[entry.index];
+        GLuint condition = 0;
+        if (occluded)
+        {
+            condition = m_occlusionCuller->GetConditionQuery(item.occlusionId);
+            if (!condition)
+                continue;
+        }
+
+        GLProgram* program = overrideProgram ? overrideProgram : item.program;
+        if (program != current)
+        {
+            current = program;
+            current->Use();
+            GLuint id = current->GetProgram();
+            glUniformMatrix4fv(glGetUniformLocation(id, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(id, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            modelLoc = glGetUniformLocation(id, "model");
+            colorLoc = glGetUniformLocation(id, "objectColor");
+            opacityLoc = glGetUniformLocation(id, "opacity");
+            emissiveLoc = glGetUniformLocation(id, "emissive");
+            if (setup)
+                setup(*current);
+        }
+        if (item.vao != boundVAO)
+        {
+            glBindVertexArray(item.vao);
+            boundVAO = item.vao;
+        }
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+        glUniform3fv(colorLoc, 1, glm::value_ptr(item.color));
+        glUniform1f(opacityLoc, item.opacity);
+        glUniform1f(emissiveLoc, item.emissive ? 1.0f : 0.0f);
+
+        bool queried = !occluded && m_occlusionCuller && item.occlusionId >= 0 && item.opacity >= 1.0f;
+        if (queried)
+            m_occlusionCuller->BeginVisibleDraw(item.occlusionId);
+        if (condition)
+            glBeginConditionalRender(condition, GL_QUERY_NO_WAIT);
+        DrawGeometry(item);
+        if (condition)
+            glEndConditionalRender();
+        if (queried)
+            m_occlusionCuller->EndVisibleDraw();
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,149 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "FrameArena.hpp"
+#include "GLProgram.hpp"
+#include "OcclusionCuller.hpp"
+
+// One draw with its material parameters. Indexed (32-bit indices) when indexCount is set.
+struct DrawItem
+{
+    GLuint vao{ 0 };
+    GLsizei vertexCount{ 0 };
+    GLsizei indexCount{ 0 };
+    // Byte offset into the VAO's element buffer
+    GLsizeiptr indexOffset{ 0 };
+    GLProgram* program{ nullptr };
+    glm::mat4 model;
+    glm::vec3 color{ 1.0f };
+    float opacity{ 1.0f };
+    bool emissive{ false };
+    // Stable id for occlusion culling, -1 for items that are always drawn
+    int occlusionId{ -1 };
+    // World space bounds, used for sorting
+    AABB bounds;
+};
+
+// Splits the frame's draws into an opaque queue (front to back, blending off, optional depth-only
+// pre-pass) and a transparent queue (back to front, blending on, depth writes off), and counts the
+// shaded fragments per pixel (overdraw) with a GL_SAMPLES_PASSED query.
+class RenderQueue
+{
+public:
+
+    // Called whenever a draw switches program, after view/projection are set
+    typedef std::function<void(GLProgram&)> ProgramSetup;
+
+    RenderQueue();
+
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    bool Init();
+
+    const std::string& GetError() const;
+
+    // Starts a new frame. With a frame arena the queues move to the arena's current frame.
+    void Clear();
+
+    // Items with opacity < 1 go to the transparent queue
+    void Submit(const DrawItem& item);
+
+    // Sorts both queues by view depth of the bounds center
+    void Sort(const glm::mat4& view);
+
+    // Depth pre-pass (when enabled), opaque and transparent passes inside an overdraw query
+    void Execute(const glm::mat4& view, const glm::mat4& projection, int viewportPixels, const ProgramSetup& setup);
+
+    // Opaque items only, overrideProgram replaces every item's program (e.g. a G-buffer program)
+    void DrawOpaque(const glm::mat4& view, const glm::mat4& projection, const ProgramSetup& setup, GLProgram* overrideProgram = nullptr);
+
+    void DrawTransparent(const glm::mat4& view, const glm::mat4& projection, const ProgramSetup& setup);
+
+    // Counts the fragments shaded between the two calls, viewportPixels is the divisor of the overdraw factor.
+    // Skipped while an occlusion culler is set, its queries cannot run inside another occlusion query.
+    void BeginOverdrawQuery();
+
+    void EndOverdrawQuery(int viewportPixels);
+
+    // Opaque items with an occlusionId are culled with it, nullptr disables culling
+    void SetOcclusionCuller(OcclusionCuller* culler);
+
+    OcclusionCuller* GetOcclusionCuller() const;
+
+    // Keeps the queues in arena memory instead of the heap, nullptr goes back to the heap
+    void SetFrameArena(FrameArena* arena);
+
+    void SetDepthPrepass(bool enabled);
+
+    bool IsDepthPrepassEnabled() const;
+
+    // Shaded fragments per viewport pixel, read a few frames late, 0 while an occlusion culler is set
+    double GetOverdraw() const;
+
+    size_t GetOpaqueCount() const;
+
+    size_t GetTransparentCount() const;
+
+private:
+
+    struct SortEntry
+    {
+        float depth;
+        size_t index;
+    };
+
+    void DepthPrepass(const glm::mat4& view, const glm::mat4& projection);
+
+    // With occluded == true the items are drawn under conditional rendering or skipped
+    void Draw(const FrameVector<SortEntry>& order, const FrameVector<DrawItem>& items, const glm::mat4& view, const glm::mat4& projection,
+        const ProgramSetup& setup, GLProgram* overrideProgram, bool occluded = false);
+
+private:
+
+    FrameVector<DrawItem> m_opaque;
+
+    FrameVector<DrawItem> m_transparent;
+
+    FrameVector<SortEntry> m_opaqueOrder;
+
+    FrameVector<SortEntry> m_transparentOrder;
+
+    // Opaque order split by the last occlusion results
+    FrameVector<SortEntry> m_visibleOrder;
+
+    FrameVector<SortEntry> m_occludedOrder;
+
+    OcclusionCuller* m_occlusionCuller;
+
+    FrameArena* m_frameArena;
+
+    GLProgram m_depthProgram;
+
+    bool m_depthPrepass;
+
+    static const int QUERY_LATENCY = 3;
+
+    GLuint m_samplesQueries[QUERY_LATENCY];
+
+    int m_samplesPixels[QUERY_LATENCY];
+
+    int m_currentQuery;
+
+    bool m_overdrawActive;
+
+    double m_overdraw;
+
+    std::string m_error;
+};
+#endif
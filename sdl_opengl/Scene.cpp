@@ -0,0 +1,553 @@
+#include "Scene.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+    {
+        glm::mat4 m = glm::mat4_cast(rotation);
+        m[0] *= scale.x;
+        m[1] *= scale.y;
+        m[2] *= scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+
+    double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+Scene::Scene(JobSystem* jobs):
+    m_jobs{jobs}, m_firstDirty{0}, m_firstChanged{0}, m_hierarchyDirty{false}, m_fullUpdate{false}, m_boundsDirty{false},
+    m_updatedCount{0}, m_transformMs{0.0}, m_cullMs{0.0}
+{
+
+}
+
+Entity Scene::Create()
+{
+    if (!m_freeIndices.empty())
+    {
+        std::uint32_t index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+        return Entity{ index, m_generations[index] };
+    }
+    m_generations.push_back(0);
+    return Entity{ std::uint32_t(m_generations.size() - 1), 0 };
+}
+
+void Scene::Destroy(Entity entity)
+{
+    if (!IsAlive(entity))
+        return;
+    Remove<Transform>(entity);
+    Remove<Parent>(entity);
+    Remove<MeshRef>(entity);
+    Remove<Material>(entity);
+    Remove<Bounds>(entity);
+    Remove<Light>(entity);
+    m_generations[entity.index]++;
+    m_freeIndices.push_back(entity.index);
+}
+
+bool Scene::IsAlive(Entity entity) const
+{
+    // A free index already carries the generation of its next entity, no handle to it exists yet
+    return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation;
+}
+
+size_t Scene::GetEntityCount() const
+{
+    return m_generations.size() - m_freeIndices.size();
+}
+
+template <typename Fn>
+void Scene::ForEachChunk(size_t count, const Fn& fn)
+{
+    if (m_jobs)
+        m_jobs->ParallelFor(count, CHUNK_SIZE / 4, fn);
+    else
+        fn(0, count);
+}
+
+void Scene::ComponentsChanged(const Transform*)
+{
+    m_hierarchyDirty = true;
+}
+
+void Scene::ComponentsChanged(const Parent*)
+{
+    m_hierarchyDirty = true;
+}
+
+void Scene::ComponentsChanged(const Bounds*)
+{
+    m_boundsDirty = true;
+}
+
+void Scene::MarkDirty(Entity entity)
+{
+    const std::uint32_t slot = GetPool<Transform>().IndexOf(entity);
+    if (slot == ComponentPool<Transform>::INVALID)
+    {
+        m_boundsDirty = true;
+        return;
+    }
+    // The slots are only valid once the hierarchy is rebuilt, which recomputes everything anyway
+    if (m_hierarchyDirty)
+        return;
+    m_dirty[slot] = 1;
+    m_firstDirty = std::min(m_firstDirty, size_t(slot));
+}
+
+void Scene::InvalidateTransforms()
+{
+    m_fullUpdate = true;
+    m_boundsDirty = true;
+}
+
+void Scene::RebuildHierarchy()
+{
+    const std::uint32_t INVALID = ComponentPool<Transform>::INVALID;
+    ComponentPool<Transform>& pool = GetPool<Transform>();
+    const ComponentPool<Parent>& parents = GetPool<Parent>();
+    const std::vector<Entity> entities = pool.GetEntities();
+    const size_t count = entities.size();
+
+    // Parent of each transform in the current order, a dead parent or one without a Transform makes a root
+    std::vector<std::uint32_t> parentOf(count, INVALID);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parents.Has(entities[i]))
+        {
+            const std::uint32_t parent = pool.IndexOf(parents.Get(entities[i]).entity);
+            parentOf[i] = parent != i ? parent : INVALID;
+        }
+    }
+
+    // Children grouped by parent
+    std::vector<std::uint32_t> childStarts(count + 1, 0), children(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parentOf[i] != INVALID)
+            childStarts[parentOf[i] + 1]++;
+    }
+    for (size_t i = 0; i < count; ++i)
+        childStarts[i + 1] += childStarts[i];
+    std::vector<std::uint32_t> cursors(childStarts.begin(), childStarts.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parentOf[i] != INVALID)
+            children[cursors[parentOf[i]]++] = std::uint32_t(i);
+    }
+
+    // Breadth first from the roots, one level at a time
+    std::vector<std::uint32_t> order;
+    std::vector<std::uint8_t> placed(count, 0);
+    order.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parentOf[i] == INVALID)
+        {
+            order.push_back(std::uint32_t(i));
+            placed[i] = 1;
+        }
+    }
+    m_levelStarts.clear();
+    size_t levelBegin = 0, nextRoot = 0;
+    while (levelBegin < count)
+    {
+        if (levelBegin == order.size())
+        {
+            // Only parent cycles are left
+            while (placed[nextRoot])
+                nextRoot++;
+            parentOf[nextRoot] = INVALID;
+            order.push_back(std::uint32_t(nextRoot));
+            placed[nextRoot] = 1;
+        }
+        const size_t levelEnd = order.size();
+        m_levelStarts.push_back(levelBegin);
+        for (size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            for (std::uint32_t c = childStarts[order[i]]; c < childStarts[order[i] + 1]; ++c)
+            {
+                if (!placed[children[c]])
+                {
+                    order.push_back(children[c]);
+                    placed[children[c]] = 1;
+                }
+            }
+        }
+        levelBegin = levelEnd;
+    }
+    m_levelStarts.push_back(count);
+
+    std::vector<std::uint32_t> slots(count);
+    std::vector<Entity> sorted(count);
+    m_parentSlots.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        slots[order[i]] = std::uint32_t(i);
+        sorted[i] = entities[order[i]];
+    }
+    for (size_t i = 0; i < count; ++i)
+        m_parentSlots[i] = parentOf[order[i]] != INVALID ? slots[parentOf[order[i]]] : INVALID;
+
+    // Bounds follow the same order so UpdateBounds() reads both at the same slot
+    pool.Reorder(sorted);
+    GetPool<Bounds>().Reorder(sorted);
+
+    m_dirty.assign(count, 0);
+    m_changed.assign(count, 0);
+    m_firstDirty = count;
+    m_firstChanged = count;
+    m_fullUpdate = true;
+    m_boundsDirty = true;
+    m_hierarchyDirty = false;
+}
+
+void Scene::UpdateTransforms()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (m_hierarchyDirty)
+        RebuildHierarchy();
+
+    std::vector<Transform>& transforms = GetPool<Transform>().GetComponents();
+    const size_t count = transforms.size();
+    const size_t first = m_fullUpdate ? 0 : std::min(m_firstDirty, count);
+
+    // Clears what the previous update flagged below the first slot this one visits, the rest is overwritten
+    if (m_firstChanged < first)
+        std::fill(m_changed.begin() + m_firstChanged, m_changed.begin() + first, 0);
+    m_firstChanged = first;
+
+    std::atomic<size_t> updated{ 0 };
+    const std::uint8_t full = m_fullUpdate ? 1 : 0;
+    for (size_t level = 0; level + 1 < m_levelStarts.size(); ++level)
+    {
+        // Nothing before the first dirty slot changes, and parents always come before their children
+        const size_t levelBegin = std::max(m_levelStarts[level], first);
+        const size_t levelEnd = m_levelStarts[level + 1];
+        if (levelBegin >= levelEnd)
+            continue;
+        ForEachChunk(levelEnd - levelBegin, [&, levelBegin](size_t begin, size_t end)
+        {
+            size_t chunkUpdated = 0;
+            for (size_t i = levelBegin + begin; i < levelBegin + end; ++i)
+            {
+                const std::uint32_t parent = m_parentSlots[i];
+                const std::uint8_t changed = full | m_dirty[i] | (parent != ComponentPool<Transform>::INVALID ? m_changed[parent] : 0);
+                m_changed[i] = changed;
+                m_dirty[i] = 0;
+                if (!changed)
+                    continue;
+                Transform& transform = transforms[i];
+                transform.world = ComposeTransform(transform.position, transform.rotation, transform.scale);
+                if (parent != ComponentPool<Transform>::INVALID)
+                    transform.world = transforms[parent].world * transform.world;
+                chunkUpdated++;
+            }
+            updated += chunkUpdated;
+        });
+    }
+    m_updatedCount = updated;
+    m_firstDirty = count;
+    m_fullUpdate = false;
+
+    m_transformMs = ElapsedMs(start);
+}
+
+void Scene::UpdateBounds()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const ComponentPool<Transform>& transformPool = GetPool<Transform>();
+    const std::vector<Transform>& transforms = transformPool.GetComponents();
+    const std::vector<Entity>& transformEntities = transformPool.GetEntities();
+    std::vector<Bounds>& bounds = GetPool<Bounds>().GetComponents();
+    const std::vector<Entity>& entities = GetPool<Bounds>().GetEntities();
+    if (!m_boundsDirty && m_updatedCount == 0)
+    {
+        m_transformMs += ElapsedMs(start);
+        return;
+    }
+
+    const bool full = m_boundsDirty;
+    ForEachChunk(bounds.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            // Same dense slot in both pools in the common case, no indirection
+            std::uint32_t slot = i < transformEntities.size() && transformEntities[i] == entities[i] ? std::uint32_t(i) : transformPool.IndexOf(entities[i]);
+            if (slot == ComponentPool<Transform>::INVALID)
+            {
+                if (full)
+                    bounds[i].world = bounds[i].local;
+            }
+            else if (full || m_changed[slot])
+            {
+                bounds[i].world = bounds[i].local.Transform(transforms[slot].world);
+            }
+        }
+    });
+    m_boundsDirty = false;
+
+    m_transformMs += ElapsedMs(start);
+}
+
+void Scene::Cull(const Frustum& frustum, std::vector<Entity>& visible)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const std::vector<Bounds>& bounds = GetPool<Bounds>().GetComponents();
+    const std::vector<Entity>& entities = GetPool<Bounds>().GetEntities();
+    const size_t chunks = (bounds.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_chunkVisible.resize(chunks);
+    auto cullChunks = [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            std::vector<Entity>& survivors = m_chunkVisible[chunk];
+            survivors.clear();
+            const size_t last = std::min(bounds.size(), (chunk + 1) * CHUNK_SIZE);
+            for (size_t i = chunk * CHUNK_SIZE; i < last; ++i)
+            {
+                if (frustum.Intersects(bounds[i].world))
+                    survivors.push_back(entities[i]);
+            }
+        }
+    };
+    if (m_jobs)
+        m_jobs->ParallelFor(chunks, 1, cullChunks);
+    else
+        cullChunks(0, chunks);
+
+    visible.clear();
+    for (auto& survivors: m_chunkVisible)
+        visible.insert(visible.end(), survivors.begin(), survivors.end());
+
+    m_cullMs = ElapsedMs(start);
+}
+
+void Scene::CollectLights(std::vector<PointLight>& lights) const
+{
+    const ComponentPool<Light>& lightPool = GetPool<Light>();
+    const ComponentPool<Transform>& transforms = GetPool<Transform>();
+    for (size_t i = 0; i < lightPool.GetSize(); ++i)
+    {
+        const Entity entity = lightPool.GetEntities()[i];
+        const Light& light = lightPool.GetComponents()[i];
+        PointLight pointLight;
+        pointLight.position = transforms.Has(entity) ? glm::vec3(transforms.Get(entity).world[3]) : glm::vec3(0.0f);
+        pointLight.radius = light.radius;
+        pointLight.color = light.color;
+        lights.push_back(pointLight);
+    }
+}
+
+DrawItem Scene::MakeDrawItem(Entity entity)
+{
+    const MeshRef& mesh = Get<MeshRef>(entity);
+    const Material& material = Get<Material>(entity);
+    DrawItem item;
+    item.vao = mesh.vao;
+    item.vertexCount = mesh.vertexCount;
+    item.indexCount = mesh.indexCount;
+    item.indexOffset = mesh.indexOffset;
+    item.program = material.program;
+    item.color = material.color;
+    item.opacity = material.opacity;
+    item.emissive = material.emissive;
+    if (Has<Transform>(entity))
+        item.model = Get<Transform>(entity).world;
+    if (Has<Bounds>(entity))
+    {
+        item.bounds = Get<Bounds>(entity).world;
+        item.occlusionId = Get<Bounds>(entity).occlusionId;
+    }
+    return item;
+}
+
+size_t Scene::GetUpdatedCount() const
+{
+    return m_updatedCount;
+}
+
+double Scene::GetTransformMilliseconds() const
+{
+    return m_transformMs;
+}
+
+double Scene::GetCullMilliseconds() const
+{
+    return m_cullMs;
+}
+
+void Scene::RunBenchmark()
+{
+    const size_t ENTITIES = 1 << 20;
+    const int FRAMES = 10;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    std::vector<Transform> sources(ENTITIES);
+    for (auto& transform: sources)
+    {
+        transform.position = glm::vec3(position(rng), position(rng), position(rng));
+        transform.rotation = glm::angleAxis(angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    const AABB unitBox(glm::vec3(-0.5f), glm::vec3(0.5f));
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 600.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum(glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f) * view);
+    std::vector<Entity> visible;
+
+    auto report = [](const char* name, double ms, size_t bytes)
+    {
+        std::cout << name << ms << " ms (" << bytes / ms / 1.0e6 << " GB/s)";
+    };
+
+    std::cout << "Scene benchmark, " << ENTITIES << " entities, average of " << FRAMES << " frames" << std::endl;
+    JobSystem jobs;
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        Scene scene(threaded ? &jobs : nullptr);
+        for (auto& transform: sources)
+        {
+            Entity entity = scene.Create();
+            scene.Add(entity, transform);
+            scene.Add(entity, Bounds{ unitBox, unitBox, -1 });
+            scene.Add(entity, MeshRef());
+            scene.Add(entity, Material());
+        }
+
+        // The first update sorts the transforms
+        scene.UpdateTransforms();
+
+        double transformMs = 0.0, boundsMs = 0.0, cullMs = 0.0;
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            scene.InvalidateTransforms();
+            scene.UpdateTransforms();
+            transformMs += scene.GetTransformMilliseconds();
+            scene.UpdateBounds();
+            boundsMs += scene.GetTransformMilliseconds();
+            scene.Cull(frustum, visible);
+            cullMs += scene.GetCullMilliseconds();
+        }
+        std::cout << "  sparse sets x" << (threaded ? jobs.GetThreadCount() : 1) << ": ";
+        report("transforms ", transformMs / FRAMES, ENTITIES * sizeof(Transform));
+        report(", bounds ", (boundsMs - transformMs) / FRAMES, ENTITIES * (sizeof(Bounds) + sizeof(glm::mat4)));
+        report(", cull ", cullMs / FRAMES, ENTITIES * sizeof(Bounds));
+        std::cout << ", " << visible.size() << " visible" << std::endl;
+    }
+
+    // The same passes over one heap object per entity visited in a shuffled order, as a scene of
+    // individually allocated nodes ends up after a while
+    struct SceneObject
+    {
+        Transform transform;
+        Bounds bounds;
+        MeshRef mesh;
+        Material material;
+    };
+    std::vector<std::unique_ptr<SceneObject>> objects(ENTITIES);
+    for (size_t i = 0; i < ENTITIES; ++i)
+    {
+        objects[i].reset(new SceneObject());
+        objects[i]->transform = sources[i];
+        objects[i]->bounds = Bounds{ unitBox, unitBox, -1 };
+    }
+    std::shuffle(objects.begin(), objects.end(), rng);
+
+    double transformMs = 0.0, boundsMs = 0.0, cullMs = 0.0;
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto& object: objects)
+            object->transform.world = ComposeTransform(object->transform.position, object->transform.rotation, object->transform.scale);
+        transformMs += ElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& object: objects)
+            object->bounds.world = object->bounds.local.Transform(object->transform.world);
+        boundsMs += ElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        visible.clear();
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            if (frustum.Intersects(objects[i]->bounds.world))
+                visible.push_back(Entity{ std::uint32_t(i), 0 });
+        }
+        cullMs += ElapsedMs(start);
+    }
+    std::cout << "  heap objects x1: ";
+    report("transforms ", transformMs / FRAMES, ENTITIES * sizeof(Transform));
+    report(", bounds ", boundsMs / FRAMES, ENTITIES * (sizeof(Bounds) + sizeof(glm::mat4)));
+    report(", cull ", cullMs / FRAMES, ENTITIES * sizeof(Bounds));
+    std::cout << ", " << visible.size() << " visible" << std::endl;
+    objects.clear();
+
+    // A random hierarchy under 1024 roots, each entity is attached to one created before it. Every
+    // frame a fraction of the entities is moved, then transforms and bounds are updated either from
+    // scratch or from the dirty flags.
+    const size_t ROOTS = 1024;
+    Scene scene(&jobs);
+    std::vector<Entity> entities(ENTITIES);
+    for (size_t i = 0; i < ENTITIES; ++i)
+    {
+        entities[i] = scene.Create();
+        Transform transform = sources[i];
+        transform.position *= 0.01f;
+        scene.Add(entities[i], transform);
+        scene.Add(entities[i], Bounds{ unitBox, unitBox, -1 });
+        if (i >= ROOTS)
+            scene.Add(entities[i], Parent{ entities[std::uniform_int_distribution<size_t>(0, i - 1)(rng)] });
+    }
+    scene.UpdateTransforms();
+    scene.UpdateBounds();
+
+    std::cout << "  hierarchy x" << jobs.GetThreadCount() << ", " << ROOTS << " roots:" << std::endl;
+    const double rates[] = { 0.0, 0.0001, 0.001, 0.01, 0.1, 1.0 };
+    for (double rate: rates)
+    {
+        const size_t moved = size_t(rate * ENTITIES);
+        double fullMs = 0.0, incrementalMs = 0.0;
+        size_t updated = 0;
+        for (int incremental = 0; incremental < 2; ++incremental)
+        {
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                for (size_t i = 0; i < moved; ++i)
+                {
+                    Entity entity = entities[std::uniform_int_distribution<size_t>(0, ENTITIES - 1)(rng)];
+                    scene.Get<Transform>(entity).rotation *= glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+                    scene.MarkDirty(entity);
+                }
+                if (!incremental)
+                    scene.InvalidateTransforms();
+                scene.UpdateTransforms();
+                scene.UpdateBounds();
+                (incremental ? incrementalMs : fullMs) += scene.GetTransformMilliseconds();
+                if (incremental)
+                    updated += scene.GetUpdatedCount();
+            }
+        }
+        std::cout << "    " << rate * 100.0 << "% moved: full " << fullMs / FRAMES << " ms, incremental " << incrementalMs / FRAMES
+            << " ms, " << updated / FRAMES << " transforms updated" << std::endl;
+    }
+}
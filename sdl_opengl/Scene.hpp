@@ -0,0 +1,374 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Bounds.hpp"
+#include "GLProgram.hpp"
+#include "LightClusters.hpp"
+#include "RenderQueue.hpp"
+
+class JobSystem;
+
+// Stable handle: the index is recycled after Destroy() with a new generation, so stale handles
+// never alias a later entity
+struct Entity
+{
+    std::uint32_t index;
+    std::uint32_t generation;
+
+    bool operator==(const Entity& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Entity& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Components. Transform::world, Bounds::world are written by the systems. Position, rotation and
+// scale are relative to the Parent's world transform, Scene::MarkDirty() must follow any change.
+struct Transform
+{
+    glm::vec3 position{ 0.0f };
+    glm::quat rotation;
+    glm::vec3 scale{ 1.0f };
+    glm::mat4 world;
+};
+
+// Attaches the entity's Transform to another entity's, a parent without a Transform is ignored
+struct Parent
+{
+    Entity entity;
+};
+
+struct MeshRef
+{
+    GLuint vao{ 0 };
+    GLsizei vertexCount{ 0 };
+    GLsizei indexCount{ 0 };
+    GLsizeiptr indexOffset{ 0 };
+};
+
+struct Material
+{
+    GLProgram* program{ nullptr };
+    glm::vec3 color{ 1.0f };
+    float opacity{ 1.0f };
+    bool emissive{ false };
+};
+
+struct Bounds
+{
+    AABB local;
+    AABB world;
+    // Stable id for occlusion culling, -1 for entities that are always drawn
+    int occlusionId{ -1 };
+};
+
+// Point light at the entity's position
+struct Light
+{
+    glm::vec3 color{ 1.0f };
+    float radius{ 1.0f };
+};
+
+// Sparse set: components are packed in a dense array in no particular order, the sparse array maps
+// an entity index to its dense slot. Iteration is linear, lookup is two loads, removal swaps the
+// last component into the hole.
+template <typename T>
+class ComponentPool
+{
+public:
+
+    static const std::uint32_t INVALID = std::numeric_limits<std::uint32_t>::max();
+
+    // Replaces the component when the entity already has one
+    T& Add(Entity entity, const T& component)
+    {
+        if (entity.index >= m_sparse.size())
+            m_sparse.resize(entity.index + 1, INVALID);
+        std::uint32_t& slot = m_sparse[entity.index];
+        if (slot != INVALID)
+        {
+            m_entities[slot] = entity;
+            return m_components[slot] = component;
+        }
+        slot = std::uint32_t(m_components.size());
+        m_entities.push_back(entity);
+        m_components.push_back(component);
+        return m_components.back();
+    }
+
+    void Remove(Entity entity)
+    {
+        const std::uint32_t slot = IndexOf(entity);
+        if (slot == INVALID)
+            return;
+        const std::uint32_t last = std::uint32_t(m_components.size() - 1);
+        if (slot != last)
+        {
+            m_components[slot] = m_components[last];
+            m_entities[slot] = m_entities[last];
+            m_sparse[m_entities[slot].index] = slot;
+        }
+        m_components.pop_back();
+        m_entities.pop_back();
+        m_sparse[entity.index] = INVALID;
+    }
+
+    // Moves the components of the listed entities to the front in that order, the others follow in
+    // their current order
+    void Reorder(const std::vector<Entity>& order)
+    {
+        std::vector<Entity> entities;
+        std::vector<T> components;
+        entities.reserve(m_entities.size());
+        components.reserve(m_components.size());
+        for (Entity entity: order)
+        {
+            const std::uint32_t slot = IndexOf(entity);
+            if (slot == INVALID)
+                continue;
+            entities.push_back(entity);
+            components.push_back(m_components[slot]);
+            m_sparse[entity.index] = INVALID;
+        }
+        for (size_t i = 0; i < m_entities.size(); ++i)
+        {
+            if (m_sparse[m_entities[i].index] == i)
+            {
+                entities.push_back(m_entities[i]);
+                components.push_back(m_components[i]);
+            }
+        }
+        for (size_t i = 0; i < entities.size(); ++i)
+            m_sparse[entities[i].index] = std::uint32_t(i);
+        m_entities.swap(entities);
+        m_components.swap(components);
+    }
+
+    // Dense slot of the entity's component, INVALID if it has none
+    std::uint32_t IndexOf(Entity entity) const
+    {
+        if (entity.index >= m_sparse.size())
+            return INVALID;
+        const std::uint32_t slot = m_sparse[entity.index];
+        return slot != INVALID && m_entities[slot] == entity ? slot : INVALID;
+    }
+
+    bool Has(Entity entity) const
+    {
+        return IndexOf(entity) != INVALID;
+    }
+
+    // The entity must have the component
+    T& Get(Entity entity)
+    {
+        return m_components[m_sparse[entity.index]];
+    }
+
+    const T& Get(Entity entity) const
+    {
+        return m_components[m_sparse[entity.index]];
+    }
+
+    size_t GetSize() const
+    {
+        return m_components.size();
+    }
+
+    // Dense arrays, components[i] belongs to entities[i]
+    std::vector<T>& GetComponents()
+    {
+        return m_components;
+    }
+
+    const std::vector<T>& GetComponents() const
+    {
+        return m_components;
+    }
+
+    const std::vector<Entity>& GetEntities() const
+    {
+        return m_entities;
+    }
+
+private:
+
+    std::vector<std::uint32_t> m_sparse;
+
+    std::vector<Entity> m_entities;
+
+    std::vector<T> m_components;
+};
+
+template <typename T>
+const std::uint32_t ComponentPool<T>::INVALID;
+
+// Scene objects as entities with sparse set component storage. The systems are linear passes over
+// the dense arrays, split in parallel chunks. A pass that needs a second component reads it at the
+// same dense slot when both pools list the entities in the same order (the usual case for entities
+// created together), and only goes through the sparse array otherwise.
+//
+// Transforms are kept in breadth first order of the Parent hierarchy, so a parent's world matrix is
+// always computed before its children's and each level is one parallel pass. Only transforms marked
+// dirty and their subtrees are recomputed, a static scene costs next to nothing per frame. Adding or
+// removing a Transform or a Parent rebuilds the order and recomputes everything once.
+class Scene
+{
+public:
+
+    // jobs may be nullptr, then the systems run on the calling thread
+    explicit Scene(JobSystem* jobs = nullptr);
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    Entity Create();
+
+    // Removes the entity and all its components, the handle becomes stale
+    void Destroy(Entity entity);
+
+    bool IsAlive(Entity entity) const;
+
+    size_t GetEntityCount() const;
+
+    template <typename T>
+    T& Add(Entity entity, const T& component)
+    {
+        ComponentsChanged(static_cast<const T*>(nullptr));
+        return GetPool<T>().Add(entity, component);
+    }
+
+    template <typename T>
+    void Remove(Entity entity)
+    {
+        ComponentsChanged(static_cast<const T*>(nullptr));
+        GetPool<T>().Remove(entity);
+    }
+
+    template <typename T>
+    bool Has(Entity entity) const
+    {
+        return GetPool<T>().Has(entity);
+    }
+
+    template <typename T>
+    T& Get(Entity entity)
+    {
+        return GetPool<T>().Get(entity);
+    }
+
+    template <typename T>
+    ComponentPool<T>& GetPool()
+    {
+        return std::get<ComponentPool<T>>(m_pools);
+    }
+
+    template <typename T>
+    const ComponentPool<T>& GetPool() const
+    {
+        return std::get<ComponentPool<T>>(m_pools);
+    }
+
+    // Flags the entity's Transform, its subtree and Bounds for the next update, after changing them
+    // through Get()
+    void MarkDirty(Entity entity);
+
+    // Recomputes every transform and bounds on the next update
+    void InvalidateTransforms();
+
+    // Transform::world of the dirty subtrees from position, rotation, scale and the parent's world.
+    // Timed together with UpdateBounds().
+    void UpdateTransforms();
+
+    // Bounds::world of the entities whose transform was updated, from Bounds::local and
+    // Transform::world. Entities without a Transform keep local.
+    void UpdateBounds();
+
+    // Entities whose world bounds intersect the frustum, in dense order
+    void Cull(const Frustum& frustum, std::vector<Entity>& visible);
+
+    // Appends a PointLight per Light component at its Transform::world origin, after UpdateTransforms()
+    void CollectLights(std::vector<PointLight>& lights) const;
+
+    // Draw item of an entity with a MeshRef and a Material, after UpdateBounds()
+    DrawItem MakeDrawItem(Entity entity);
+
+    // Transforms recomputed by the last UpdateTransforms()
+    size_t GetUpdatedCount() const;
+
+    double GetTransformMilliseconds() const;
+
+    double GetCullMilliseconds() const;
+
+    // Prints transform, bounds and culling times over 1M entities against a pointer chasing baseline,
+    // then full against incremental hierarchy updates at several change rates
+    static void RunBenchmark();
+
+private:
+
+    static const size_t CHUNK_SIZE = 16384;
+
+    template <typename Fn>
+    void ForEachChunk(size_t count, const Fn& fn);
+
+    template <typename T>
+    void ComponentsChanged(const T*)
+    {
+
+    }
+
+    void ComponentsChanged(const Transform*);
+
+    void ComponentsChanged(const Parent*);
+
+    void ComponentsChanged(const Bounds*);
+
+    // Sorts the transforms (and bounds) breadth first, a parent cycle is broken at an arbitrary node
+    void RebuildHierarchy();
+
+private:
+
+    JobSystem* m_jobs;
+
+    std::vector<std::uint32_t> m_generations;
+
+    std::vector<std::uint32_t> m_freeIndices;
+
+    std::tuple<ComponentPool<Transform>, ComponentPool<Parent>, ComponentPool<MeshRef>, ComponentPool<Material>, ComponentPool<Bounds>, ComponentPool<Light>> m_pools;
+
+    // Per transform slot in breadth first order: the parent's slot, the dirty flag set by MarkDirty()
+    // and whether the last update recomputed it
+    std::vector<std::uint32_t> m_parentSlots;
+
+    std::vector<std::uint8_t> m_dirty;
+
+    std::vector<std::uint8_t> m_changed;
+
+    // First slot of each level of the hierarchy, then the transform count
+    std::vector<size_t> m_levelStarts;
+
+    // No dirty slot before m_firstDirty, no changed slot before m_firstChanged
+    size_t m_firstDirty, m_firstChanged;
+
+    bool m_hierarchyDirty, m_fullUpdate, m_boundsDirty;
+
+    size_t m_updatedCount;
+
+    // Survivors of each culling chunk, concatenated in chunk order
+    std::vector<std::vector<Entity>> m_chunkVisible;
+
+    double m_transformMs, m_cullMs;
+};
+#endif
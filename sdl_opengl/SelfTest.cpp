@@ -0,0 +1,30 @@
+#include "SelfTest.hpp"
+
+#include <iostream>
+
+SelfTest::SelfTest(const std::string& name) :
+    m_passed{true}
+{
+    std::cout << name << " tests" << std::endl;
+}
+
+void SelfTest::Check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cout << "  FAILED: " << what << std::endl;
+        m_passed = false;
+    }
+}
+
+bool SelfTest::Skip(const std::string& reason)
+{
+    std::cout << "  skipped, " << reason << std::endl;
+    return true;
+}
+
+bool SelfTest::Finish()
+{
+    std::cout << (m_passed ? "  passed" : "  failed") << std::endl;
+    return m_passed;
+}
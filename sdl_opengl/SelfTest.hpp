@@ -0,0 +1,29 @@
+#ifndef SELF_TEST_HPP
+#define SELF_TEST_HPP
+
+#include <string>
+
+// Bookkeeping shared by the --test suites: prints the suite name, every failed check and the result
+class SelfTest
+{
+public:
+
+    explicit SelfTest(const std::string& name);
+
+    SelfTest(const SelfTest&) = delete;
+    SelfTest& operator=(const SelfTest&) = delete;
+
+    // Prints what was expected when condition is false, the suite then fails
+    void Check(bool condition, const char* what);
+
+    // Prints why the suite cannot run here, a skipped suite passes
+    bool Skip(const std::string& reason);
+
+    // Prints the result line, true when every check passed
+    bool Finish();
+
+private:
+
+    bool m_passed;
+};
+#endif
@@ -0,0 +1,305 @@
+#include "ShadowMaps.hpp"
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+ShadowMaps::ShadowMaps():
+    m_cascadeCount{0}, m_resolution{0}, m_fbo{0}, m_depthTexture{0}, m_lightDirection{glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f))},
+    m_lightColor{0.6f}, m_shadowDistance{40.0f}, m_splitLambda{0.75f}, m_cullMs{0.0}
+{
+    for (auto& cascade: m_cascades)
+        cascade.splitDepth = 0.0f;
+}
+
+ShadowMaps::~ShadowMaps()
+{
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteTextures(1, &m_depthTexture);
+    }
+}
+
+bool ShadowMaps::Init(int cascadeCount, int resolution)
+{
+    if (cascadeCount < 1 || cascadeCount > MAX_CASCADES || resolution < 16)
+    {
+        m_error = "Shadow maps need 1 to " + std::to_string(MAX_CASCADES) + " cascades of at least 16x16";
+        return false;
+    }
+
+    // Depth only, the vertex shader is the plain model/view/projection one
+    if (!m_depthProgram.InitWithFiles("vertex_shade_lighting.vs", "fragment_shader_depth.frag"))
+    {
+        m_error = m_depthProgram.GetError();
+        return false;
+    }
+
+    glGenTextures(1, &m_depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, cascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        m_error = "Shadow map framebuffer is incomplete";
+        return false;
+    }
+
+    m_cascadeCount = cascadeCount;
+    m_resolution = resolution;
+    return true;
+}
+
+const std::string& ShadowMaps::GetError() const
+{
+    return m_error;
+}
+
+void ShadowMaps::SetLightDirection(const glm::vec3& direction)
+{
+    m_lightDirection = glm::normalize(direction);
+}
+
+void ShadowMaps::SetLightColor(const glm::vec3& color)
+{
+    m_lightColor = color;
+}
+
+void ShadowMaps::SetShadowDistance(float distance)
+{
+    m_shadowDistance = distance;
+}
+
+void ShadowMaps::SetSplitLambda(float lambda)
+{
+    m_splitLambda = glm::clamp(lambda, 0.0f, 1.0f);
+}
+
+void ShadowMaps::Update(Camera& camera, const std::vector<DrawItem>& casters)
+{
+    if (m_cascadeCount == 0)
+        return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const float cameraNear = camera.GetNear();
+    const float cameraFar = camera.GetFar();
+    const float shadowFar = std::min(cameraFar, m_shadowDistance);
+
+    // Corners of the camera frustum, a point at view depth d on the edge from a near to a far corner
+    // is at (d - near) / (far - near) of the way
+    const glm::mat4& inverseViewProjection = camera.GetInverseViewProjectionMatrix();
+    glm::vec3 nearCorners[4], farCorners[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::vec2 ndc(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f);
+        glm::vec4 nearCorner = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farCorner = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+    }
+
+    // Light space rotation, the cascades only differ by their orthographic projection
+    const glm::vec3 up = std::abs(m_lightDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), m_lightDirection, up);
+
+    // The light looks down -z, casters up to the top of their bounds are kept in front of the near plane
+    AABB casterBounds;
+    if (!casters.empty())
+    {
+        casterBounds = casters[0].bounds;
+        for (auto& caster: casters)
+        {
+            casterBounds.min = glm::min(casterBounds.min, caster.bounds.min);
+            casterBounds.max = glm::max(casterBounds.max, caster.bounds.max);
+        }
+    }
+    const AABB lightCasterBounds = casterBounds.Transform(lightView);
+
+    const glm::mat4 textureBias = glm::scale(glm::translate(glm::mat4(), glm::vec3(0.5f)), glm::vec3(0.5f));
+    float splitNear = cameraNear;
+    for (int c = 0; c < m_cascadeCount; ++c)
+    {
+        Cascade& cascade = m_cascades[c];
+
+        // Practical split scheme: logarithmic splits keep the texel density even, uniform ones keep
+        // the near cascades from getting too small
+        const float fraction = float(c + 1) / float(m_cascadeCount);
+        const float logSplit = cameraNear * std::pow(shadowFar / cameraNear, fraction);
+        const float uniformSplit = cameraNear + (shadowFar - cameraNear) * fraction;
+        const float splitFar = m_splitLambda * logSplit + (1.0f - m_splitLambda) * uniformSplit;
+        cascade.splitDepth = splitFar;
+
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 4; ++i)
+        {
+            corners[i] = glm::mix(nearCorners[i], farCorners[i], (splitNear - cameraNear) / (cameraFar - cameraNear));
+            corners[i + 4] = glm::mix(nearCorners[i], farCorners[i], (splitFar - cameraNear) / (cameraFar - cameraNear));
+            center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (auto& corner: corners)
+            radius = std::max(radius, glm::length(corner - center));
+        // Rounded up so float noise does not change the projection from frame to frame
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // Moves the center by whole texels only, the same world position then always lands on the same texel
+        const float texelSize = 2.0f * radius / float(m_resolution);
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        const float zFar = lightCenter.z - radius;
+        const float zNear = casters.empty() ? lightCenter.z + radius : std::max(lightCenter.z + radius, lightCasterBounds.max.z);
+        const glm::mat4 projection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius, -zNear, -zFar);
+        cascade.viewProjection = projection * lightView;
+        cascade.shadowMatrix = textureBias * cascade.viewProjection;
+
+        const Frustum frustum(cascade.viewProjection);
+        cascade.casters.clear();
+        for (size_t i = 0; i < casters.size(); ++i)
+        {
+            if (frustum.Intersects(casters[i].bounds))
+                cascade.casters.push_back(i);
+        }
+
+        splitNear = splitFar;
+    }
+
+    m_cullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ShadowMaps::Render(const std::vector<DrawItem>& casters)
+{
+    if (m_cascadeCount == 0)
+        return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_resolution, m_resolution);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    // Slope scaled bias against acne on surfaces at grazing angles to the light
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    m_depthProgram.Use();
+    GLuint program = m_depthProgram.GetProgram();
+    const glm::mat4 identity;
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(identity));
+    GLint projectionLoc = glGetUniformLocation(program, "projection");
+    GLint modelLoc = glGetUniformLocation(program, "model");
+
+    for (int c = 0; c < m_cascadeCount; ++c)
+    {
+        const Cascade& cascade = m_cascades[c];
+        m_timers[c].Begin();
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, c);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(cascade.viewProjection));
+
+        GLuint boundVAO = 0;
+        for (size_t index: cascade.casters)
+        {
+            const DrawItem& item = casters[index];
+            if (item.vao != boundVAO)
+            {
+                glBindVertexArray(item.vao);
+                boundVAO = item.vao;
+            }
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+            if (item.indexCount > 0)
+                glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, (GLvoid*)item.indexOffset);
+            else
+                glDrawArrays(GL_TRIANGLES, 0, item.vertexCount);
+        }
+        m_timers[c].End();
+    }
+    glBindVertexArray(0);
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowMaps::Bind(GLuint program, int textureUnit) const
+{
+    // The sampler always gets its own unit, a program with samplers of different types on one unit does not draw
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), textureUnit);
+    glUniform1i(glGetUniformLocation(program, "cascadeCount"), m_cascadeCount);
+    if (m_cascadeCount == 0)
+    {
+        glUniform3f(glGetUniformLocation(program, "sunColor"), 0.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    glm::mat4 matrices[MAX_CASCADES];
+    glm::vec4 splits(0.0f);
+    for (int c = 0; c < m_cascadeCount; ++c)
+    {
+        matrices[c] = m_cascades[c].shadowMatrix;
+        splits[c] = m_cascades[c].splitDepth;
+    }
+    glUniformMatrix4fv(glGetUniformLocation(program, "cascadeMatrices"), m_cascadeCount, GL_FALSE, glm::value_ptr(matrices[0]));
+    glUniform4fv(glGetUniformLocation(program, "cascadeSplits"), 1, glm::value_ptr(splits));
+    glUniform1f(glGetUniformLocation(program, "shadowTexelSize"), 1.0f / float(m_resolution));
+    glUniform3fv(glGetUniformLocation(program, "sunDirection"), 1, glm::value_ptr(-m_lightDirection));
+    glUniform3fv(glGetUniformLocation(program, "sunColor"), 1, glm::value_ptr(m_lightColor));
+}
+
+int ShadowMaps::GetCascadeCount() const
+{
+    return m_cascadeCount;
+}
+
+int ShadowMaps::GetResolution() const
+{
+    return m_resolution;
+}
+
+float ShadowMaps::GetSplitDepth(int cascade) const
+{
+    return m_cascades[cascade].splitDepth;
+}
+
+size_t ShadowMaps::GetCasterCount(int cascade) const
+{
+    return m_cascades[cascade].casters.size();
+}
+
+double ShadowMaps::GetCascadeMilliseconds(int cascade) const
+{
+    return m_timers[cascade].GetMilliseconds();
+}
+
+double ShadowMaps::GetCullMilliseconds() const
+{
+    return m_cullMs;
+}
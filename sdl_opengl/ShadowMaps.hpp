@@ -0,0 +1,113 @@
+#ifndef SHADOW_MAPS_HPP
+#define SHADOW_MAPS_HPP
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "GLProgram.hpp"
+#include "GPUTimer.hpp"
+#include "RenderQueue.hpp"
+
+class Camera;
+
+// Cascaded shadow maps for a directional light. The camera frustum up to the shadow distance is
+// split with the practical scheme (a blend of logarithmic and uniform splits), each slice gets an
+// orthographic light projection fit to its bounding sphere. The sphere does not change size when
+// the camera turns and its center is snapped to whole shadow map texels, so shadow edges do not
+// shimmer. Depth is extended towards the light over the casters' bounds, so casters outside the
+// slice still shadow it. Every cascade culls the casters with its own frustum.
+class ShadowMaps
+{
+public:
+
+    static const int MAX_CASCADES = 4;
+
+    ShadowMaps();
+
+    ~ShadowMaps();
+
+    ShadowMaps(const ShadowMaps&) = delete;
+    ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+    // cascadeCount from 1 to MAX_CASCADES, resolution is the size of each cascade's square map
+    bool Init(int cascadeCount, int resolution);
+
+    const std::string& GetError() const;
+
+    // Direction the light travels in, from the light into the scene
+    void SetLightDirection(const glm::vec3& direction);
+
+    void SetLightColor(const glm::vec3& color);
+
+    // Distance from the camera covered by the cascades, and the split blend: 0 uniform, 1 logarithmic
+    void SetShadowDistance(float distance);
+
+    void SetSplitLambda(float lambda);
+
+    // Fits the cascades to the camera and culls the casters for each of them
+    void Update(Camera& camera, const std::vector<DrawItem>& casters);
+
+    // Renders the casters of every cascade, leaves framebuffer 0 bound with the viewport unchanged
+    void Render(const std::vector<DrawItem>& casters);
+
+    // Sets the light and shadow uniforms and binds the shadow map to textureUnit
+    void Bind(GLuint program, int textureUnit) const;
+
+    int GetCascadeCount() const;
+
+    int GetResolution() const;
+
+    // Far view depth of a cascade
+    float GetSplitDepth(int cascade) const;
+
+    size_t GetCasterCount(int cascade) const;
+
+    double GetCascadeMilliseconds(int cascade) const;
+
+    double GetCullMilliseconds() const;
+
+private:
+
+    struct Cascade
+    {
+        glm::mat4 viewProjection;
+        // World space to shadow map texture space, [0, 1] in x, y and depth
+        glm::mat4 shadowMatrix;
+        float splitDepth;
+        std::vector<size_t> casters;
+    };
+
+private:
+
+    int m_cascadeCount;
+
+    int m_resolution;
+
+    GLuint m_fbo;
+
+    // One layer per cascade, compared depth texture sampled with hardware 2x2 PCF
+    GLuint m_depthTexture;
+
+    GLProgram m_depthProgram;
+
+    glm::vec3 m_lightDirection;
+
+    glm::vec3 m_lightColor;
+
+    float m_shadowDistance;
+
+    float m_splitLambda;
+
+    Cascade m_cascades[MAX_CASCADES];
+
+    GPUTimer m_timers[MAX_CASCADES];
+
+    double m_cullMs;
+
+    std::string m_error;
+};
+#endif
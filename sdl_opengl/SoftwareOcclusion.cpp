@@ -0,0 +1,384 @@
+#include "SoftwareOcclusion.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Twice the signed area, positive for counter clockwise triangles
+    float EdgeArea(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+    {
+        return (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    }
+}
+
+SoftwareOcclusion::SoftwareOcclusion(JobSystem* jobs):
+    m_jobs{jobs}, m_simd{GLM_ARCH & GLM_ARCH_SSE2_BIT ? true : false}, m_bins(TILES_X * TILES_Y),
+    m_rasterMilliseconds{0.0}, m_testMilliseconds{0.0}
+{
+    for (int level = 0; level < LEVELS; ++level)
+        m_levels[level].assign(size_t(WIDTH >> level) * (HEIGHT >> level), 1.0f);
+}
+
+void SoftwareOcclusion::BeginFrame(const glm::mat4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    for (auto& bin: m_bins)
+        bin.clear();
+}
+
+void SoftwareOcclusion::AddOccluder(const float* positions, size_t vertexCount, const glm::mat4& model)
+{
+    glm::mat4 transform = m_viewProjection * model;
+    for (size_t i = 0; i + 2 < vertexCount; i += 3)
+    {
+        glm::vec4 clip[3];
+        bool clipped = false;
+        for (int k = 0; k < 3; ++k)
+        {
+            const float* p = positions + (i + k) * 3;
+            clip[k] = transform * glm::vec4(p[0], p[1], p[2], 1.0f);
+            clipped = clipped || clip[k].w <= 0.0f || clip[k].z < -clip[k].w;
+        }
+        if (!clipped)
+            SetupTriangle(clip[0], clip[1], clip[2]);
+    }
+}
+
+void SoftwareOcclusion::SetupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2)
+{
+    // Pixel coordinates with y up and depth mapped to [0, 1]
+    glm::vec3 v[3];
+    const glm::vec4* clip[3] = { &c0, &c1, &c2 };
+    for (int k = 0; k < 3; ++k)
+    {
+        glm::vec3 ndc = glm::vec3(*clip[k]) / clip[k]->w;
+        v[k] = glm::vec3((ndc.x * 0.5f + 0.5f) * WIDTH, (ndc.y * 0.5f + 0.5f) * HEIGHT, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Occluders are double sided, the winding only decides the sign of the edge functions
+    float area = EdgeArea(v[0], v[1], v[2]);
+    if (area < 0.0f)
+    {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+    if (area < 1e-6f)
+        return;
+
+    Triangle t;
+    t.minX = std::max(0, int(std::floor(std::min(std::min(v[0].x, v[1].x), v[2].x))));
+    t.minY = std::max(0, int(std::floor(std::min(std::min(v[0].y, v[1].y), v[2].y))));
+    t.maxX = std::min(WIDTH - 1, int(std::ceil(std::max(std::max(v[0].x, v[1].x), v[2].x))));
+    t.maxY = std::min(HEIGHT - 1, int(std::ceil(std::max(std::max(v[0].y, v[1].y), v[2].y))));
+    if (t.minX > t.maxX || t.minY > t.maxY)
+        return;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        const glm::vec3& va = v[k];
+        const glm::vec3& vb = v[(k + 1) % 3];
+        t.a[k] = va.y - vb.y;
+        t.b[k] = vb.x - va.x;
+        t.c[k] = -(t.a[k] * va.x + t.b[k] * va.y);
+    }
+
+    // NDC depth is affine in screen space, so the plane equation is exact. It is sampled at pixel
+    // centers, shifting it by half a pixel's slope stores the farthest depth the pixel can have.
+    float dzdx = ((v[1].z - v[0].z) * (v[2].y - v[0].y) - (v[2].z - v[0].z) * (v[1].y - v[0].y)) / area;
+    float dzdy = ((v[2].z - v[0].z) * (v[1].x - v[0].x) - (v[1].z - v[0].z) * (v[2].x - v[0].x)) / area;
+    t.za = dzdx;
+    t.zb = dzdy;
+    t.zc = v[0].z - dzdx * v[0].x - dzdy * v[0].y + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+
+    std::uint32_t index = std::uint32_t(m_triangles.size());
+    m_triangles.push_back(t);
+    for (int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ++ty)
+        for (int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; ++tx)
+            m_bins[ty * TILES_X + tx].push_back(index);
+}
+
+void SoftwareOcclusion::Rasterize()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Tiles own disjoint regions of every level, so they need no synchronization
+    auto rasterizeTiles = [this](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; ++tile)
+        {
+            RasterizeTile(int(tile));
+            BuildTilePyramid(int(tile));
+        }
+    };
+    if (m_jobs)
+        m_jobs->ParallelFor(m_bins.size(), 1, rasterizeTiles);
+    else
+        rasterizeTiles(0, m_bins.size());
+
+    m_rasterMilliseconds = MillisecondsSince(start);
+}
+
+void SoftwareOcclusion::RasterizeTile(int tile)
+{
+    const int tileX = (tile % TILES_X) * TILE_SIZE;
+    const int tileY = (tile / TILES_X) * TILE_SIZE;
+    float* depth = m_levels[0].data();
+
+    for (int y = tileY; y < tileY + TILE_SIZE; ++y)
+        std::fill(depth + y * WIDTH + tileX, depth + y * WIDTH + tileX + TILE_SIZE, 1.0f);
+
+    for (std::uint32_t index: m_bins[tile])
+    {
+        const Triangle& t = m_triangles[index];
+        const int y0 = std::max(t.minY, tileY);
+        const int y1 = std::min(t.maxY, tileY + TILE_SIZE - 1);
+        // Tiles are a multiple of the SIMD width wide, so aligned spans never leave the tile
+        const int x0 = std::max(t.minX, tileX) & ~7;
+        const int x1 = std::min(t.maxX, tileX + TILE_SIZE - 1);
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            const float py = float(y) + 0.5f;
+            const float rowE0 = t.b[0] * py + t.c[0];
+            const float rowE1 = t.b[1] * py + t.c[1];
+            const float rowE2 = t.b[2] * py + t.c[2];
+            const float rowZ = t.zb * py + t.zc;
+            float* row = depth + y * WIDTH;
+            int x = x0;
+#if GLM_ARCH & GLM_ARCH_AVX_BIT
+            if (m_simd)
+            {
+                const __m256 zero = _mm256_setzero_ps();
+                const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+                const __m256 a0 = _mm256_set1_ps(t.a[0]), a1 = _mm256_set1_ps(t.a[1]), a2 = _mm256_set1_ps(t.a[2]), za = _mm256_set1_ps(t.za);
+                const __m256 e0Row = _mm256_set1_ps(rowE0), e1Row = _mm256_set1_ps(rowE1), e2Row = _mm256_set1_ps(rowE2), zRow = _mm256_set1_ps(rowZ);
+                for (; x <= x1; x += 8)
+                {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps(float(x)), offsets);
+                    __m256 inside = _mm256_and_ps(
+                        _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0, px), e0Row), zero, _CMP_GE_OQ),
+                                      _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1, px), e1Row), zero, _CMP_GE_OQ)),
+                        _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2, px), e2Row), zero, _CMP_GE_OQ));
+                    __m256 z = _mm256_add_ps(_mm256_mul_ps(za, px), zRow);
+                    __m256 old = _mm256_loadu_ps(row + x);
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+                }
+            }
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+            if (m_simd)
+            {
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                const __m128 a0 = _mm_set1_ps(t.a[0]), a1 = _mm_set1_ps(t.a[1]), a2 = _mm_set1_ps(t.a[2]), za = _mm_set1_ps(t.za);
+                const __m128 e0Row = _mm_set1_ps(rowE0), e1Row = _mm_set1_ps(rowE1), e2Row = _mm_set1_ps(rowE2), zRow = _mm_set1_ps(rowZ);
+                for (; x <= x1; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+                    __m128 inside = _mm_and_ps(
+                        _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), e0Row), zero),
+                                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), e1Row), zero)),
+                        _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), e2Row), zero));
+                    __m128 z = _mm_add_ps(_mm_mul_ps(za, px), zRow);
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nearest = _mm_min_ps(old, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+                }
+            }
+#endif
+            for (; x <= x1; ++x)
+            {
+                const float px = float(x) + 0.5f;
+                if (t.a[0] * px + rowE0 >= 0.0f && t.a[1] * px + rowE1 >= 0.0f && t.a[2] * px + rowE2 >= 0.0f)
+                    row[x] = std::min(row[x], t.za * px + rowZ);
+            }
+        }
+    }
+}
+
+void SoftwareOcclusion::BuildTilePyramid(int tile)
+{
+    for (int level = 1; level < LEVELS; ++level)
+    {
+        const int size = TILE_SIZE >> level;
+        const int tileX = (tile % TILES_X) * size;
+        const int tileY = (tile / TILES_X) * size;
+        const int srcWidth = WIDTH >> (level - 1);
+        const int dstWidth = WIDTH >> level;
+        const float* src = m_levels[level - 1].data();
+        float* dst = m_levels[level].data();
+        for (int y = tileY; y < tileY + size; ++y)
+        {
+            const float* row0 = src + (2 * y) * srcWidth;
+            const float* row1 = row0 + srcWidth;
+            for (int x = tileX; x < tileX + size; ++x)
+                dst[y * dstWidth + x] = std::max(std::max(row0[2 * x], row0[2 * x + 1]), std::max(row1[2 * x], row1[2 * x + 1]));
+        }
+    }
+}
+
+bool SoftwareOcclusion::IsVisible(const AABB& bounds) const
+{
+    glm::vec3 ndcMin(1e30f), ndcMax(-1e30f);
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec4 p((corner & 1) ? bounds.max.x : bounds.min.x, (corner & 2) ? bounds.max.y : bounds.min.y, (corner & 4) ? bounds.max.z : bounds.min.z, 1.0f);
+        glm::vec4 clip = m_viewProjection * p;
+        // Crossing the near plane, the projection is meaningless and the box is close anyway
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f || ndcMin.z > 1.0f)
+        return false;
+
+    // Occluders cover a pixel when they cover its center, so a box may overlap the uncovered part of
+    // an edge pixel. Growing the rect by a pixel reaches past such an edge to a pixel it leaves open.
+    const int x0 = glm::clamp(int(std::floor((ndcMin.x * 0.5f + 0.5f) * WIDTH)) - 1, 0, WIDTH - 1);
+    const int x1 = glm::clamp(int(std::floor((ndcMax.x * 0.5f + 0.5f) * WIDTH)) + 1, 0, WIDTH - 1);
+    const int y0 = glm::clamp(int(std::floor((ndcMin.y * 0.5f + 0.5f) * HEIGHT)) - 1, 0, HEIGHT - 1);
+    const int y1 = glm::clamp(int(std::floor((ndcMax.y * 0.5f + 0.5f) * HEIGHT)) + 1, 0, HEIGHT - 1);
+    const float nearest = ndcMin.z * 0.5f + 0.5f;
+
+    int level = 0;
+    while (level < LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+        level++;
+
+    // Visible when any covered texel has its farthest occluder behind the nearest point of the box
+    const int width = WIDTH >> level;
+    const float* depth = m_levels[level].data();
+    for (int y = y0 >> level; y <= y1 >> level; ++y)
+        for (int x = x0 >> level; x <= x1 >> level; ++x)
+            if (depth[y * width + x] > nearest)
+                return true;
+    return false;
+}
+
+size_t SoftwareOcclusion::TestBoxes(const std::vector<AABB>& boxes, std::vector<unsigned char>& visible)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    visible.resize(boxes.size());
+    auto test = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            visible[i] = IsVisible(boxes[i]) ? 1 : 0;
+    };
+    if (m_jobs)
+        m_jobs->ParallelFor(boxes.size(), 256, test);
+    else
+        test(0, boxes.size());
+
+    m_testMilliseconds = MillisecondsSince(start);
+    return size_t(std::count(visible.begin(), visible.end(), 0));
+}
+
+void SoftwareOcclusion::SetSimdEnabled(bool enabled)
+{
+    m_simd = enabled && (GLM_ARCH & GLM_ARCH_SSE2_BIT);
+}
+
+bool SoftwareOcclusion::IsSimdEnabled() const
+{
+    return m_simd;
+}
+
+size_t SoftwareOcclusion::GetTriangleCount() const
+{
+    return m_triangles.size();
+}
+
+double SoftwareOcclusion::GetRasterMilliseconds() const
+{
+    return m_rasterMilliseconds;
+}
+
+double SoftwareOcclusion::GetTestMilliseconds() const
+{
+    return m_testMilliseconds;
+}
+
+void SoftwareOcclusion::RunBenchmark()
+{
+    const int FRAMES = 20;
+    const size_t BUILDINGS = 256;
+    const size_t OBJECTS = 20000;
+
+    static const float cube[] = {
+        -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f, -0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,   0.5f,  0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,
+        -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f, -0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,   0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f,  0.5f, -0.5f
+    };
+
+    // A street of buildings in front of the camera with small props scattered between and behind them
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> buildingX(-40.0f, 40.0f), buildingZ(-80.0f, -8.0f), buildingSize(2.0f, 6.0f), buildingHeight(3.0f, 10.0f);
+    std::uniform_real_distribution<float> objectX(-50.0f, 50.0f), objectY(0.0f, 4.0f), objectZ(-90.0f, -5.0f), objectSize(0.5f, 2.0f);
+
+    std::vector<glm::mat4> buildings(BUILDINGS);
+    for (auto& model: buildings)
+    {
+        float height = buildingHeight(rng);
+        model = glm::translate(glm::mat4(), glm::vec3(buildingX(rng), height * 0.5f, buildingZ(rng)));
+        model = glm::scale(model, glm::vec3(buildingSize(rng), height, buildingSize(rng)));
+    }
+    std::vector<AABB> objects(OBJECTS);
+    for (auto& box: objects)
+    {
+        glm::vec3 center(objectX(rng), objectY(rng), objectZ(rng));
+        glm::vec3 extents(objectSize(rng) * 0.5f);
+        box = AABB(center - extents, center + extents);
+    }
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), float(WIDTH) / HEIGHT, 0.1f, 100.0f);
+
+    JobSystem jobs;
+    std::vector<unsigned char> visible;
+
+    std::cout << "SoftwareOcclusion benchmark, " << WIDTH << "x" << HEIGHT << ", " << BUILDINGS << " occluders, "
+        << OBJECTS << " boxes, average of " << FRAMES << " frames" << std::endl;
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            SoftwareOcclusion occlusion(threaded ? &jobs : nullptr);
+            occlusion.SetSimdEnabled(simd != 0);
+            if (simd && !occlusion.IsSimdEnabled())
+                continue;
+
+            double raster = 0.0, test = 0.0;
+            size_t culled = 0;
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                occlusion.BeginFrame(projection * view);
+                for (auto& model: buildings)
+                    occlusion.AddOccluder(cube, 36, model);
+                occlusion.Rasterize();
+                culled = occlusion.TestBoxes(objects, visible);
+                raster += occlusion.GetRasterMilliseconds();
+                test += occlusion.GetTestMilliseconds();
+            }
+            std::cout << "  " << (simd ? "simd  " : "scalar") << " x" << (threaded ? jobs.GetThreadCount() : 1)
+                << "  raster " << raster / FRAMES << " ms (" << occlusion.GetTriangleCount() << " triangles), test "
+                << test / FRAMES << " ms, " << culled << " culled" << std::endl;
+        }
+    }
+}
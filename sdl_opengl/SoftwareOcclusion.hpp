@@ -0,0 +1,95 @@
+#ifndef SOFTWARE_OCCLUSION_HPP
+#define SOFTWARE_OCCLUSION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+class JobSystem;
+
+// CPU occlusion culling: selected occluders are rasterized into a low resolution depth buffer
+// (SSE2/AVX, one screen tile per job) and a max-depth pyramid is built from it. Bounding boxes are
+// then tested against the pyramid level where they cover at most 2x2 texels. Needs no GL context.
+class SoftwareOcclusion
+{
+public:
+
+    static const int WIDTH = 256;
+    static const int HEIGHT = 160;
+    static const int TILE_SIZE = 32;
+    static const int TILES_X = WIDTH / TILE_SIZE;
+    static const int TILES_Y = HEIGHT / TILE_SIZE;
+    // Level 0 is the depth buffer, the last level has one texel per tile
+    static const int LEVELS = 6;
+
+    // jobs may be nullptr, then everything runs on the calling thread
+    explicit SoftwareOcclusion(JobSystem* jobs = nullptr);
+
+    // Drops the occluders of the previous frame
+    void BeginFrame(const glm::mat4& viewProjection);
+
+    // Triangle list, three floats per vertex. Triangles crossing the near plane are skipped, which
+    // only makes the culling more conservative.
+    void AddOccluder(const float* positions, size_t vertexCount, const glm::mat4& model);
+
+    // Rasterizes the occluders and builds the depth pyramid
+    void Rasterize();
+
+    // False when the box is outside the view or hidden behind the occluders
+    bool IsVisible(const AABB& bounds) const;
+
+    // Tests many boxes in parallel, returns the number of culled ones
+    size_t TestBoxes(const std::vector<AABB>& boxes, std::vector<unsigned char>& visible);
+
+    void SetSimdEnabled(bool enabled);
+
+    bool IsSimdEnabled() const;
+
+    size_t GetTriangleCount() const;
+
+    double GetRasterMilliseconds() const;
+
+    double GetTestMilliseconds() const;
+
+    // Reproducible city scene, prints raster and test times for every code path
+    static void RunBenchmark();
+
+private:
+
+    // Edge functions a*x + b*y + c >= 0 inside, depth z = za*x + zb*y + zc, in pixels
+    struct Triangle
+    {
+        float a[3], b[3], c[3];
+        float za, zb, zc;
+        int minX, minY, maxX, maxY;
+    };
+
+    void SetupTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+    void RasterizeTile(int tile);
+
+    void BuildTilePyramid(int tile);
+
+private:
+
+    JobSystem* m_jobs;
+
+    bool m_simd;
+
+    glm::mat4 m_viewProjection;
+
+    std::vector<Triangle> m_triangles;
+
+    std::vector<std::vector<std::uint32_t>> m_bins;
+
+    // Depth in [0, 1], nearest occluder per pixel on level 0, farthest of 2x2 texels above
+    std::vector<float> m_levels[LEVELS];
+
+    double m_rasterMilliseconds;
+
+    double m_testMilliseconds;
+};
+#endif
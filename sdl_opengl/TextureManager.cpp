@@ -0,0 +1,464 @@
+#include "TextureManager.hpp"
+#include "SelfTest.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TextureHandle::TextureHandle():m_manager{nullptr}, m_index{-1}
+{
+
+}
+
+TextureHandle::TextureHandle(TextureManager* manager, int index):m_manager{manager}, m_index{index}
+{
+    m_manager->AddRef(m_index);
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other):m_manager{other.m_manager}, m_index{other.m_index}
+{
+    if (m_manager)
+        m_manager->AddRef(m_index);
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other):m_manager{other.m_manager}, m_index{other.m_index}
+{
+    other.m_manager = nullptr;
+    other.m_index = -1;
+}
+
+TextureHandle::~TextureHandle()
+{
+    if (m_manager)
+        m_manager->Release(m_index);
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle other)
+{
+    std::swap(m_manager, other.m_manager);
+    std::swap(m_index, other.m_index);
+    return *this;
+}
+
+bool TextureHandle::IsValid() const
+{
+    return m_manager != nullptr;
+}
+
+GLuint TextureHandle::GetTextureID() const
+{
+    return m_manager ? m_manager->m_entries[m_index].textureID : 0;
+}
+
+int TextureHandle::GetWidth() const
+{
+    return m_manager ? m_manager->m_entries[m_index].image.levels[0].w : 0;
+}
+
+int TextureHandle::GetHeight() const
+{
+    return m_manager ? m_manager->m_entries[m_index].image.levels[0].h : 0;
+}
+
+const char* const TextureManager::DEFAULT_CACHE_DIRECTORY = "cache";
+
+TextureManager::TextureManager(JobSystem* jobs, size_t budgetBytes):
+    m_jobs{jobs}, m_budget{budgetBytes}, m_residentBytes{0}, m_frame{0}, m_cacheDirectory{DEFAULT_CACHE_DIRECTORY}
+{
+
+}
+
+TextureManager::~TextureManager()
+{
+    Shutdown();
+}
+
+TextureHandle TextureManager::Load(const std::string& fileName)
+{
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].alive && m_entries[i].name == fileName)
+            return TextureHandle(this, int(i));
+    }
+
+    TextureImage image;
+    TexturePrep prep(m_jobs);
+    bool loaded;
+    if (m_cacheDirectory.empty())
+    {
+        loaded = prep.LoadFile(fileName, image);
+    }
+    else
+    {
+        // The source path flattened into one file name, so res/a.png and res/b/a.png do not collide
+        std::string cacheName = fileName;
+        std::replace(cacheName.begin(), cacheName.end(), '/', '_');
+        std::replace(cacheName.begin(), cacheName.end(), '\\', '_');
+        std::replace(cacheName.begin(), cacheName.end(), ':', '_');
+        loaded = prep.LoadFileCached(fileName, m_cacheDirectory + "/" + cacheName + ".txc", image);
+    }
+    if (!loaded)
+    {
+        m_error = prep.GetError();
+        return TextureHandle();
+    }
+    return Add(fileName, std::move(image));
+}
+
+TextureHandle TextureManager::Add(const std::string& name, TextureImage image)
+{
+    if (image.levels.empty())
+    {
+        m_error = "Texture " + name + " has no levels";
+        return TextureHandle();
+    }
+
+    Entry entry;
+    entry.image = std::move(image);
+    const int last = int(entry.image.levels.size()) - 1;
+    entry.name = name;
+    entry.alive = true;
+    entry.residentMip = last + 1;
+    entry.wantedMip = last;
+    entry.lastUsedFrame = m_frame;
+
+    glGenTextures(1, &entry.textureID);
+    glBindTexture(GL_TEXTURE_2D, entry.textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Coarse levels are cheap and give something to sample right away
+    UploadMip(entry, last);
+    while (entry.residentMip > 0)
+    {
+        const TextureLevel& next = entry.image.levels[entry.residentMip - 1];
+        if (std::max(next.w, next.h) > STREAM_INITIAL_SIZE)
+            break;
+        UploadMip(entry, entry.residentMip - 1);
+    }
+
+    int index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_entries[index] = std::move(entry);
+    }
+    else
+    {
+        index = int(m_entries.size());
+        m_entries.push_back(std::move(entry));
+    }
+    return TextureHandle(this, index);
+}
+
+void TextureManager::Request(const TextureHandle& handle, float screenSize)
+{
+    if (handle.m_manager != this)
+        return;
+
+    Entry& entry = m_entries[handle.m_index];
+    const TextureLevel& base = entry.image.levels[0];
+    const int last = int(entry.image.levels.size()) - 1;
+
+    // Mip whose texel count roughly matches the pixels covered on screen
+    float ratio = float(std::max(base.w, base.h)) / std::max(screenSize, 1.0f);
+    int wanted = std::min(last, std::max(0, int(std::floor(std::log2(std::max(ratio, 1.0f))))));
+
+    if (entry.lastUsedFrame != m_frame)
+        entry.wantedMip = wanted;
+    else
+        entry.wantedMip = std::min(entry.wantedMip, wanted);
+    entry.lastUsedFrame = m_frame;
+}
+
+void TextureManager::Update()
+{
+    size_t uploaded = 0;
+    for (size_t i = 0; i < m_entries.size() && uploaded < MAX_UPLOAD_PER_FRAME; ++i)
+    {
+        Entry& entry = m_entries[i];
+        if (!entry.alive || entry.lastUsedFrame != m_frame)
+            continue;
+
+        // Refine one level at a time, the coarser level is already resident so there is no visible hole
+        while (entry.residentMip > entry.wantedMip && uploaded < MAX_UPLOAD_PER_FRAME)
+        {
+            int mip = entry.residentMip - 1;
+            size_t bytes = entry.image.levels[mip].pixels.size();
+            while (m_residentBytes + bytes > m_budget)
+            {
+                int victim = FindEvictionVictim(int(i));
+                if (victim < 0)
+                    break;
+                EvictMip(m_entries[victim]);
+            }
+            if (m_residentBytes + bytes > m_budget)
+                break;
+            UploadMip(entry, mip);
+            uploaded += bytes;
+        }
+    }
+
+    // The budget may have been lowered since the last frame
+    while (m_residentBytes > m_budget)
+    {
+        int victim = FindEvictionVictim(-1);
+        if (victim < 0)
+            break;
+        EvictMip(m_entries[victim]);
+    }
+
+    ++m_frame;
+}
+
+void TextureManager::Shutdown()
+{
+    for (auto& entry: m_entries)
+    {
+        if (entry.textureID)
+            glDeleteTextures(1, &entry.textureID);
+        entry.textureID = 0;
+    }
+    m_residentBytes = 0;
+}
+
+void TextureManager::SetBudget(size_t budgetBytes)
+{
+    m_budget = budgetBytes;
+}
+
+void TextureManager::SetCacheDirectory(const std::string& directory)
+{
+    m_cacheDirectory = directory;
+}
+
+size_t TextureManager::GetBudget() const
+{
+    return m_budget;
+}
+
+size_t TextureManager::GetResidentBytes() const
+{
+    return m_residentBytes;
+}
+
+std::vector<TextureStats> TextureManager::GetStats() const
+{
+    std::vector<TextureStats> stats;
+    for (auto& entry: m_entries)
+    {
+        if (!entry.alive)
+            continue;
+        TextureStats s;
+        s.name = entry.name;
+        s.width = entry.image.levels[0].w;
+        s.height = entry.image.levels[0].h;
+        s.levels = int(entry.image.levels.size());
+        s.residentMip = entry.residentMip;
+        s.wantedMip = entry.wantedMip;
+        s.refCount = entry.refCount;
+        s.residentBytes = entry.textureID ? GetBytesFrom(entry, entry.residentMip) : 0;
+        s.fullBytes = GetBytesFrom(entry, 0);
+        s.framesUnused = m_frame - entry.lastUsedFrame;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void TextureManager::PrintStats(std::ostream& out) const
+{
+    out << "Textures: " << m_residentBytes / 1024 << " KB resident of " << m_budget / 1024 << " KB budget" << std::endl;
+    for (auto& s: GetStats())
+    {
+        out << "  " << s.name << " " << s.width << "x" << s.height
+            << " mip " << s.residentMip << "/" << s.levels - 1 << " (wants " << s.wantedMip << ")"
+            << " " << s.residentBytes / 1024 << " of " << s.fullBytes / 1024 << " KB"
+            << " refs " << s.refCount << " unused " << s.framesUnused << " frames" << std::endl;
+    }
+}
+
+const std::string& TextureManager::GetError() const
+{
+    return m_error;
+}
+
+void TextureManager::AddRef(int index)
+{
+    m_entries[index].refCount++;
+}
+
+void TextureManager::Release(int index)
+{
+    Entry& entry = m_entries[index];
+    if (--entry.refCount > 0)
+        return;
+
+    if (entry.textureID)
+    {
+        m_residentBytes -= GetBytesFrom(entry, entry.residentMip);
+        glDeleteTextures(1, &entry.textureID);
+    }
+    entry = Entry();
+    m_freeSlots.push_back(index);
+}
+
+size_t TextureManager::GetBytesFrom(const Entry& entry, int mip) const
+{
+    size_t bytes = 0;
+    for (size_t level = size_t(mip); level < entry.image.levels.size(); ++level)
+        bytes += entry.image.levels[level].pixels.size();
+    return bytes;
+}
+
+void TextureManager::UploadMip(Entry& entry, int mip)
+{
+    const TextureLevel& level = entry.image.levels[mip];
+    glBindTexture(GL_TEXTURE_2D, entry.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA, level.w, level.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mip);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    entry.residentMip = mip;
+    m_residentBytes += level.pixels.size();
+}
+
+void TextureManager::EvictMip(Entry& entry)
+{
+    const int mip = entry.residentMip;
+    // A zero sized image releases the level storage, the base level keeps the texture complete
+    glBindTexture(GL_TEXTURE_2D, entry.textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mip + 1);
+    glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    entry.residentMip = mip + 1;
+    m_residentBytes -= entry.image.levels[mip].pixels.size();
+}
+
+int TextureManager::FindEvictionVictim(int exclude) const
+{
+    int victim = -1;
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        const Entry& entry = m_entries[i];
+        const int last = int(entry.image.levels.size()) - 1;
+        if (!entry.alive || !entry.textureID || int(i) == exclude || entry.residentMip >= last)
+            continue;
+
+        // Textures drawn this frame only give up mips finer than they asked for
+        if (entry.lastUsedFrame == m_frame && entry.residentMip >= entry.wantedMip)
+            continue;
+
+        if (victim < 0 || entry.lastUsedFrame < m_entries[victim].lastUsedFrame)
+            victim = int(i);
+    }
+    return victim;
+}
+
+bool TextureManager::RunTests()
+{
+    SelfTest test("TextureManager");
+
+    // The uploads need a GL context of their own, the window is never shown
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        return test.Skip(std::string("no video: ") + SDL_GetError());
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_Window* window = SDL_CreateWindow("TextureManager tests", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = window ? SDL_GL_CreateContext(window) : nullptr;
+    glewExperimental = GL_TRUE;
+    if (!context || glewInit() != GLEW_OK)
+    {
+        std::string reason = std::string("no GL context: ") + SDL_GetError();
+        if (context)
+            SDL_GL_DeleteContext(context);
+        if (window)
+            SDL_DestroyWindow(window);
+        SDL_Quit();
+        return test.Skip(reason);
+    }
+
+    const int SIZE = 1024;
+    TextureImage image;
+    image.levels.resize(1);
+    image.levels[0].w = SIZE;
+    image.levels[0].h = SIZE;
+    image.levels[0].pixels.resize(size_t(SIZE) * SIZE * 4);
+    for (size_t i = 0; i < image.levels[0].pixels.size(); ++i)
+        image.levels[0].pixels[i] = static_cast<unsigned char>((i * 7) ^ (i >> 12));
+    TexturePrep prep;
+    prep.BuildMipChain(image, MipFilter::Box);
+    const size_t fullBytes = image.GetByteSize();
+    int coarseMip = 0;
+    while (std::max(image.levels[coarseMip].w, image.levels[coarseMip].h) > STREAM_INITIAL_SIZE)
+        coarseMip++;
+
+    auto find = [](const TextureManager& manager, const std::string& name)
+    {
+        for (auto& s: manager.GetStats())
+        {
+            if (s.name == name)
+                return s;
+        }
+        return TextureStats();
+    };
+    auto residentMip = [&find](const TextureManager& manager, const std::string& name)
+    {
+        return find(manager, name).residentMip;
+    };
+
+    {
+        TextureManager manager(nullptr, 2 * fullBytes);
+        manager.SetCacheDirectory("");
+        TextureHandle a = manager.Add("a", image);
+        test.Check(a.IsValid() && residentMip(manager, "a") == coarseMip, "only the coarse mips are resident after loading");
+
+        // A full screen footprint streams in every level, the whole chain fits in one frame's upload limit
+        manager.Request(a, float(SIZE));
+        manager.Update();
+        test.Check(residentMip(manager, "a") == 0, "a full screen footprint streams in the base level");
+        test.Check(manager.GetResidentBytes() == fullBytes, "resident bytes count every uploaded level");
+
+        // Room for one full chain only, a was not drawn this frame and gives its fine mips to b
+        manager.SetBudget(fullBytes + fullBytes / 2);
+        TextureHandle b = manager.Add("b", image);
+        manager.Request(b, float(SIZE));
+        manager.Update();
+        test.Check(residentMip(manager, "b") == 0, "b streams in under the budget");
+        test.Check(residentMip(manager, "a") > 0, "the least recently used texture is evicted");
+        test.Check(manager.GetResidentBytes() <= manager.GetBudget(), "streaming stays under the budget");
+
+        // A small footprint only asks for the matching mip
+        manager.Request(a, float(SIZE / 8));
+        manager.Request(b, float(SIZE));
+        manager.Update();
+        test.Check(find(manager, "a").wantedMip == 3, "a footprint of 1/8 of the size wants mip 3");
+        test.Check(residentMip(manager, "b") == 0, "a drawn texture keeps the mips it asked for");
+
+        // A lowered budget is enforced on the next update, even without requests
+        manager.SetBudget(fullBytes / 2);
+        manager.Update();
+        test.Check(manager.GetResidentBytes() <= manager.GetBudget(), "a lowered budget evicts down to it");
+        test.Check(residentMip(manager, "b") > 0, "the base level is evicted first");
+
+        // Requests over the budget are refined as far as it allows
+        manager.Request(a, float(SIZE));
+        manager.Request(b, float(SIZE));
+        manager.Update();
+        test.Check(manager.GetResidentBytes() <= manager.GetBudget(), "competing requests stay under the budget");
+
+        a = TextureHandle();
+        b = TextureHandle();
+        test.Check(manager.GetResidentBytes() == 0 && manager.GetStats().empty(), "the last handle releases the texture");
+    }
+
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return test.Finish();
+}
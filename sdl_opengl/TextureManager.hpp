@@ -0,0 +1,169 @@
+#ifndef TEXTURE_MANAGER_HPP
+#define TEXTURE_MANAGER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "TexturePrep.hpp"
+
+class TextureManager;
+class JobSystem;
+
+// Reference counted texture reference, the GL texture is released together with the last handle
+class TextureHandle
+{
+public:
+
+    TextureHandle();
+
+    TextureHandle(const TextureHandle& other);
+
+    TextureHandle(TextureHandle&& other);
+
+    ~TextureHandle();
+
+    TextureHandle& operator=(TextureHandle other);
+
+    bool IsValid() const;
+
+    GLuint GetTextureID() const;
+
+    int GetWidth() const;
+
+    int GetHeight() const;
+
+private:
+
+    friend class TextureManager;
+
+    TextureHandle(TextureManager* manager, int index);
+
+private:
+
+    TextureManager* m_manager;
+
+    int m_index;
+};
+
+// Per texture residency information
+struct TextureStats
+{
+    std::string name;
+    int width{ 0 };
+    int height{ 0 };
+    int levels{ 0 };
+    int residentMip{ 0 };
+    int wantedMip{ 0 };
+    int refCount{ 0 };
+    size_t residentBytes{ 0 };
+    size_t fullBytes{ 0 };
+    unsigned framesUnused{ 0 };
+};
+
+// Keeps textures under a GPU memory budget. Textures start with their coarse mips only, finer
+// mips are streamed in when Request() reports a large enough screen footprint, and the least
+// recently used fine mips are evicted whenever the budget is exceeded.
+class TextureManager
+{
+public:
+
+    explicit TextureManager(JobSystem* jobs = nullptr, size_t budgetBytes = DEFAULT_BUDGET);
+
+    ~TextureManager();
+
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+
+    // Returns an invalid handle and sets the error on failure. Loading the same file twice shares the texture.
+    TextureHandle Load(const std::string& fileName);
+
+    // Takes over an already prepared mip chain, name identifies it for Load() and the stats
+    TextureHandle Add(const std::string& name, TextureImage image);
+
+    // Marks the texture as used this frame, screenSize is the largest on-screen extent in pixels
+    void Request(const TextureHandle& handle, float screenSize);
+
+    // Once per frame: uploads refined mips within the per-frame upload limit and enforces the budget
+    void Update();
+
+    // Deletes every GL texture, must run while the GL context is still current
+    void Shutdown();
+
+    void SetBudget(size_t budgetBytes);
+
+    // Where the prepared mip chains are cached between runs, empty disables the cache
+    void SetCacheDirectory(const std::string& directory);
+
+    size_t GetBudget() const;
+
+    size_t GetResidentBytes() const;
+
+    std::vector<TextureStats> GetStats() const;
+
+    void PrintStats(std::ostream& out) const;
+
+    const std::string& GetError() const;
+
+    // Streams, refines and evicts generated textures on a hidden GL context, false when a check fails
+    static bool RunTests();
+
+    static const size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    static const char* const DEFAULT_CACHE_DIRECTORY;
+
+    // Levels up to this size are uploaded immediately on load
+    static const int STREAM_INITIAL_SIZE = 64;
+
+    static const size_t MAX_UPLOAD_PER_FRAME = 8 * 1024 * 1024;
+
+private:
+
+    friend class TextureHandle;
+
+    struct Entry
+    {
+        std::string name;
+        TextureImage image;
+        GLuint textureID{ 0 };
+        int refCount{ 0 };
+        int residentMip{ 0 };
+        int wantedMip{ 0 };
+        unsigned lastUsedFrame{ 0 };
+        bool alive{ false };
+    };
+
+    void AddRef(int index);
+
+    void Release(int index);
+
+    size_t GetBytesFrom(const Entry& entry, int mip) const;
+
+    void UploadMip(Entry& entry, int mip);
+
+    void EvictMip(Entry& entry);
+
+    int FindEvictionVictim(int exclude) const;
+
+private:
+
+    JobSystem* m_jobs;
+
+    std::vector<Entry> m_entries;
+
+    std::vector<int> m_freeSlots;
+
+    size_t m_budget;
+
+    size_t m_residentBytes;
+
+    unsigned m_frame;
+
+    std::string m_cacheDirectory;
+
+    std::string m_error;
+};
+#endif
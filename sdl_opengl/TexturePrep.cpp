@@ -0,0 +1,702 @@
+#include "TexturePrep.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <SDL_image.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace
+{
+    const char CACHE_MAGIC[4] = { 'T', 'X', 'C', '2' };
+
+    // Bumped whenever the stored pixels change for the same source and filter (format, encoding)
+    const std::uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t filter;
+        std::uint32_t levelCount;
+        std::uint64_t sourceSize;
+        std::int64_t sourceTime;
+    };
+
+    // Creates the directory part of fileName, one level deep, if it does not exist yet
+    void CreateParentDirectory(const std::string& fileName)
+    {
+        size_t slash = fileName.find_last_of("/\\");
+        if (slash == std::string::npos || slash == 0)
+            return;
+        std::string dir = fileName.substr(0, slash);
+#ifdef _WIN32
+        _mkdir(dir.c_str());
+#else
+        mkdir(dir.c_str(), 0755);
+#endif
+    }
+
+    // Kaiser windowed sinc, 6 taps for a 2:1 reduction (support of 3 destination texels)
+    const int KAISER_TAPS = 6;
+    const float KAISER_ALPHA = 4.0f;
+
+    struct ColorTables
+    {
+        float toLinear[256];
+        unsigned char toSRGB[4096];
+        float kaiser[KAISER_TAPS];
+
+        ColorTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < 4096; ++i)
+            {
+                float l = i / 4095.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                toSRGB[i] = static_cast<unsigned char>(std::min(255.0f, c * 255.0f + 0.5f));
+            }
+
+            float sum = 0.0f;
+            for (int k = 0; k < KAISER_TAPS; ++k)
+            {
+                // Distance from the destination texel center, measured in source texels
+                float x = (k - KAISER_TAPS / 2) + 0.5f;
+                float t = x / (KAISER_TAPS / 2);
+                float window = BesselI0(KAISER_ALPHA * std::sqrt(std::max(0.0f, 1.0f - t * t))) / BesselI0(KAISER_ALPHA);
+                float arg = 3.14159265f * x * 0.5f;
+                float sinc = std::sin(arg) / arg;
+                kaiser[k] = sinc * window;
+                sum += kaiser[k];
+            }
+            for (auto& w: kaiser)
+                w /= sum;
+        }
+
+        static float BesselI0(float x)
+        {
+            float sum = 1.0f;
+            float term = 1.0f;
+            for (int k = 1; k < 16; ++k)
+            {
+                term *= (x * 0.5f / k) * (x * 0.5f / k);
+                sum += term;
+            }
+            return sum;
+        }
+    };
+
+    const ColorTables& Tables()
+    {
+        static const ColorTables tables;
+        return tables;
+    }
+
+    inline int Clamp(int v, int lo, int hi)
+    {
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    // sRGB encode of one linear RGBA texel in [0, 1], alpha passes through. Above the linear
+    // segment x^(1/2.4) is fitted with x^(1/2), x^(1/4) and x^(1/8), three square roots, and
+    // stays within 0.06 of an 8-bit step of the exact curve.
+    inline __m128 EncodeSRGB(__m128 l)
+    {
+        const __m128 alpha = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+        __m128 r2 = _mm_sqrt_ps(l);
+        __m128 r4 = _mm_sqrt_ps(r2);
+        __m128 r8 = _mm_sqrt_ps(r4);
+        __m128 curve = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(0.55449105f)), _mm_mul_ps(r4, _mm_set1_ps(0.90004957f))),
+            _mm_add_ps(_mm_mul_ps(r8, _mm_set1_ps(-0.48878977f)), _mm_set1_ps(0.03444968f)));
+        __m128 linear = _mm_mul_ps(l, _mm_set1_ps(12.92f));
+        linear = _mm_or_ps(_mm_and_ps(alpha, l), _mm_andnot_ps(alpha, linear));
+        __m128 useLinear = _mm_or_ps(_mm_cmple_ps(l, _mm_set1_ps(0.0031308f)), alpha);
+        return _mm_or_ps(_mm_and_ps(useLinear, linear), _mm_andnot_ps(useLinear, curve));
+    }
+#endif
+
+    // SDL pixel format whose memory layout is R, G, B, A bytes
+    const Uint32 RGBA_BYTE_FORMAT = SDL_BYTEORDER == SDL_BIG_ENDIAN ? SDL_PIXELFORMAT_RGBA8888 : SDL_PIXELFORMAT_ABGR8888;
+
+    // BGRA bytes in memory to RGBA bytes, used for SDL_PIXELFORMAT_ARGB8888 on little endian hosts
+    void SwizzleBGRA(const unsigned char* src, unsigned char* dst, int count, bool simd)
+    {
+        int i = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        if (simd)
+        {
+            const __m128i keep = _mm_set1_epi32(0xFF00FF00);
+            const __m128i low = _mm_set1_epi32(0x000000FF);
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+                __m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+                __m128i out = _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(r, b));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), out);
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < count; ++i)
+        {
+            dst[i * 4 + 0] = src[i * 4 + 2];
+            dst[i * 4 + 1] = src[i * 4 + 1];
+            dst[i * 4 + 2] = src[i * 4 + 0];
+            dst[i * 4 + 3] = src[i * 4 + 3];
+        }
+    }
+
+    void ExpandRGB(const unsigned char* src, unsigned char* dst, int count, bool bgr)
+    {
+        const int r = bgr ? 2 : 0;
+        const int b = bgr ? 0 : 2;
+        for (int i = 0; i < count; ++i)
+        {
+            dst[i * 4 + 0] = src[i * 3 + r];
+            dst[i * 4 + 1] = src[i * 3 + 1];
+            dst[i * 4 + 2] = src[i * 3 + b];
+            dst[i * 4 + 3] = 255;
+        }
+    }
+
+    double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+size_t TextureImage::GetByteSize() const
+{
+    size_t size = 0;
+    for (auto& level: levels)
+        size += level.pixels.size();
+    return size;
+}
+
+TexturePrep::TexturePrep(JobSystem* jobs):m_jobs{jobs}, m_simd{GLM_ARCH & GLM_ARCH_SSE2_BIT ? true : false}
+{
+
+}
+
+bool TexturePrep::LoadFile(const std::string& fileName, TextureImage& image, MipFilter filter)
+{
+    SDL_Surface* surface = IMG_Load(fileName.c_str());
+    if (!surface)
+    {
+        m_error = "Unable to load " + fileName + ": " + IMG_GetError();
+        return false;
+    }
+
+    image.levels.assign(1, TextureLevel());
+    bool converted = ConvertSurface(surface, image.levels[0]);
+    SDL_FreeSurface(surface);
+    if (!converted)
+        return false;
+
+    BuildMipChain(image, filter);
+    return true;
+}
+
+bool TexturePrep::LoadFileCached(const std::string& fileName, const std::string& cacheFileName, TextureImage& image, MipFilter filter)
+{
+    TextureCacheKey key;
+    // Without the source there is nothing to validate the cache against, LoadFile reports the error
+    bool hasKey = GetCacheKey(fileName, filter, key);
+    if (hasKey && LoadCache(cacheFileName, key, image))
+        return true;
+    if (!LoadFile(fileName, image, filter))
+        return false;
+    // A failed cache write is not fatal, the texture is already in memory
+    if (hasKey)
+    {
+        CreateParentDirectory(cacheFileName);
+        SaveCache(cacheFileName, key, image);
+    }
+    return true;
+}
+
+bool TexturePrep::GetCacheKey(const std::string& fileName, MipFilter filter, TextureCacheKey& key)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0)
+        return false;
+    key.sourceSize = std::uint64_t(info.st_size);
+    key.sourceTime = std::int64_t(info.st_mtime);
+    key.filter = filter;
+    return true;
+}
+
+bool TexturePrep::ConvertSurface(SDL_Surface* surface, TextureLevel& level)
+{
+    if (!surface || surface->w <= 0 || surface->h <= 0)
+    {
+        m_error = "TexturePrep::ConvertSurface: empty surface";
+        return false;
+    }
+
+    Uint32 format = surface->format->format;
+    const bool fastPath = SDL_BYTEORDER == SDL_LIL_ENDIAN &&
+        (format == SDL_PIXELFORMAT_ABGR8888 || format == SDL_PIXELFORMAT_ARGB8888 ||
+         format == SDL_PIXELFORMAT_RGB24 || format == SDL_PIXELFORMAT_BGR24);
+
+    SDL_Surface* source = surface;
+    if (!fastPath)
+    {
+        // Paletted, 16-bit, 10-bit and the remaining exotic layouts go through SDL's blitter
+        source = SDL_ConvertSurfaceFormat(surface, RGBA_BYTE_FORMAT, 0);
+        if (!source)
+        {
+            m_error = "TexturePrep::ConvertSurface: " + std::string(SDL_GetError());
+            return false;
+        }
+        format = RGBA_BYTE_FORMAT;
+    }
+
+    if (SDL_MUSTLOCK(source))
+        SDL_LockSurface(source);
+
+    level.w = source->w;
+    level.h = source->h;
+    level.pixels.resize(size_t(level.w) * level.h * 4);
+
+    const unsigned char* pixels = static_cast<const unsigned char*>(source->pixels);
+    const int pitch = source->pitch;
+    const int width = level.w;
+    const int rowBytes = width * 4;
+    unsigned char* dst = level.pixels.data();
+    const bool simd = m_simd;
+
+    ForEachRow(level.h, [=](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            const unsigned char* srcRow = pixels + size_t(y) * pitch;
+            unsigned char* dstRow = dst + size_t(y) * rowBytes;
+            if (format == RGBA_BYTE_FORMAT)
+                std::memcpy(dstRow, srcRow, rowBytes);
+            else if (format == SDL_PIXELFORMAT_ARGB8888)
+                SwizzleBGRA(srcRow, dstRow, width, simd);
+            else
+                ExpandRGB(srcRow, dstRow, width, format == SDL_PIXELFORMAT_BGR24);
+        }
+    });
+
+    if (SDL_MUSTLOCK(source))
+        SDL_UnlockSurface(source);
+    if (source != surface)
+        SDL_FreeSurface(source);
+    return true;
+}
+
+void TexturePrep::BuildMipChain(TextureImage& image, MipFilter filter)
+{
+    if (image.levels.empty())
+        return;
+    image.levels.resize(1);
+
+    std::vector<float> current;
+    std::vector<float> next;
+    DecodeLinear(image.levels[0], current);
+
+    int w = image.levels[0].w;
+    int h = image.levels[0].h;
+    while (w > 1 || h > 1)
+    {
+        int nw = std::max(1, w / 2);
+        int nh = std::max(1, h / 2);
+        next.resize(size_t(nw) * nh * 4);
+        if (filter == MipFilter::Kaiser)
+            DownsampleKaiser(current, w, h, next, nw, nh);
+        else
+            DownsampleBox(current, w, h, next, nw, nh);
+
+        TextureLevel level;
+        level.w = nw;
+        level.h = nh;
+        EncodeLevel(next, level);
+        image.levels.push_back(std::move(level));
+
+        current.swap(next);
+        w = nw;
+        h = nh;
+    }
+}
+
+bool TexturePrep::SaveCache(const std::string& cacheFileName, const TextureCacheKey& key, const TextureImage& image)
+{
+    std::ofstream file(cacheFileName, std::ios::binary);
+    if (!file)
+    {
+        m_error = "Unable to write texture cache " + cacheFileName;
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.filter = static_cast<std::uint32_t>(key.filter);
+    header.levelCount = static_cast<std::uint32_t>(image.levels.size());
+    header.sourceSize = key.sourceSize;
+    header.sourceTime = key.sourceTime;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto& level: image.levels)
+    {
+        std::int32_t dims[2] = { level.w, level.h };
+        file.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+        file.write(reinterpret_cast<const char*>(level.pixels.data()), level.pixels.size());
+    }
+    return bool(file);
+}
+
+bool TexturePrep::LoadCache(const std::string& cacheFileName, const TextureCacheKey& key, TextureImage& image)
+{
+    std::ifstream file(cacheFileName, std::ios::binary);
+    if (!file)
+    {
+        m_error = "Texture cache " + cacheFileName + " not found";
+        return false;
+    }
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.levelCount == 0 || header.levelCount > 32)
+    {
+        m_error = "Texture cache " + cacheFileName + " is corrupted";
+        return false;
+    }
+    if (header.version != CACHE_VERSION || header.filter != static_cast<std::uint32_t>(key.filter) ||
+        header.sourceSize != key.sourceSize || header.sourceTime != key.sourceTime)
+    {
+        m_error = "Texture cache " + cacheFileName + " is out of date";
+        return false;
+    }
+
+    image.levels.resize(header.levelCount);
+    for (auto& level: image.levels)
+    {
+        std::int32_t dims[2];
+        file.read(reinterpret_cast<char*>(dims), sizeof(dims));
+        if (!file || dims[0] <= 0 || dims[1] <= 0 || dims[0] > 65536 || dims[1] > 65536)
+        {
+            m_error = "Texture cache " + cacheFileName + " is corrupted";
+            image.levels.clear();
+            return false;
+        }
+        level.w = dims[0];
+        level.h = dims[1];
+        level.pixels.resize(size_t(level.w) * level.h * 4);
+        file.read(reinterpret_cast<char*>(level.pixels.data()), level.pixels.size());
+    }
+    if (!file)
+    {
+        m_error = "Texture cache " + cacheFileName + " is truncated";
+        image.levels.clear();
+        return false;
+    }
+    return true;
+}
+
+void TexturePrep::SetSimdEnabled(bool enabled)
+{
+    m_simd = enabled && (GLM_ARCH & GLM_ARCH_SSE2_BIT);
+}
+
+bool TexturePrep::IsSimdEnabled() const
+{
+    return m_simd;
+}
+
+const std::string& TexturePrep::GetError() const
+{
+    return m_error;
+}
+
+void TexturePrep::ForEachRow(int rows, const std::function<void(int, int)>& fn)
+{
+    if (!m_jobs)
+        return fn(0, rows);
+
+    // At least 16 rows per chunk so the small mip levels stay on one thread
+    m_jobs->ParallelFor(size_t(rows), 16, [&fn](size_t begin, size_t end)
+    {
+        fn(int(begin), int(end));
+    });
+}
+
+void TexturePrep::DecodeLinear(const TextureLevel& level, std::vector<float>& linear)
+{
+    const ColorTables& tables = Tables();
+    linear.resize(size_t(level.w) * level.h * 4);
+    const unsigned char* src = level.pixels.data();
+    float* dst = linear.data();
+    const size_t rowTexels = size_t(level.w);
+
+    ForEachRow(level.h, [&](int begin, int end)
+    {
+        for (size_t i = begin * rowTexels; i < end * rowTexels; ++i)
+        {
+            dst[i * 4 + 0] = tables.toLinear[src[i * 4 + 0]];
+            dst[i * 4 + 1] = tables.toLinear[src[i * 4 + 1]];
+            dst[i * 4 + 2] = tables.toLinear[src[i * 4 + 2]];
+            dst[i * 4 + 3] = src[i * 4 + 3] * (1.0f / 255.0f);
+        }
+    });
+}
+
+void TexturePrep::EncodeLevel(const std::vector<float>& linear, TextureLevel& level)
+{
+    const ColorTables& tables = Tables();
+    level.pixels.resize(size_t(level.w) * level.h * 4);
+    const float* src = linear.data();
+    unsigned char* dst = level.pixels.data();
+    const size_t rowTexels = size_t(level.w);
+    const bool simd = m_simd;
+
+    ForEachRow(level.h, [&](int begin, int end)
+    {
+        size_t i = begin * rowTexels;
+        const size_t last = end * rowTexels;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        if (simd)
+        {
+            // Four texels per iteration, the 16 channels are packed down to 16 bytes with saturation
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 scale = _mm_set1_ps(255.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (; i + 4 <= last; i += 4)
+            {
+                __m128i q[4];
+                for (int t = 0; t < 4; ++t)
+                {
+                    __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + (i + t) * 4), zero), one);
+                    q[t] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(EncodeSRGB(v), scale), half));
+                }
+                __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), bytes);
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < last; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                float v = std::min(1.0f, std::max(0.0f, src[i * 4 + c]));
+                dst[i * 4 + c] = tables.toSRGB[int(v * 4095.0f + 0.5f)];
+            }
+            float a = std::min(1.0f, std::max(0.0f, src[i * 4 + 3]));
+            dst[i * 4 + 3] = static_cast<unsigned char>(a * 255.0f + 0.5f);
+        }
+    });
+}
+
+void TexturePrep::DownsampleBox(const std::vector<float>& src, int srcW, int srcH, std::vector<float>& dst, int dstW, int dstH)
+{
+    const float* in = src.data();
+    float* out = dst.data();
+    const bool simd = m_simd;
+
+    ForEachRow(dstH, [=](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            const float* row0 = in + size_t(Clamp(2 * y, 0, srcH - 1)) * srcW * 4;
+            const float* row1 = in + size_t(Clamp(2 * y + 1, 0, srcH - 1)) * srcW * 4;
+            float* outRow = out + size_t(y) * dstW * 4;
+            int x = 0;
+            // The 2x2 footprint never needs clamping horizontally unless the source is one texel wide
+            if (srcW > 1)
+            {
+#if GLM_ARCH & GLM_ARCH_AVX_BIT
+                if (simd)
+                {
+                    // One 256-bit load covers the two horizontally adjacent RGBA texels
+                    const __m128 quarter = _mm_set1_ps(0.25f);
+                    for (; x < dstW; ++x)
+                    {
+                        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+                        __m128 texel = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+                        _mm_storeu_ps(outRow + x * 4, _mm_mul_ps(texel, quarter));
+                    }
+                }
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+                if (simd)
+                {
+                    const __m128 quarter = _mm_set1_ps(0.25f);
+                    for (; x < dstW; ++x)
+                    {
+                        __m128 a = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+                        __m128 b = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+                        _mm_storeu_ps(outRow + x * 4, _mm_mul_ps(_mm_add_ps(a, b), quarter));
+                    }
+                }
+#else
+                (void)simd;
+#endif
+            }
+            for (; x < dstW; ++x)
+            {
+                int x0 = Clamp(2 * x, 0, srcW - 1) * 4;
+                int x1 = Clamp(2 * x + 1, 0, srcW - 1) * 4;
+                for (int c = 0; c < 4; ++c)
+                    outRow[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+            }
+        }
+    });
+}
+
+void TexturePrep::DownsampleKaiser(const std::vector<float>& src, int srcW, int srcH, std::vector<float>& dst, int dstW, int dstH)
+{
+    const float* weights = Tables().kaiser;
+    const bool simd = m_simd;
+
+    // Horizontal pass into scratch (dstW x srcH), then vertical pass into dst
+    m_scratch.resize(size_t(dstW) * srcH * 4);
+    const float* in = src.data();
+    float* tmp = m_scratch.data();
+
+    ForEachRow(srcH, [=](int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            const float* row = in + size_t(y) * srcW * 4;
+            float* outRow = tmp + size_t(y) * dstW * 4;
+            for (int x = 0; x < dstW; ++x)
+            {
+                int first = 2 * x - KAISER_TAPS / 2 + 1;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+                if (simd)
+                {
+                    __m128 acc = _mm_setzero_ps();
+                    for (int k = 0; k < KAISER_TAPS; ++k)
+                    {
+                        __m128 texel = _mm_loadu_ps(row + Clamp(first + k, 0, srcW - 1) * 4);
+                        acc = _mm_add_ps(acc, _mm_mul_ps(texel, _mm_set1_ps(weights[k])));
+                    }
+                    _mm_storeu_ps(outRow + x * 4, acc);
+                    continue;
+                }
+#else
+                (void)simd;
+#endif
+                float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int k = 0; k < KAISER_TAPS; ++k)
+                {
+                    const float* texel = row + Clamp(first + k, 0, srcW - 1) * 4;
+                    for (int c = 0; c < 4; ++c)
+                        acc[c] += texel[c] * weights[k];
+                }
+                std::memcpy(outRow + x * 4, acc, sizeof(acc));
+            }
+        }
+    });
+
+    float* out = dst.data();
+    ForEachRow(dstH, [=](int begin, int end)
+    {
+        const float* rows[KAISER_TAPS];
+        for (int y = begin; y < end; ++y)
+        {
+            int first = 2 * y - KAISER_TAPS / 2 + 1;
+            for (int k = 0; k < KAISER_TAPS; ++k)
+                rows[k] = tmp + size_t(Clamp(first + k, 0, srcH - 1)) * dstW * 4;
+            float* outRow = out + size_t(y) * dstW * 4;
+            int i = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+            if (simd)
+            {
+                for (; i < dstW * 4; i += 4)
+                {
+                    __m128 acc = _mm_setzero_ps();
+                    for (int k = 0; k < KAISER_TAPS; ++k)
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+                    _mm_storeu_ps(outRow + i, acc);
+                }
+            }
+#endif
+            for (; i < dstW * 4; ++i)
+            {
+                float acc = 0.0f;
+                for (int k = 0; k < KAISER_TAPS; ++k)
+                    acc += rows[k][i] * weights[k];
+                outRow[i] = acc;
+            }
+        }
+    });
+}
+
+void TexturePrep::RunBenchmark()
+{
+    const int SIZE = 2048;
+    const int RUNS = 3;
+
+    SDL_Surface* surface = SDL_CreateRGBSurface(0, SIZE, SIZE, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (!surface)
+    {
+        std::cout << "TexturePrep benchmark: " << SDL_GetError() << std::endl;
+        return;
+    }
+    unsigned char* pixels = static_cast<unsigned char*>(surface->pixels);
+    for (int y = 0; y < SIZE; ++y)
+        for (int x = 0; x < SIZE * 4; ++x)
+            pixels[y * surface->pitch + x] = static_cast<unsigned char>((x * 7) ^ (y * 13));
+
+    JobSystem jobs;
+    const double megabytes = double(SIZE) * SIZE * 4 / (1024.0 * 1024.0);
+
+    std::cout << "TexturePrep benchmark, " << SIZE << "x" << SIZE << " RGBA8, best of " << RUNS << " runs" << std::endl;
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            TexturePrep prep(threaded ? &jobs : nullptr);
+            prep.SetSimdEnabled(simd != 0);
+            if (simd && !prep.IsSimdEnabled())
+                continue;
+
+            double convert = 1e9, box = 1e9, kaiser = 1e9;
+            for (int run = 0; run < RUNS; ++run)
+            {
+                TextureImage image;
+                image.levels.resize(1);
+                auto start = std::chrono::high_resolution_clock::now();
+                prep.ConvertSurface(surface, image.levels[0]);
+                convert = std::min(convert, SecondsSince(start));
+
+                start = std::chrono::high_resolution_clock::now();
+                prep.BuildMipChain(image, MipFilter::Box);
+                box = std::min(box, SecondsSince(start));
+
+                start = std::chrono::high_resolution_clock::now();
+                prep.BuildMipChain(image, MipFilter::Kaiser);
+                kaiser = std::min(kaiser, SecondsSince(start));
+            }
+
+            std::cout << "  " << (simd ? "simd  " : "scalar") << " x" << (threaded ? jobs.GetThreadCount() : 1)
+                << "  convert " << megabytes / convert << " MB/s"
+                << ", box mips " << megabytes / box << " MB/s"
+                << ", kaiser mips " << megabytes / kaiser << " MB/s" << std::endl;
+        }
+    }
+
+    SDL_FreeSurface(surface);
+}
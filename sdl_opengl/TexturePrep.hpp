@@ -0,0 +1,106 @@
+#ifndef TEXTURE_PREP_HPP
+#define TEXTURE_PREP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+class JobSystem;
+
+// Downsampling filter used to build the mip chain
+enum class MipFilter
+{
+    Box,
+    Kaiser
+};
+
+// One mip level as tightly packed RGBA8 rows, ready for glTexImage2D(GL_RGBA, GL_UNSIGNED_BYTE)
+struct TextureLevel
+{
+    int w{ 0 };
+    int h{ 0 };
+    std::vector<unsigned char> pixels;
+};
+
+// Full mip chain, levels[0] is the base image
+struct TextureImage
+{
+    std::vector<TextureLevel> levels;
+
+    size_t GetByteSize() const;
+};
+
+// What a cached mip chain was built from, a cache whose key differs from the source's is rebuilt
+struct TextureCacheKey
+{
+    std::uint64_t sourceSize{ 0 };
+    std::int64_t sourceTime{ 0 };
+    MipFilter filter{ MipFilter::Box };
+};
+
+// CPU side texture ingest: converts any SDL surface to the GL upload format and builds
+// a gamma-correct mip chain (filtering happens in linear space, storage stays sRGB)
+class TexturePrep
+{
+public:
+
+    // jobs may be nullptr, then everything runs on the calling thread
+    explicit TexturePrep(JobSystem* jobs = nullptr);
+
+    bool LoadFile(const std::string& fileName, TextureImage& image, MipFilter filter = MipFilter::Box);
+
+    // Reads cacheFileName when it was built from the current fileName with the same filter,
+    // otherwise loads fileName and writes the cache (creating its directory if needed)
+    bool LoadFileCached(const std::string& fileName, const std::string& cacheFileName, TextureImage& image, MipFilter filter = MipFilter::Box);
+
+    // Handles paletted, 16-bit, BGR/ARGB ordered and padded-pitch surfaces
+    bool ConvertSurface(SDL_Surface* surface, TextureLevel& level);
+
+    // Replaces every level after levels[0]
+    void BuildMipChain(TextureImage& image, MipFilter filter);
+
+    bool SaveCache(const std::string& cacheFileName, const TextureCacheKey& key, const TextureImage& image);
+
+    // Fails when the cache is missing, corrupted or was written for a different key
+    bool LoadCache(const std::string& cacheFileName, const TextureCacheKey& key, TextureImage& image);
+
+    // Size and modification time of fileName, false if it cannot be read
+    static bool GetCacheKey(const std::string& fileName, MipFilter filter, TextureCacheKey& key);
+
+    // SIMD is enabled by default when the build targets SSE2 or better
+    void SetSimdEnabled(bool enabled);
+
+    bool IsSimdEnabled() const;
+
+    const std::string& GetError() const;
+
+    // Prints conversion and mip generation throughput of the scalar and SIMD paths
+    static void RunBenchmark();
+
+private:
+
+    void ForEachRow(int rows, const std::function<void(int, int)>& fn);
+
+    void DecodeLinear(const TextureLevel& level, std::vector<float>& linear);
+
+    void EncodeLevel(const std::vector<float>& linear, TextureLevel& level);
+
+    void DownsampleBox(const std::vector<float>& src, int srcW, int srcH, std::vector<float>& dst, int dstW, int dstH);
+
+    void DownsampleKaiser(const std::vector<float>& src, int srcW, int srcH, std::vector<float>& dst, int dstW, int dstH);
+
+private:
+
+    JobSystem* m_jobs;
+
+    bool m_simd;
+
+    std::vector<float> m_scratch;
+
+    std::string m_error;
+};
+#endif
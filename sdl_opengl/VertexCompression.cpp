@@ -0,0 +1,488 @@
+#include "VertexCompression.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    float SignNotZero(float v)
+    {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Projects the unit normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over
+    // the upper one, so two components are enough. Zero normals map to the origin.
+    glm::vec2 OctahedralEncode(const glm::vec3& n)
+    {
+        float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (!(sum > 0.0f))
+            return glm::vec2(0.0f);
+        glm::vec2 p(n.x / sum, n.y / sum);
+        if (n.z < 0.0f)
+            return glm::vec2((1.0f - std::abs(p.y)) * SignNotZero(p.x), (1.0f - std::abs(p.x)) * SignNotZero(p.y));
+        return p;
+    }
+
+    glm::vec3 OctahedralDecode(const glm::vec2& p)
+    {
+        glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+        if (n.z < 0.0f)
+        {
+            n.x = (1.0f - std::abs(p.y)) * SignNotZero(p.x);
+            n.y = (1.0f - std::abs(p.x)) * SignNotZero(p.y);
+        }
+        float length = glm::length(n);
+        return length > 0.0f ? n / length : n;
+    }
+
+    void Store(unsigned char* dst, const void* src, size_t size)
+    {
+        std::memcpy(dst, src, size);
+    }
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    // Round half away from zero like glm::round (std::round). x - trunc(x) is exact in float, so the
+    // tie test has no rounding error of its own. Inputs must fit in an int32.
+    __m128i RoundHalfAway(__m128 x)
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128i truncated = _mm_cvttps_epi32(x);
+        __m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(truncated));
+        // Comparison masks are -1 per lane, so subtracting them adds one
+        __m128i up = _mm_castps_si128(_mm_cmpge_ps(fraction, half));
+        __m128i down = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_sub_ps(_mm_setzero_ps(), half)));
+        return _mm_add_epi32(_mm_sub_epi32(truncated, up), down);
+    }
+
+    // 0..65535 per lane to uint16, SSE2 only has a signed saturating pack
+    __m128i PackUnsigned16(__m128i a, __m128i b)
+    {
+        const __m128i bias = _mm_set1_epi32(32768);
+        const __m128i flip = _mm_set1_epi16(short(0x8000));
+        return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias)), flip);
+    }
+
+    __m128 SignNotZero(__m128 v)
+    {
+        __m128 positive = _mm_cmpge_ps(v, _mm_setzero_ps());
+        return _mm_or_ps(_mm_and_ps(positive, _mm_set1_ps(1.0f)), _mm_andnot_ps(positive, _mm_set1_ps(-1.0f)));
+    }
+
+    __m128 Abs(__m128 v)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+    }
+#endif
+}
+
+VertexFormat VertexFormat::Uncompressed()
+{
+    VertexFormat format;
+    format.position = PositionFormat::Float32;
+    format.normal = NormalFormat::Float32;
+    format.uv = UVFormat::Float32;
+    format.color = ColorFormat::None;
+    return format;
+}
+
+GLsizei VertexFormat::GetStride() const
+{
+    return GetColorOffset() + (color == ColorFormat::None ? 0 : color == ColorFormat::Float32 ? 16 : 4);
+}
+
+GLsizei VertexFormat::GetNormalOffset() const
+{
+    // Quantized positions are padded to 8 bytes to keep every attribute 4 byte aligned
+    return position == PositionFormat::Float32 ? 12 : 8;
+}
+
+GLsizei VertexFormat::GetUVOffset() const
+{
+    return GetNormalOffset() + (normal == NormalFormat::Float32 ? 12 : 4);
+}
+
+GLsizei VertexFormat::GetColorOffset() const
+{
+    return GetUVOffset() + (uv == UVFormat::Float32 ? 8 : 4);
+}
+
+std::string VertexFormat::GetDescription() const
+{
+    static const char* colorNames[] = { "", ", color float32x4", ", color rgba8", ", color rgb10a2", ", color rg11b10f" };
+    std::ostringstream text;
+    text << "position " << (position == PositionFormat::Float32 ? "float32x3" : "unorm16x3")
+        << ", normal " << (normal == NormalFormat::Float32 ? "float32x3" : "octahedral snorm16x2")
+        << ", uv " << (uv == UVFormat::Float32 ? "float32x2" : "half16x2")
+        << colorNames[int(color)];
+    return text.str();
+}
+
+glm::mat4 CompressedVertices::GetPositionTransform() const
+{
+    return glm::scale(glm::translate(glm::mat4(), positionOffset), positionScale);
+}
+
+VertexCompressor::VertexCompressor(JobSystem* jobs):
+    m_jobs{jobs}, m_simd{GLM_ARCH & GLM_ARCH_SSE2_BIT ? true : false}, m_encodeMilliseconds{0.0}
+{
+
+}
+
+void VertexCompressor::Encode(const Mesh& mesh, const std::vector<glm::vec4>& colors, const VertexFormat& format, CompressedVertices& out)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    out.format = format;
+    out.vertexCount = mesh.vertices.size();
+    out.data.resize(out.vertexCount * format.GetStride());
+    out.positionOffset = glm::vec3(0.0f);
+    out.positionScale = glm::vec3(1.0f);
+    if (format.position == PositionFormat::Unorm16 && !mesh.vertices.empty())
+    {
+        // Positions outside stale bounds are clamped, not wrapped
+        out.positionOffset = mesh.bounds.min;
+        out.positionScale = mesh.bounds.max - mesh.bounds.min;
+        for (int axis = 0; axis < 3; ++axis)
+            if (!(out.positionScale[axis] > 0.0f))
+                out.positionScale[axis] = 1.0f;
+    }
+
+    const size_t CHUNK = 4096;
+    auto encode = [&](size_t begin, size_t end) { EncodeRange(mesh, colors, out, begin, end); };
+    if (m_jobs)
+        m_jobs->ParallelFor(out.vertexCount, CHUNK, encode);
+    else
+        encode(0, out.vertexCount);
+
+    m_encodeMilliseconds = MillisecondsSince(start);
+}
+
+void VertexCompressor::EncodeRange(const Mesh& mesh, const std::vector<glm::vec4>& colors, CompressedVertices& out, size_t begin, size_t end) const
+{
+    const VertexFormat& format = out.format;
+    const size_t stride = format.GetStride();
+    const size_t normalOffset = format.GetNormalOffset();
+    const size_t uvOffset = format.GetUVOffset();
+    const size_t colorOffset = format.GetColorOffset();
+    const glm::vec3 offset = out.positionOffset;
+    const glm::vec3 inverseScale = 1.0f / out.positionScale;
+    const Vertex* vertices = mesh.vertices.data();
+    unsigned char* base = out.data.data();
+
+    size_t i = begin;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    if (m_simd && format.position == PositionFormat::Unorm16 && format.normal == NormalFormat::Octahedral16)
+    {
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f);
+        const __m128 offset4 = _mm_setr_ps(offset.x, offset.y, offset.z, 0.0f);
+        const __m128 inverseScale4 = _mm_setr_ps(inverseScale.x, inverseScale.y, inverseScale.z, 0.0f);
+        const __m128 unorm16 = _mm_set1_ps(65535.0f), snorm16 = _mm_set1_ps(32767.0f);
+        for (; i + 4 <= end; i += 4)
+        {
+            const Vertex* v = vertices + i;
+            unsigned char* dst = base + i * stride;
+
+            // Positions: one vertex per register, the w lane becomes the zero padding
+            for (int k = 0; k < 4; k += 2)
+            {
+                __m128 p0 = _mm_setr_ps(v[k].position.x, v[k].position.y, v[k].position.z, 0.0f);
+                __m128 p1 = _mm_setr_ps(v[k + 1].position.x, v[k + 1].position.y, v[k + 1].position.z, 0.0f);
+                p0 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p0, offset4), inverseScale4), zero), one), unorm16);
+                p1 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p1, offset4), inverseScale4), zero), one), unorm16);
+                __m128i packed = PackUnsigned16(RoundHalfAway(p0), RoundHalfAway(p1));
+                _mm_storel_epi64((__m128i*)(dst + k * stride), packed);
+                _mm_storel_epi64((__m128i*)(dst + (k + 1) * stride), _mm_srli_si128(packed, 8));
+            }
+
+            // Normals: four vertices at once, one component per register
+            __m128 nx = _mm_setr_ps(v[0].normal.x, v[1].normal.x, v[2].normal.x, v[3].normal.x);
+            __m128 ny = _mm_setr_ps(v[0].normal.y, v[1].normal.y, v[2].normal.y, v[3].normal.y);
+            __m128 nz = _mm_setr_ps(v[0].normal.z, v[1].normal.z, v[2].normal.z, v[3].normal.z);
+            __m128 sum = _mm_add_ps(_mm_add_ps(Abs(nx), Abs(ny)), Abs(nz));
+            __m128 valid = _mm_cmpgt_ps(sum, zero);
+            __m128 px = _mm_and_ps(valid, _mm_div_ps(nx, sum));
+            __m128 py = _mm_and_ps(valid, _mm_div_ps(ny, sum));
+            __m128 fold = _mm_cmplt_ps(nz, zero);
+            __m128 fx = _mm_mul_ps(_mm_sub_ps(one, Abs(py)), SignNotZero(px));
+            __m128 fy = _mm_mul_ps(_mm_sub_ps(one, Abs(px)), SignNotZero(py));
+            px = _mm_or_ps(_mm_and_ps(fold, fx), _mm_andnot_ps(fold, px));
+            py = _mm_or_ps(_mm_and_ps(fold, fy), _mm_andnot_ps(fold, py));
+            px = _mm_mul_ps(_mm_min_ps(_mm_max_ps(px, minusOne), one), snorm16);
+            py = _mm_mul_ps(_mm_min_ps(_mm_max_ps(py, minusOne), one), snorm16);
+            // x0 x1 x2 x3 y0 y1 y2 y3 -> x0 y0 x1 y1 ..., one 32-bit normal per lane
+            __m128i packed = _mm_packs_epi32(RoundHalfAway(px), RoundHalfAway(py));
+            packed = _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8));
+            for (int k = 0; k < 4; ++k)
+            {
+                int normal = _mm_cvtsi128_si32(packed);
+                Store(dst + k * stride + normalOffset, &normal, 4);
+                packed = _mm_srli_si128(packed, 4);
+            }
+
+            for (int k = 0; k < 4; ++k)
+            {
+                glm::uint uv = glm::packHalf2x16(v[k].uv);
+                Store(dst + k * stride + uvOffset, &uv, 4);
+            }
+        }
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        const Vertex& v = vertices[i];
+        unsigned char* dst = base + i * stride;
+
+        if (format.position == PositionFormat::Float32)
+            Store(dst, &v.position, 12);
+        else
+        {
+            glm::vec3 t = (v.position - offset) * inverseScale;
+            glm::uint16 q[4] = { glm::packUnorm1x16(t.x), glm::packUnorm1x16(t.y), glm::packUnorm1x16(t.z), 0 };
+            Store(dst, q, 8);
+        }
+
+        if (format.normal == NormalFormat::Float32)
+            Store(dst + normalOffset, &v.normal, 12);
+        else
+        {
+            glm::uint normal = glm::packSnorm2x16(OctahedralEncode(v.normal));
+            Store(dst + normalOffset, &normal, 4);
+        }
+
+        if (format.uv == UVFormat::Float32)
+            Store(dst + uvOffset, &v.uv, 8);
+        else
+        {
+            glm::uint uv = glm::packHalf2x16(v.uv);
+            Store(dst + uvOffset, &uv, 4);
+        }
+    }
+
+    if (format.color == ColorFormat::None)
+        return;
+    for (i = begin; i < end; ++i)
+    {
+        glm::vec4 color = i < colors.size() ? colors[i] : glm::vec4(1.0f);
+        unsigned char* dst = base + i * stride + colorOffset;
+        glm::uint packed = 0;
+        switch (format.color)
+        {
+        case ColorFormat::Float32:
+            Store(dst, &color, 16);
+            continue;
+        case ColorFormat::RGBA8:
+            packed = glm::packUnorm4x8(color);
+            break;
+        case ColorFormat::RGB10A2:
+            packed = glm::packUnorm3x10_1x2(color);
+            break;
+        case ColorFormat::RG11B10F:
+            packed = glm::packF2x11_1x10(glm::vec3(color));
+            break;
+        default:
+            break;
+        }
+        Store(dst, &packed, 4);
+    }
+}
+
+Vertex VertexCompressor::Decode(const CompressedVertices& vertices, size_t index, glm::vec4* color)
+{
+    const VertexFormat& format = vertices.format;
+    const unsigned char* src = vertices.data.data() + index * format.GetStride();
+    Vertex v;
+
+    if (format.position == PositionFormat::Float32)
+        std::memcpy(&v.position, src, 12);
+    else
+    {
+        glm::uint16 q[4];
+        std::memcpy(q, src, 8);
+        glm::vec3 t(glm::unpackUnorm1x16(q[0]), glm::unpackUnorm1x16(q[1]), glm::unpackUnorm1x16(q[2]));
+        v.position = vertices.positionOffset + t * vertices.positionScale;
+    }
+
+    glm::uint packed;
+    if (format.normal == NormalFormat::Float32)
+        std::memcpy(&v.normal, src + format.GetNormalOffset(), 12);
+    else
+    {
+        std::memcpy(&packed, src + format.GetNormalOffset(), 4);
+        v.normal = OctahedralDecode(glm::unpackSnorm2x16(packed));
+    }
+
+    if (format.uv == UVFormat::Float32)
+        std::memcpy(&v.uv, src + format.GetUVOffset(), 8);
+    else
+    {
+        std::memcpy(&packed, src + format.GetUVOffset(), 4);
+        v.uv = glm::unpackHalf2x16(packed);
+    }
+
+    if (color && format.color != ColorFormat::None)
+    {
+        std::memcpy(&packed, src + format.GetColorOffset(), 4);
+        switch (format.color)
+        {
+        case ColorFormat::Float32:
+            std::memcpy(color, src + format.GetColorOffset(), 16);
+            break;
+        case ColorFormat::RGBA8:
+            *color = glm::unpackUnorm4x8(packed);
+            break;
+        case ColorFormat::RGB10A2:
+            *color = glm::unpackUnorm3x10_1x2(packed);
+            break;
+        case ColorFormat::RG11B10F:
+            *color = glm::vec4(glm::unpackF2x11_1x10(packed), 1.0f);
+            break;
+        default:
+            break;
+        }
+    }
+    return v;
+}
+
+void VertexCompressor::SetupAttributes(const VertexFormat& format)
+{
+    const GLsizei stride = format.GetStride();
+    if (format.position == PositionFormat::Float32)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+    else
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (GLvoid*)0);
+
+    // The octahedral normal needs decoding in the vertex shader (see OctahedralDecode)
+    if (format.normal == NormalFormat::Float32)
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)GLintptr(format.GetNormalOffset()));
+    else
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (GLvoid*)GLintptr(format.GetNormalOffset()));
+
+    glVertexAttribPointer(2, 2, format.uv == UVFormat::Float32 ? GL_FLOAT : GL_HALF_FLOAT, GL_FALSE, stride, (GLvoid*)GLintptr(format.GetUVOffset()));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    const GLvoid* colorOffset = (GLvoid*)GLintptr(format.GetColorOffset());
+    switch (format.color)
+    {
+    case ColorFormat::None:
+        glDisableVertexAttribArray(3);
+        return;
+    case ColorFormat::Float32:
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, colorOffset);
+        break;
+    case ColorFormat::RGBA8:
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, colorOffset);
+        break;
+    case ColorFormat::RGB10A2:
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE, stride, colorOffset);
+        break;
+    case ColorFormat::RG11B10F:
+        glVertexAttribPointer(3, 3, GL_UNSIGNED_INT_10F_11F_11F_REV, GL_FALSE, stride, colorOffset);
+        break;
+    }
+    glEnableVertexAttribArray(3);
+}
+
+void VertexCompressor::PrintReport(std::ostream& out, const std::string& name, const Mesh& mesh, const CompressedVertices& vertices)
+{
+    const VertexFormat uncompressed = VertexFormat::Uncompressed();
+    const size_t colorBytes = vertices.format.color == ColorFormat::None ? 0 : 16;
+    const size_t before = mesh.vertices.size() * (uncompressed.GetStride() + colorBytes);
+    const size_t after = vertices.data.size();
+
+    float positionError = 0.0f, normalError = 0.0f;
+    for (size_t i = 0; i < vertices.vertexCount; ++i)
+    {
+        Vertex v = Decode(vertices, i);
+        positionError = std::max(positionError, glm::length(v.position - mesh.vertices[i].position));
+        float length = glm::length(mesh.vertices[i].normal);
+        if (length > 0.0f)
+        {
+            float cosine = glm::clamp(glm::dot(v.normal, mesh.vertices[i].normal / length), -1.0f, 1.0f);
+            normalError = std::max(normalError, glm::degrees(std::acos(cosine)));
+        }
+    }
+
+    // Every triangle corner fetches a vertex, the post-transform cache aside
+    const double fetchBefore = double(mesh.indices.size()) * (uncompressed.GetStride() + colorBytes);
+    const double fetchAfter = double(mesh.indices.size()) * vertices.format.GetStride();
+    glm::vec3 size = vertices.format.position == PositionFormat::Float32 ? glm::vec3(0.0f) : vertices.positionScale;
+
+    out << name << " vertices: " << vertices.vertexCount << " in " << vertices.format.GetDescription() << std::endl
+        << "  " << (uncompressed.GetStride() + colorBytes) << " -> " << vertices.format.GetStride() << " bytes per vertex, "
+        << before / 1024 << " KB -> " << after / 1024 << " KB (" << (before ? 100.0 * (before - after) / before : 0.0) << "% saved)" << std::endl
+        << "  vertex fetch per draw " << fetchBefore / (1024.0 * 1024.0) << " MB -> " << fetchAfter / (1024.0 * 1024.0) << " MB" << std::endl
+        << "  max position error " << positionError << " (step " << glm::max(glm::max(size.x, size.y), size.z) / 65535.0f
+        << "), max normal error " << normalError << " degrees" << std::endl;
+}
+
+void VertexCompressor::SetSimdEnabled(bool enabled)
+{
+    m_simd = enabled && (GLM_ARCH & GLM_ARCH_SSE2_BIT);
+}
+
+bool VertexCompressor::IsSimdEnabled() const
+{
+    return m_simd;
+}
+
+double VertexCompressor::GetEncodeMilliseconds() const
+{
+    return m_encodeMilliseconds;
+}
+
+void VertexCompressor::RunBenchmark()
+{
+    const int RUNS = 10;
+
+    Mesh mesh = Mesh::CreateSphere(1.0f, 512, 1024);
+    std::vector<glm::vec4> colors;
+    VertexFormat format;
+
+    JobSystem jobs;
+    CompressedVertices reference, vertices;
+
+    std::cout << "VertexCompressor benchmark, " << mesh.vertices.size() << " vertices, average of " << RUNS << " runs" << std::endl;
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            VertexCompressor compressor(threaded ? &jobs : nullptr);
+            compressor.SetSimdEnabled(simd != 0);
+            if (simd && !compressor.IsSimdEnabled())
+                continue;
+
+            double total = 0.0;
+            for (int run = 0; run < RUNS; ++run)
+            {
+                compressor.Encode(mesh, colors, format, threaded || simd ? vertices : reference);
+                total += compressor.GetEncodeMilliseconds();
+            }
+
+            // The scalar single threaded output is the reference, every other path must match it byte for byte
+            size_t mismatches = 0;
+            if (threaded || simd)
+            {
+                for (size_t i = 0; i < vertices.data.size(); ++i)
+                    mismatches += vertices.data[i] != reference.data[i] ? 1 : 0;
+            }
+            std::cout << "  " << (simd ? "simd  " : "scalar") << " x" << (threaded ? jobs.GetThreadCount() : 1)
+                << "  " << total / RUNS << " ms, " << mismatches << " bytes differ from scalar" << std::endl;
+        }
+    }
+    PrintReport(std::cout, "  sphere", mesh, reference);
+}
@@ -0,0 +1,124 @@
+#ifndef VERTEX_COMPRESSION_HPP
+#define VERTEX_COMPRESSION_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+
+class JobSystem;
+
+enum class PositionFormat
+{
+    Float32,
+    // Quantized to 16 bits per axis inside the mesh AABB, the dequantization is folded into the model matrix
+    Unorm16
+};
+
+enum class NormalFormat
+{
+    Float32,
+    // Octahedral mapping stored as 2x16-bit SNORM
+    Octahedral16
+};
+
+enum class UVFormat
+{
+    Float32,
+    Half16
+};
+
+enum class ColorFormat
+{
+    None,
+    Float32,
+    RGBA8,
+    RGB10A2,
+    // HDR colors without alpha, needs GL 4.4 or ARB_vertex_type_10f_11f_11f_rev as a vertex attribute
+    RG11B10F
+};
+
+// Attribute encodings of a compressed vertex. Attribute locations: 0 position, 1 normal, 2 uv, 3 color.
+struct VertexFormat
+{
+    PositionFormat position = PositionFormat::Unorm16;
+    NormalFormat normal = NormalFormat::Octahedral16;
+    UVFormat uv = UVFormat::Half16;
+    ColorFormat color = ColorFormat::None;
+
+    // Every attribute as 32-bit floats
+    static VertexFormat Uncompressed();
+
+    GLsizei GetStride() const;
+
+    GLsizei GetNormalOffset() const;
+
+    GLsizei GetUVOffset() const;
+
+    GLsizei GetColorOffset() const;
+
+    std::string GetDescription() const;
+};
+
+// Interleaved vertex data in a VertexFormat, ready for glBufferData
+struct CompressedVertices
+{
+    VertexFormat format;
+    size_t vertexCount = 0;
+    std::vector<unsigned char> data;
+    // Quantized positions decode as positionOffset + p * positionScale
+    glm::vec3 positionOffset{ 0.0f };
+    glm::vec3 positionScale{ 1.0f };
+
+    // Multiply the model matrix by this to draw quantized positions
+    glm::mat4 GetPositionTransform() const;
+};
+
+// Encodes meshes into compressed vertex formats with glm's gtc/packing functions. Positions and
+// normals, the bulk of the work, also have an SSE2 path that rounds exactly like glm::round (half
+// away from zero), so both paths produce identical bytes.
+class VertexCompressor
+{
+public:
+
+    // jobs may be nullptr, then encoding runs on the calling thread
+    explicit VertexCompressor(JobSystem* jobs = nullptr);
+
+    // colors may be empty, then the color attribute is white
+    void Encode(const Mesh& mesh, const std::vector<glm::vec4>& colors, const VertexFormat& format, CompressedVertices& out);
+
+    // Reverses the encoding of one vertex, used to measure the error
+    static Vertex Decode(const CompressedVertices& vertices, size_t index, glm::vec4* color = nullptr);
+
+    // glVertexAttribPointer for every attribute of the format, for the bound GL_ARRAY_BUFFER
+    static void SetupAttributes(const VertexFormat& format);
+
+    // Memory per vertex, buffer sizes, vertex fetch bandwidth per draw and the largest errors
+    static void PrintReport(std::ostream& out, const std::string& name, const Mesh& mesh, const CompressedVertices& vertices);
+
+    void SetSimdEnabled(bool enabled);
+
+    bool IsSimdEnabled() const;
+
+    double GetEncodeMilliseconds() const;
+
+    // Scalar vs SIMD encoding speed and output comparison on a dense sphere
+    static void RunBenchmark();
+
+private:
+
+    void EncodeRange(const Mesh& mesh, const std::vector<glm::vec4>& colors, CompressedVertices& out, size_t begin, size_t end) const;
+
+private:
+
+    JobSystem* m_jobs;
+
+    bool m_simd;
+
+    double m_encodeMilliseconds;
+};
+#endif
@@ -14,6 +14,25 @@
 
 #include "GLProgram.hpp"
 #include "Camera.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+#include "Input.hpp"
+#include "TexturePrep.hpp"
+#include "TextureManager.hpp"
+#include "LightClusters.hpp"
+#include "DeferredRenderer.hpp"
+#include "ShadowMaps.hpp"
+#include "PostEffects.hpp"
+#include "GPUTimer.hpp"
+#include "RenderQueue.hpp"
+#include "OcclusionCuller.hpp"
+#include "SoftwareOcclusion.hpp"
+#include "MeshLOD.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshImporter.hpp"
+#include "VertexCompression.hpp"
+#include "ParticleSystem.hpp"
+#include "Scene.hpp"
 
 using namespace std;
 
@@ -24,16 +43,78 @@ using namespace std;
 const int WINDOW_W = 800;
 const int WINDOW_H = 600;
 const int FPS = 50;
+const float Z_NEAR = 0.1f;
+const float Z_FAR = 100.0f;
+// Fixed time step of the camera, in seconds
+const float CAMERA_STEP = 1.0f / 120.0f;
 
-bool KEY_PRESSED_STATUS[1024];
+// Input actions, bound to keys in SetupInput()
+enum Action
+{
+    ACTION_QUIT,
+    ACTION_MOVE_FORWARD,
+    ACTION_MOVE_BACKWARD,
+    ACTION_MOVE_LEFT,
+    ACTION_MOVE_RIGHT,
+    ACTION_TEXTURE_STATS,
+    ACTION_TIMINGS,
+    ACTION_TOGGLE_PREPASS,
+    ACTION_TOGGLE_OCCLUSION,
+    ACTION_TOGGLE_CPU_OCCLUSION
+};
 
 const glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-struct Texture2D
+// Unit cube, 36 vertices. Used for the scene, the occlusion proxies and the CPU occluders.
+const GLfloat CUBE_VERTICES[] = {
+    -0.5f, -0.5f, -0.5f,
+    0.5f, -0.5f, -0.5f,
+    0.5f,  0.5f, -0.5f,
+    0.5f,  0.5f, -0.5f,
+    -0.5f,  0.5f, -0.5f,
+    -0.5f, -0.5f, -0.5f,
+
+    -0.5f, -0.5f,  0.5f,
+    0.5f, -0.5f,  0.5f,
+    0.5f,  0.5f,  0.5f,
+    0.5f,  0.5f,  0.5f,
+    -0.5f,  0.5f,  0.5f,
+    -0.5f, -0.5f,  0.5f,
+
+    -0.5f,  0.5f,  0.5f,
+    -0.5f,  0.5f, -0.5f,
+    -0.5f, -0.5f, -0.5f,
+    -0.5f, -0.5f, -0.5f,
+    -0.5f, -0.5f,  0.5f,
+    -0.5f,  0.5f,  0.5f,
+
+    0.5f,  0.5f,  0.5f,
+    0.5f,  0.5f, -0.5f,
+    0.5f, -0.5f, -0.5f,
+    0.5f, -0.5f, -0.5f,
+    0.5f, -0.5f,  0.5f,
+    0.5f,  0.5f,  0.5f,
+
+    -0.5f, -0.5f, -0.5f,
+    0.5f, -0.5f, -0.5f,
+    0.5f, -0.5f,  0.5f,
+    0.5f, -0.5f,  0.5f,
+    -0.5f, -0.5f,  0.5f,
+    -0.5f, -0.5f, -0.5f,
+
+    -0.5f,  0.5f, -0.5f,
+    0.5f,  0.5f, -0.5f,
+    0.5f,  0.5f,  0.5f,
+    0.5f,  0.5f,  0.5f,
+    -0.5f,  0.5f,  0.5f,
+    -0.5f,  0.5f, -0.5f
+};
+
+// Selected at startup with --renderer forward|deferred
+enum class Renderer
 {
-    int w{ -1 };
-    int h{ -1 };
-    GLuint textureID;
+    Forward,
+    Deferred
 };
 
 struct TutorialData_t
@@ -48,6 +129,70 @@ struct TutorialData_t
 	GLuint VBO;
     
     Camera camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    Input input;
+
+    JobSystem jobSystem;
+    // Per frame data (the render queues), double buffered
+    FrameArena frameArena;
+    TextureManager textureManager{ &jobSystem };
+
+    // The container, the glass pane and the lamp
+    Scene scene{ &jobSystem };
+    Entity container;
+    std::vector<Entity> visibleEntities;
+
+    // lights[0] is the lamp at lightPos, the rest orbit the scene (--lights N)
+    int lightCount = 64;
+    std::vector<PointLight> lights;
+    LightClusters lightClusters{ &jobSystem };
+
+    // Sun with --cascades N shadow cascades (0 turns it off) of --shadow-size N texels. The casters are
+    // the opaque geometry whether or not the camera sees it.
+    int shadowCascades = 4;
+    int shadowResolution = 2048;
+    ShadowMaps shadows;
+    std::vector<DrawItem> shadowCasters;
+
+    // The scene is drawn into a half float target, then bloomed (--bloom-levels N, 0 turns it off) and
+    // tone mapped (--exposure X). --ldr draws straight into the window instead.
+    bool hdr = true;
+    int bloomLevels = 5;
+    float exposure = 1.0f;
+    PostProcessChain postProcess;
+    Bloom bloom;
+    ToneMapper toneMapper;
+
+    Renderer renderer = Renderer::Forward;
+    DeferredRenderer deferredRenderer;
+    GPUTimer forwardTimer;
+
+    // Opaque front to back, transparent back to front (--prepass enables the depth pre-pass, F3 toggles it)
+    RenderQueue renderQueue;
+    // Enabled with --occlusion, F4 toggles
+    bool occlusionCulling = false;
+    OcclusionCuller occlusionCuller;
+    // CPU occlusion before submission, enabled with --cpu-occlusion, F5 toggles
+    bool softwareOcclusion = false;
+    SoftwareOcclusion softwareOcclusionCuller{ &jobSystem };
+    size_t softwareCulled = 0;
+
+    // --lod N adds an N x N field of spheres drawn with levels of detail
+    int lodFieldSize = 0;
+    MeshLOD sphereLOD;
+    std::vector<int> sphereLevels;
+    size_t lodTriangles = 0;
+
+    // --model file.obj|file.glb, drawn behind the container
+    std::string modelFile;
+    MeshLOD model;
+    glm::mat4 modelTransform;
+
+    // --compress uploads the meshes with quantized positions, octahedral normals and half float uvs
+    bool compressVertices = false;
+
+    // --particles N runs a fountain of N particles on top of the container
+    size_t particleCount = 0;
+    ParticleSystem particles{ &jobSystem };
 };
 
 void SDLDie(const std::string& msg)
@@ -58,6 +203,21 @@ void SDLDie(const std::string& msg)
     exit(1);
 }
 
+void UploadMesh(TutorialData_t* data, MeshLOD& mesh, const std::string& name)
+{
+    if (!data->compressVertices)
+    {
+        mesh.Upload();
+        return;
+    }
+    VertexCompressor compressor(&data->jobSystem);
+    CompressedVertices vertices;
+    compressor.Encode(mesh.GetMesh(), std::vector<glm::vec4>(), VertexFormat(), vertices);
+    mesh.Upload(vertices);
+    VertexCompressor::PrintReport(cout, name, mesh.GetMesh(), vertices);
+    cout << "  encoded in " << compressor.GetEncodeMilliseconds() << " ms" << endl;
+}
+
 void CheckSDLError(int line = -1)
 {
 #ifndef NDEBUG
@@ -88,36 +248,6 @@ void CheckGLError(int line = -1)
 #endif
 }
 
-Texture2D LoadTexture(const std::string& filename)
-{
-    auto img_data = IMG_Load(filename.c_str());
-
-    GLuint id;
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-
-    if (img_data->format->BytesPerPixel == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img_data->w, img_data->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, img_data->pixels);
-    else if (img_data->format->BytesPerPixel == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, img_data->w, img_data->h, 0, GL_RGB, GL_UNSIGNED_BYTE, img_data->pixels);
-    else
-        SDLDie("Not supported image pixel format");
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    SDL_FreeSurface(img_data);
-
-    Texture2D txt2d;
-    txt2d.w = img_data->w;
-    txt2d.h = img_data->h;
-    txt2d.textureID = id;
-    return txt2d;
-}
-
 void SetupWindow(TutorialData_t* data )
 {
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -155,17 +285,89 @@ void SetupWindow(TutorialData_t* data )
     {
         SDLDie((char*)glewGetErrorString(err));
     }
-    //SDL_CaptureMouse(SDL_TRUE);
-    //SDL_SetRelativeMouseMode(SDL_TRUE);
+    SDL_GL_SetSwapInterval(1);
+}
+
+void SetupInput(TutorialData_t* data)
+{
+    Input& input = data->input;
+    input.BindAction(ACTION_QUIT, SDL_SCANCODE_ESCAPE);
+    input.BindAction(ACTION_MOVE_FORWARD, SDL_SCANCODE_W);
+    input.BindAction(ACTION_MOVE_FORWARD, SDL_SCANCODE_UP);
+    input.BindAction(ACTION_MOVE_BACKWARD, SDL_SCANCODE_S);
+    input.BindAction(ACTION_MOVE_BACKWARD, SDL_SCANCODE_DOWN);
+    input.BindAction(ACTION_MOVE_LEFT, SDL_SCANCODE_A);
+    input.BindAction(ACTION_MOVE_LEFT, SDL_SCANCODE_LEFT);
+    input.BindAction(ACTION_MOVE_RIGHT, SDL_SCANCODE_D);
+    input.BindAction(ACTION_MOVE_RIGHT, SDL_SCANCODE_RIGHT);
+    input.BindAction(ACTION_TEXTURE_STATS, SDL_SCANCODE_F1);
+    input.BindAction(ACTION_TIMINGS, SDL_SCANCODE_F2);
+    input.BindAction(ACTION_TOGGLE_PREPASS, SDL_SCANCODE_F3);
+    input.BindAction(ACTION_TOGGLE_OCCLUSION, SDL_SCANCODE_F4);
+    input.BindAction(ACTION_TOGGLE_CPU_OCCLUSION, SDL_SCANCODE_F5);
+
+    // Without relative mode the motion comes from the cursor, kept hidden in the middle of the window
+    if (!input.SetRelativeMouseMode(true))
+        cout << "Relative mouse mode unavailable: " << input.GetError() << endl;
     SDL_ShowCursor(0);
     SDL_WarpMouseInWindow(data->mainwindow[0], WINDOW_W / 2, WINDOW_H / 2);
-    SDL_GL_SetSwapInterval(1);    
-    
+}
+
+void CreateScene(TutorialData_t* data)
+{
+    // Every object is a unit cube
+    const AABB unitBox(glm::vec3(-0.5f), glm::vec3(0.5f));
+    Scene& scene = data->scene;
+    MeshRef cube;
+    cube.vao = data->VAO;
+    cube.vertexCount = 36;
+
+    Material material;
+    material.program = &data->shaderProgram;
+    material.color = glm::vec3(1.0f, 0.5f, 0.31f);
+    data->container = scene.Create();
+    scene.Add(data->container, Transform());
+    scene.Add(data->container, cube);
+    scene.Add(data->container, material);
+    scene.Add(data->container, Bounds{ unitBox, unitBox, 0 });
+
+    // A glass pane in front of the container goes to the transparent queue, it moves with the container
+    Entity glass = scene.Create();
+    Transform transform;
+    transform.position = glm::vec3(-0.8f, 0.0f, 1.2f);
+    transform.scale = glm::vec3(1.0f, 1.0f, 0.05f);
+    material.color = glm::vec3(0.4f, 0.7f, 1.0f);
+    material.opacity = 0.35f;
+    scene.Add(glass, transform);
+    scene.Add(glass, cube);
+    scene.Add(glass, material);
+    scene.Add(glass, Bounds{ unitBox, unitBox, -1 });
+    scene.Add(glass, Parent{ data->container });
+
+    // The lamp, unlit. It is written as emissive so the deferred lighting passes keep it white.
+    Entity lamp = scene.Create();
+    transform.position = lightPos;
+    transform.scale = glm::vec3(0.2f);
+    cube.vao = data->lightVAO;
+    material.program = &data->lightShaderProgram;
+    material.color = glm::vec3(1.0f);
+    material.opacity = 1.0f;
+    material.emissive = true;
+    Light light;
+    light.color = glm::vec3(1.0f, 0.5f, 1.0f);
+    light.radius = 6.0f;
+    scene.Add(lamp, transform);
+    scene.Add(lamp, cube);
+    scene.Add(lamp, material);
+    scene.Add(lamp, Bounds{ unitBox, unitBox, 1 });
+    scene.Add(lamp, light);
 }
 
 void SetupGL(TutorialData_t* data)
 {
-    data->shaderProgram.InitWithFiles("vertex_shade_lighting.vs", "fragment_shader_lighting.frag");
+    data->camera.SetPerspective((GLfloat)WINDOW_W / (GLfloat)WINDOW_H, Z_NEAR, Z_FAR);
+
+    data->shaderProgram.InitWithFiles("vertex_shader_clustered.vs", "fragment_shader_clustered.frag");
     if (!data->shaderProgram.IsInitialized())
         return SDLDie(data->shaderProgram.GetError());
 
@@ -173,62 +375,18 @@ void SetupGL(TutorialData_t* data)
     if (!data->shaderProgram.IsInitialized())
         return SDLDie(data->shaderProgram.GetError());
     
-    GLfloat vertices[] = {
-        -0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        -0.5f,  0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-
-        -0.5f, -0.5f,  0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        -0.5f, -0.5f,  0.5f,
-
-        -0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-
-        -0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f, -0.5f,  0.5f,
-        -0.5f, -0.5f,  0.5f,
-        -0.5f, -0.5f, -0.5f,
-
-        -0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f, -0.5f
-    };
-
-	glGenVertexArrays(1, &data->VAO);
-	glBindVertexArray(data->VAO);
-	{        
-		glGenBuffers(1, &data->VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-		
+    glGenVertexArrays(1, &data->VAO);
+    glBindVertexArray(data->VAO);
+    {
+        glGenBuffers(1, &data->VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+        
         const GLint vertexPosition = 0;
-		glVertexAttribPointer(vertexPosition, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-		glEnableVertexAttribArray(vertexPosition);      
-	}
-	glBindVertexArray(0);
+        glVertexAttribPointer(vertexPosition, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(vertexPosition);
+    }
+    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glGenVertexArrays(1, &data->lightVAO);
@@ -243,16 +401,292 @@ void SetupGL(TutorialData_t* data)
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    // Blending is enabled by the render queue for the transparent pass only
     glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (!data->renderQueue.Init())
+        return SDLDie(data->renderQueue.GetError());
+    data->renderQueue.SetFrameArena(&data->frameArena);
+    // The scene cube doubles as the occlusion proxy
+    if (!data->occlusionCuller.Init(data->VAO, 36))
+        return SDLDie(data->occlusionCuller.GetError());
+    data->renderQueue.SetOcclusionCuller(data->occlusionCulling ? &data->occlusionCuller : nullptr);
+
+    if (data->lodFieldSize > 0)
+    {
+        data->sphereLOD.Build(Mesh::CreateSphere(0.5f, 48, 96), 6);
+        UploadMesh(data, data->sphereLOD, "Sphere LOD");
+        data->sphereLevels.assign(size_t(data->lodFieldSize) * data->lodFieldSize, 0);
+        cout << "Sphere LOD: " << data->sphereLOD.GetLevelCount() << " levels built in " << data->sphereLOD.GetBuildMilliseconds() << " ms" << endl;
+    }
+
+    if (!data->modelFile.empty())
+    {
+        MeshImporter importer(&data->jobSystem);
+        Mesh mesh;
+        if (!importer.Load(data->modelFile, mesh))
+            return SDLDie(importer.GetError());
+        cout << "Imported " << data->modelFile << ": " << mesh.GetTriangleCount() << " triangles in " << importer.GetTotalMilliseconds()
+            << " ms (read " << importer.GetReadMilliseconds() << ", parse " << importer.GetParseMilliseconds() << ", weld "
+            << importer.GetWeldMilliseconds() << ")" << endl;
+
+        // Fitted into a 2 unit box behind the container
+        glm::vec3 size = mesh.bounds.max - mesh.bounds.min;
+        float scale = 2.0f / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+        data->modelTransform = glm::translate(glm::mat4(), glm::vec3(0.0f, 0.0f, -3.0f));
+        data->modelTransform = glm::scale(data->modelTransform, glm::vec3(scale));
+        data->modelTransform = glm::translate(data->modelTransform, -mesh.bounds.GetCenter());
+        data->model.Build(mesh, 1);
+        UploadMesh(data, data->model, data->modelFile);
+    }
+    data->lightClusters.InitGL();
+    if (data->particleCount > 0)
+    {
+        const float LIFETIME = 4.0f;
+        data->particles.Init(data->particleCount);
+        if (!data->particles.InitGL())
+            return SDLDie(data->particles.GetError());
+        ParticleEmitter fountain;
+        fountain.position = glm::vec3(0.0f, 0.6f, 0.0f);
+        fountain.velocity = glm::vec3(0.0f, 1.5f, 0.0f);
+        fountain.lifetime = LIFETIME;
+        fountain.rate = data->particleCount / LIFETIME;
+        data->particles.AddEmitter(fountain);
+    }
+    if (data->renderer == Renderer::Deferred && !data->deferredRenderer.Init(WINDOW_W, WINDOW_H))
+        return SDLDie(data->deferredRenderer.GetError());
+    if (data->shadowCascades > 0 && !data->shadows.Init(data->shadowCascades, data->shadowResolution))
+        return SDLDie(data->shadows.GetError());
+    if (data->hdr)
+    {
+        if (!data->postProcess.Init(WINDOW_W, WINDOW_H))
+            return SDLDie(data->postProcess.GetError());
+        if (data->bloomLevels > 0)
+        {
+            if (!data->bloom.Init(data->bloomLevels))
+                return SDLDie(data->bloom.GetError());
+            data->postProcess.AddPass("bloom", GL_RGBA16F, [data](const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain)
+            {
+                data->bloom.Apply(input, output, chain);
+            });
+        }
+        if (!data->toneMapper.Init())
+            return SDLDie(data->toneMapper.GetError());
+        data->toneMapper.SetExposure(data->exposure);
+        data->postProcess.AddPass("tonemap", GL_RGBA8, [data](const RenderTarget& input, const RenderTarget* output, PostProcessChain& chain)
+        {
+            data->toneMapper.Apply(input, output, chain);
+        });
+    }
+    CreateScene(data);
+    data->scene.UpdateTransforms();
+    data->lights.clear();
+    data->scene.CollectLights(data->lights);
+    data->lights.resize(std::max(1, data->lightCount));
+    for (size_t i = 1; i < data->lights.size(); ++i)
+    {
+        // Hue spread over the light index, positions are set every frame by UpdateLights
+        float t = float(i) / data->lights.size();
+        data->lights[i].radius = 1.5f;
+        data->lights[i].color = 0.5f * glm::abs(glm::vec3(glm::sin(t * 6.28f), glm::sin(t * 6.28f + 2.09f), glm::sin(t * 6.28f + 4.19f)));
+    }
+}
+
+void UpdateLights(TutorialData_t* data)
+{
+    float time = SDL_GetTicks() / 1000.0f;
+    for (size_t i = 1; i < data->lights.size(); ++i)
+    {
+        float t = float(i) / data->lights.size();
+        float angle = t * 6.28f * 7.0f + time * (0.2f + t);
+        float ring = 1.5f + 8.0f * t;
+        data->lights[i].position = glm::vec3(ring * glm::cos(angle), 2.0f * glm::sin(angle * 3.0f + time), ring * glm::sin(angle));
+    }
+}
+
+void UpdateParticles(TutorialData_t* data)
+{
+    static auto last_tick = SDL_GetTicks();
+    auto current_tick = SDL_GetTicks();
+    // Clamped so a stall does not emit a burst of particles
+    GLfloat deltaTime = std::min(GLfloat(current_tick - last_tick) / 1000.0f, 0.1f);
+    last_tick = current_tick;
+
+    data->particles.Update(deltaTime);
+}
+
+void SubmitScene(TutorialData_t* data)
+{
+    Camera& camera = data->camera;
+    const glm::mat4& view = camera.GetViewMatrix();
+    const glm::mat4& projection = camera.GetProjectionMatrix();
+    RenderQueue& queue = data->renderQueue;
+    queue.Clear();
+    std::vector<DrawItem>& casters = data->shadowCasters;
+    casters.clear();
+    auto submitCaster = [&](const DrawItem& item)
+    {
+        if (data->shadowCascades > 0 && !item.emissive && item.opacity >= 1.0f)
+            casters.push_back(item);
+    };
+
+    Scene& scene = data->scene;
+    scene.UpdateTransforms();
+    scene.UpdateBounds();
+
+    // The container is the only CPU occluder, everything else is tested against it before submission
+    SoftwareOcclusion& cpuOcclusion = data->softwareOcclusionCuller;
+    data->softwareCulled = 0;
+    if (data->softwareOcclusion)
+    {
+        cpuOcclusion.BeginFrame(camera.GetViewProjectionMatrix());
+        cpuOcclusion.AddOccluder(CUBE_VERTICES, 36, scene.Get<Transform>(data->container).world);
+        cpuOcclusion.Rasterize();
+    }
+    auto submitOccludee = [&](const DrawItem& item)
+    {
+        if (data->softwareOcclusion && !cpuOcclusion.IsVisible(item.bounds))
+            data->softwareCulled++;
+        else
+            queue.Submit(item);
+    };
+
+    // Scene entities in the view frustum, the container is the occluder and is always submitted
+    scene.Cull(camera.GetFrustum(), data->visibleEntities);
+    for (Entity entity: data->visibleEntities)
+    {
+        if (entity == data->container)
+            queue.Submit(scene.MakeDrawItem(entity));
+        else
+            submitOccludee(scene.MakeDrawItem(entity));
+    }
+    // Casters out of view still shadow what is in view, the cascades cull them on their own
+    if (data->shadowCascades > 0)
+    {
+        for (Entity entity: scene.GetPool<Material>().GetEntities())
+            submitCaster(scene.MakeDrawItem(entity));
+    }
+
+    DrawItem item;
+
+    if (!data->modelFile.empty())
+    {
+        item.vao = data->model.GetVAO();
+        item.vertexCount = 0;
+        item.indexCount = data->model.GetIndexCount(0);
+        item.indexOffset = data->model.GetIndexOffset(0);
+        item.program = &data->shaderProgram;
+        item.model = data->modelTransform * data->model.GetPositionTransform();
+        item.color = glm::vec3(0.8f);
+        item.emissive = false;
+        item.occlusionId = -1;
+        item.bounds = data->model.GetBounds().Transform(data->modelTransform);
+        submitOccludee(item);
+        submitCaster(item);
+    }
+
+    // Sphere field below the scene, each sphere at the coarsest level that stays under a pixel of error
+    const float MAX_PIXEL_ERROR = 1.0f;
+    const float pixelsPerUnit = projection[1][1] * WINDOW_H * 0.5f;
+    const glm::vec3 cameraPosition = camera.GetPosition();
+    MeshLOD& sphere = data->sphereLOD;
+    data->lodTriangles = 0;
+    item.vao = sphere.GetVAO();
+    item.vertexCount = 0;
+    item.program = &data->shaderProgram;
+    item.color = glm::vec3(0.6f);
+    item.emissive = false;
+    for (int z = 0; z < data->lodFieldSize; ++z)
+    {
+        for (int x = 0; x < data->lodFieldSize; ++x)
+        {
+            const int index = z * data->lodFieldSize + x;
+            glm::vec3 center(1.5f * (x - data->lodFieldSize / 2), -2.0f, 1.5f * (z - data->lodFieldSize / 2));
+            glm::mat4 transform = glm::translate(glm::mat4(), center);
+            item.model = transform * sphere.GetPositionTransform();
+            item.bounds = sphere.GetBounds().Transform(transform);
+            item.occlusionId = 2 + index;
+
+            float distance = glm::length(center - cameraPosition) - 0.5f;
+            int& level = data->sphereLevels[index];
+            level = sphere.SelectLevel(distance, pixelsPerUnit, MAX_PIXEL_ERROR, level);
+            item.indexCount = sphere.GetIndexCount(level);
+            item.indexOffset = sphere.GetIndexOffset(level);
+            data->lodTriangles += sphere.GetTriangleCount(level);
+            submitOccludee(item);
+            submitCaster(item);
+        }
+    }
+
+    queue.Sort(view);
+}
+
+RenderQueue::ProgramSetup ForwardSetup(TutorialData_t* data)
+{
+    return [data](GLProgram& program)
+    {
+        if (&program != &data->shaderProgram)
+            return;
+        glUniform3f(glGetUniformLocation(program.GetProgram(), "ambientColor"), 0.1f, 0.1f, 0.1f);
+        data->lightClusters.Bind(program.GetProgram(), 0, WINDOW_W, WINDOW_H);
+        // Also without shadows, the sampler needs a unit of its own
+        data->shadows.Bind(program.GetProgram(), 4);
+    };
+}
+
+void DrawSceneForward(TutorialData_t* data, const glm::mat4& view, const glm::mat4& projection)
+{
+    data->forwardTimer.Begin();
+    data->renderQueue.Execute(view, projection, WINDOW_W * WINDOW_H, ForwardSetup(data));
+    data->forwardTimer.End();
+}
+
+void DrawSceneDeferred(TutorialData_t* data, const glm::mat4& view, const glm::mat4& projection)
+{
+    GLProgram& program = data->deferredRenderer.BeginGeometryPass(view, projection);
+    data->renderQueue.BeginOverdrawQuery();
+    data->renderQueue.DrawOpaque(view, projection, nullptr, &program);
+    data->renderQueue.EndOverdrawQuery(WINDOW_W * WINDOW_H);
+    data->deferredRenderer.EndGeometryPass();
+
+    data->deferredRenderer.LightingPass(data->lights, view, projection, glm::vec3(0.1f), data->shadows);
+
+    // Transparent geometry is forward shaded on top, against the depth restored by the lighting pass
+    data->renderQueue.DrawTransparent(view, projection, ForwardSetup(data));
 }
 
 void DrawScene(TutorialData_t* data)
 {
+    // Camera transformations, only rebuilt when the camera changed
+    const glm::mat4 view = data->camera.GetViewMatrix();
+    const glm::mat4 projection = data->camera.GetProjectionMatrix();
+
+    data->frameArena.BeginFrame();
+
+    // The particles do not depend on the scene, they are simulated while it is submitted and binned
+    JobCounter particlesUpdated;
+    if (data->particleCount > 0)
+        data->jobSystem.Run([data]() { UpdateParticles(data); }, &particlesUpdated);
+
+    UpdateLights(data);
+    SubmitScene(data);
+    data->shadows.Update(data->camera, data->shadowCasters);
+    // The deferred path still needs the clusters to forward shade its transparent queue
+    if (data->renderer == Renderer::Forward || data->renderQueue.GetTransparentCount() > 0)
+    {
+        data->lightClusters.Build(data->lights, view, data->camera.GetZoom(), data->camera.GetAspect(), data->camera.GetNear(), data->camera.GetFar());
+        data->lightClusters.Upload();
+    }
+    data->jobSystem.Wait(particlesUpdated);
+    if (data->particleCount > 0)
+        data->particles.Upload();
+
     for (auto window: data->mainwindow)
     {
         SDL_GL_MakeCurrent(window, data->maincontext);
+        data->shadows.Render(data->shadowCasters);
+        if (data->hdr)
+            data->postProcess.BeginScene();
         //glViewport(0, 0, 1920, 1080);
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -260,60 +694,101 @@ void DrawScene(TutorialData_t* data)
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Use cooresponding shader when setting uniforms/drawing objects
-        data->shaderProgram.Use();
-        GLint objectColorLoc = glGetUniformLocation(data->shaderProgram.GetProgram(), "objectColor");
-        GLint lightColorLoc = glGetUniformLocation(data->shaderProgram.GetProgram(), "lightColor");
-        glUniform3f(objectColorLoc, 1.0f, 0.5f, 0.31f);
-        glUniform3f(lightColorLoc, 1.0f, 0.5f, 1.0f);
-
-        // Create camera transformations
-        glm::mat4 view;
-        view = data->camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(data->camera.GetZoom(), (GLfloat)WINDOW_W / (GLfloat)WINDOW_H, 0.1f, 100.0f);
-        // Get the uniform locations
-        GLint modelLoc = glGetUniformLocation(data->shaderProgram.GetProgram(), "model");
-        GLint viewLoc = glGetUniformLocation(data->shaderProgram.GetProgram(), "view");
-        GLint projLoc = glGetUniformLocation(data->shaderProgram.GetProgram(), "projection");
-        // Pass the matrices to the shader
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        // Draw the container (using container's vertex attributes)
-        glBindVertexArray(data->VAO);
-        glm::mat4 model;
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-
-        // Also draw the lamp object, again binding the appropriate shader
-        data->lightShaderProgram.Use();
-        // Get location objects for the matrices on the lamp shader (these could be different on a different shader)
-        modelLoc = glGetUniformLocation(data->lightShaderProgram.GetProgram(), "model");
-        viewLoc = glGetUniformLocation(data->lightShaderProgram.GetProgram(), "view");
-        projLoc = glGetUniformLocation(data->lightShaderProgram.GetProgram(), "projection");
-        // Set matrices
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        model = glm::mat4();
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        // Draw the light object (using light's vertex attributes)
-        glBindVertexArray(data->lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
+        if (data->renderer == Renderer::Deferred)
+            DrawSceneDeferred(data, view, projection);
+        else
+            DrawSceneForward(data, view, projection);
+        if (data->particleCount > 0)
+            data->particles.Draw(view, projection);
+        if (data->hdr)
+            data->postProcess.Execute();
 
         glFlush();
         SDL_GL_SwapWindow(window);
         CheckSDLError();
     }
+
+    data->textureManager.Update();
+}
+
+void PrintTimings(TutorialData_t* data)
+{
+    if (data->renderer == Renderer::Deferred)
+    {
+        cout << "Deferred: geometry " << data->deferredRenderer.GetGeometryMilliseconds() << " ms, lighting "
+            << data->deferredRenderer.GetLightingMilliseconds() << " ms, " << data->lights.size() << " lights" << endl;
+    }
+    else
+    {
+        cout << "Forward: scene " << data->forwardTimer.GetMilliseconds() << " ms, light binning "
+            << data->lightClusters.GetBuildMilliseconds() << " ms, " << data->lights.size() << " lights" << endl;
+    }
+    cout << "Queues: " << data->renderQueue.GetOpaqueCount() << " opaque, " << data->renderQueue.GetTransparentCount()
+        << " transparent, depth pre-pass " << (data->renderQueue.IsDepthPrepassEnabled() ? "on" : "off");
+    // The overdraw query is not issued while the occlusion queries run
+    if (data->renderQueue.GetOcclusionCuller())
+        cout << ", overdraw not measured" << endl;
+    else
+        cout << ", overdraw " << data->renderQueue.GetOverdraw() << "x" << endl;
+    cout << "Frame arena: " << data->frameArena.GetLastFrameBytes() / 1024 << " KB last frame, peak " << data->frameArena.GetPeakFrameBytes() / 1024
+        << " KB, " << data->frameArena.GetReservedBytes() / 1024 << " KB reserved, " << data->frameArena.GetLastFrameMallocCount()
+        << " block allocations last frame" << endl;
+    if (data->renderQueue.GetOcclusionCuller())
+    {
+        const OcclusionCuller& culler = data->occlusionCuller;
+        cout << "Occlusion: " << culler.GetVisibleCount() << " visible, " << culler.GetConditionalCount() << " conditional, "
+            << culler.GetCulledCount() << " culled" << endl;
+    }
+    if (data->lodFieldSize > 0)
+    {
+        cout << "LOD: " << data->lodTriangles << " sphere triangles selected, "
+            << data->sphereLevels.size() * data->sphereLOD.GetTriangleCount(0) << " at full detail" << endl;
+    }
+    if (data->softwareOcclusion)
+    {
+        cout << "CPU occlusion: " << data->softwareOcclusionCuller.GetTriangleCount() << " occluder triangles, raster "
+            << data->softwareOcclusionCuller.GetRasterMilliseconds() << " ms, " << data->softwareCulled << " culled" << endl;
+    }
+    if (data->hdr)
+    {
+        const PostProcessChain& post = data->postProcess;
+        cout << "Post:";
+        for (size_t i = 0; i < post.GetPassCount(); ++i)
+            cout << (i > 0 ? ", " : " ") << post.GetPassName(i) << " " << post.GetPassMilliseconds(i) << " ms";
+        RenderTargetPool& pool = data->postProcess.GetPool();
+        cout << ", " << pool.GetTargetCount() << " pooled targets " << pool.GetAllocatedBytes() / 1024 << " KB (peak "
+            << pool.GetPeakBytes() / 1024 << " KB), " << pool.GetCreatedCount() << " created" << endl;
+    }
+    if (data->shadows.GetCascadeCount() > 0)
+    {
+        const ShadowMaps& shadows = data->shadows;
+        cout << "Shadows: " << shadows.GetCascadeCount() << " cascades of " << shadows.GetResolution() << "x" << shadows.GetResolution()
+            << ", cull " << shadows.GetCullMilliseconds() << " ms, " << data->shadowCasters.size() << " casters" << endl;
+        for (int i = 0; i < shadows.GetCascadeCount(); ++i)
+        {
+            cout << "  cascade " << i << " to " << shadows.GetSplitDepth(i) << ": " << shadows.GetCasterCount(i) << " casters, "
+                << shadows.GetCascadeMilliseconds(i) << " ms" << endl;
+        }
+    }
+    cout << "Input: " << data->input.GetLastEventCount() << " events last frame, latency " << data->input.GetLastLatencyMilliseconds()
+        << " ms, average " << data->input.GetAverageLatencyMilliseconds() << " ms, max " << data->input.GetMaxLatencyMilliseconds()
+        << " ms over the last " << Input::LATENCY_FRAMES << " frames with input" << endl;
+    cout << "Scene: " << data->scene.GetEntityCount() << " entities, " << data->scene.GetUpdatedCount() << " transforms updated in "
+        << data->scene.GetTransformMilliseconds() << " ms, cull " << data->scene.GetCullMilliseconds() << " ms, " << data->visibleEntities.size() << " visible" << endl;
+    if (data->particleCount > 0)
+    {
+        const ParticleSystem& particles = data->particles;
+        cout << "Particles: " << particles.GetCount() << " live, emit " << particles.GetEmitMilliseconds() << " ms, simulate "
+            << particles.GetSimulateMilliseconds() << " ms, compact " << particles.GetCompactMilliseconds() << " ms, upload "
+            << particles.GetUploadMilliseconds() << " ms, draw " << particles.GetDrawMilliseconds() << " ms" << endl;
+    }
 }
 
 void DestroyWindow(TutorialData_t* data)
 {
 	glDeleteVertexArrays(1, &data->VAO);
 	glDeleteBuffers(1, &data->VBO);
+    data->textureManager.Shutdown();
     SDL_GL_DeleteContext(data->maincontext);
     for (auto w: data->mainwindow)
         SDL_DestroyWindow(w);
@@ -322,39 +797,55 @@ void DestroyWindow(TutorialData_t* data)
 
 void DoMovement(TutorialData_t* data)
 {
-    static auto last_tick = SDL_GetTicks();
-    auto current_tick = SDL_GetTicks();
-    GLfloat deltaTime = GLfloat(current_tick - last_tick) / 1000.0f;
-    
-    if (KEY_PRESSED_STATUS[SDLK_w])
+    // The camera advances in fixed steps of real time and is rendered between the last two, so its motion does not
+    // depend on the frame rate
+    static Uint64 last_counter = SDL_GetPerformanceCounter();
+    static double accumulator = 0.0;
+    Uint64 current_counter = SDL_GetPerformanceCounter();
+    // Clamped so a stall does not run a long catch up
+    accumulator += std::min(double(current_counter - last_counter) / double(SDL_GetPerformanceFrequency()), 0.25);
+    last_counter = current_counter;
+
+    while (accumulator >= CAMERA_STEP)
     {
-        data->camera.ProcessKeyboard(Camera_Movement::FORWARD, deltaTime);
-    }
-    if (KEY_PRESSED_STATUS[SDLK_s])
-    {
-        data->camera.ProcessKeyboard(Camera_Movement::BACKWARD, deltaTime);
-    }
-    if (KEY_PRESSED_STATUS[SDLK_a])
-    {
-        data->camera.ProcessKeyboard(Camera_Movement::LEFT, deltaTime);
-    }
-    if (KEY_PRESSED_STATUS[SDLK_d])
-    {
-        data->camera.ProcessKeyboard(Camera_Movement::RIGHT, deltaTime);
+        if (data->input.IsActionDown(ACTION_MOVE_FORWARD))
+        {
+            data->camera.ProcessKeyboard(Camera_Movement::FORWARD, CAMERA_STEP);
+        }
+        if (data->input.IsActionDown(ACTION_MOVE_BACKWARD))
+        {
+            data->camera.ProcessKeyboard(Camera_Movement::BACKWARD, CAMERA_STEP);
+        }
+        if (data->input.IsActionDown(ACTION_MOVE_LEFT))
+        {
+            data->camera.ProcessKeyboard(Camera_Movement::LEFT, CAMERA_STEP);
+        }
+        if (data->input.IsActionDown(ACTION_MOVE_RIGHT))
+        {
+            data->camera.ProcessKeyboard(Camera_Movement::RIGHT, CAMERA_STEP);
+        }
+        data->camera.Step(CAMERA_STEP);
+        accumulator -= CAMERA_STEP;
     }
-    last_tick = current_tick;
+    data->camera.SetInterpolation(GLfloat(accumulator / CAMERA_STEP));
 }
 
-void HandleKeyboard(const SDL_Event& event, TutorialData_t* )
-{    
-    if (event.type == SDL_KEYDOWN)
-    {
-        KEY_PRESSED_STATUS[event.key.keysym.sym] = true;
-    }
-    else if (event.type == SDL_KEYUP)
+void HandleActions(TutorialData_t* data)
+{
+    const Input& input = data->input;
+    if (input.WasActionPressed(ACTION_TEXTURE_STATS))
+        data->textureManager.PrintStats(cout);
+    if (input.WasActionPressed(ACTION_TIMINGS))
+        PrintTimings(data);
+    if (input.WasActionPressed(ACTION_TOGGLE_PREPASS))
+        data->renderQueue.SetDepthPrepass(!data->renderQueue.IsDepthPrepassEnabled());
+    if (input.WasActionPressed(ACTION_TOGGLE_OCCLUSION))
     {
-        KEY_PRESSED_STATUS[event.key.keysym.sym] = false;
+        data->occlusionCulling = !data->occlusionCulling;
+        data->renderQueue.SetOcclusionCuller(data->occlusionCulling ? &data->occlusionCuller : nullptr);
     }
+    if (input.WasActionPressed(ACTION_TOGGLE_CPU_OCCLUSION))
+        data->softwareOcclusion = !data->softwareOcclusion;
 }
 
 void HandleMouse(const SDL_Event& event, TutorialData_t* data)
@@ -366,26 +857,6 @@ void HandleMouse(const SDL_Event& event, TutorialData_t* data)
     else if (event.type == SDL_MOUSEBUTTONUP)
     {
 
-    }
-    else if (event.type == SDL_MOUSEMOTION)
-    {        
-        static GLfloat lastX, lastY;
-        static bool firstMouse = true;
-
-        GLfloat xpos = (GLfloat)event.motion.x;
-        GLfloat ypos = (GLfloat)event.motion.y;
-        if (firstMouse)
-        {
-            lastX = xpos;
-            lastY = ypos;
-            firstMouse = false;
-        }
-
-        GLfloat xoffset = xpos - lastX;
-        GLfloat yoffset = lastY - ypos;
-        lastX = xpos;
-        lastY = ypos;
-        data->camera.ProcessMouseMovement(xoffset, yoffset);
     }
     else if (event.type == SDL_MOUSEWHEEL)
     {
@@ -396,55 +867,41 @@ void HandleMouse(const SDL_Event& event, TutorialData_t* data)
 
 bool Idle(TutorialData_t* data)
 {
-    SDL_Event event;
-    const int MAX_EVENTS = 100;
-    SDL_Event events_array[MAX_EVENTS + 1];
-
-    bool has_changes = true;
+    Input& input = data->input;
 
     while (true)
     {
-        DoMovement(data);
-        if (has_changes)
+        // Input is sampled as late as possible, right before the camera steps and the frame is built. The swap of the
+        // previous frame paces the loop, waiting for events on top of it would only add latency.
+        input.BeginFrame();
+        SDL_Event ev;
+        while (input.PollEvent(ev))
         {
-            DrawScene(data);
-        }
-
-        //has_changes = false;
-
-        if (!SDL_WaitEventTimeout(&event, 10))
-            continue;
-
-        int count = 0;
-        events_array[0] = event;
-        count = SDL_PeepEvents(events_array + 1, MAX_EVENTS, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
-
-        for (int i = 0; i < count + 1; ++i)
-        {
-            auto& ev = events_array[i];
             switch (ev.type)
             {
             case SDL_QUIT:
                 return false;
-                //TODO: process keys and mouse in separate methods
-            case SDL_KEYDOWN:
-            case SDL_KEYUP:
-                {
-                    if (ev.key.keysym.sym == SDLK_ESCAPE)
-                        return false;
-                }
-                HandleKeyboard(ev, data);
-                break;
             case SDL_MOUSEBUTTONDOWN:
             case SDL_MOUSEBUTTONUP:
-            case SDL_MOUSEMOTION:
             case SDL_MOUSEWHEEL:
                 HandleMouse(ev, data);
                 break;
             default:
                 break;
             }
-        }        
+        }
+
+        if (input.WasActionPressed(ACTION_QUIT))
+            return false;
+        HandleActions(data);
+
+        // All the motion since the last frame in one update
+        const glm::vec2 mouseDelta = input.TakeMouseDelta();
+        data->camera.ProcessMouseMovement(mouseDelta.x, mouseDelta.y);
+
+        DoMovement(data);
+        DrawScene(data);
+        input.EndFrame();
     }
 
     return true;
@@ -454,7 +911,42 @@ void main_function(int argc, char* argv[])
 {
     TutorialData_t data;
 
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--prepass")
+            data.renderQueue.SetDepthPrepass(true);
+        else if (std::string(argv[i]) == "--occlusion")
+            data.occlusionCulling = true;
+        else if (std::string(argv[i]) == "--cpu-occlusion")
+            data.softwareOcclusion = true;
+        else if (std::string(argv[i]) == "--compress")
+            data.compressVertices = true;
+        else if (std::string(argv[i]) == "--ldr")
+            data.hdr = false;
+        else if (i + 1 == argc)
+            break;
+        else if (std::string(argv[i]) == "--model")
+            data.modelFile = argv[++i];
+        else if (std::string(argv[i]) == "--lod")
+            data.lodFieldSize = atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--lights")
+            data.lightCount = atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--particles")
+            data.particleCount = size_t(std::max(0, atoi(argv[++i])));
+        else if (std::string(argv[i]) == "--cascades")
+            data.shadowCascades = std::min(std::max(0, atoi(argv[++i])), int(ShadowMaps::MAX_CASCADES));
+        else if (std::string(argv[i]) == "--shadow-size")
+            data.shadowResolution = std::max(16, atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--bloom-levels")
+            data.bloomLevels = std::min(std::max(0, atoi(argv[++i])), int(Bloom::MAX_LEVELS));
+        else if (std::string(argv[i]) == "--exposure")
+            data.exposure = float(atof(argv[++i]));
+        else if (std::string(argv[i]) == "--renderer")
+            data.renderer = std::string(argv[++i]) == "deferred" ? Renderer::Deferred : Renderer::Forward;
+    }
+
     SetupWindow(&data);
+    SetupInput(&data);
     SetupGL(&data);
 
     while (Idle(&data));
@@ -466,19 +958,63 @@ void main_function(int argc, char* argv[])
 
 void test_function(int argc, char* argv[])
 {
+    // Usage: sdl_opengl --bench <name|all>
+    std::string name = argc > 2 ? argv[2] : "all";
+
+    if (name == "jobs" || name == "all")
+        JobSystem::RunBenchmark();
+    if (name == "arena" || name == "all")
+        FrameArena::RunBenchmark();
+    if (name == "texprep" || name == "all")
+        TexturePrep::RunBenchmark();
+    if (name == "lights" || name == "all")
+        LightClusters::RunBenchmark();
+    if (name == "occlusion" || name == "all")
+        SoftwareOcclusion::RunBenchmark();
+    if (name == "lod" || name == "all")
+        MeshLOD::RunBenchmark();
+    if (name == "import" || name == "all")
+        MeshImporter::RunBenchmark();
+    if (name == "compress" || name == "all")
+        VertexCompressor::RunBenchmark();
+    if (name == "particles" || name == "all")
+        ParticleSystem::RunBenchmark();
+    if (name == "scene" || name == "all")
+        Scene::RunBenchmark();
 
     return;
 }
 
+bool self_test_function(int argc, char* argv[])
+{
+    // Usage: sdl_opengl --test <name|all>, exits with 1 when a check fails
+    std::string name = argc > 2 ? argv[2] : "all";
+    bool passed = true;
+
+    if (name == "import" || name == "all")
+        passed = MeshImporter::RunTests() && passed;
+    if (name == "simplify" || name == "all")
+        passed = MeshSimplifier::RunTests() && passed;
+    if (name == "textures" || name == "all")
+        passed = TextureManager::RunTests() && passed;
+
+    return passed;
+}
+
 int main(int argc, char *argv[])
 {
     cout << "START" << endl;
 
-    main_function(argc, argv);
-    //test_function(argc, argv);
+    int result = 0;
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+        test_function(argc, argv);
+    else if (argc > 1 && std::string(argv[1]) == "--test")
+        result = self_test_function(argc, argv) ? 0 : 1;
+    else
+        main_function(argc, argv);
 
     cout << endl << "END" << endl;
     system("pause");
 
-    return 0;
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+in vec2 TexCoord;
+
+out vec4 color;
+
+uniform sampler2D scene;
+uniform sampler2D bloom;
+uniform float intensity;
+
+void main()
+{
+    color = vec4(texture(scene, TexCoord).rgb + texture(bloom, TexCoord).rgb * intensity, 1.0f);
+}
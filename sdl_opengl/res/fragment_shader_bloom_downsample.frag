@@ -0,0 +1,29 @@
+#version 330 core
+in vec2 TexCoord;
+
+out vec4 color;
+
+uniform sampler2D source;
+uniform vec2 texelSize;
+// Only the first level keeps the part of each pixel above the threshold, with a soft knee
+uniform bool prefilter;
+uniform float threshold;
+uniform float knee;
+
+void main()
+{
+    // Four bilinear taps at the corners average a 4x4 block of the source
+    vec4 offset = texelSize.xyxy * vec4(-1.0f, -1.0f, 1.0f, 1.0f);
+    vec3 sum = texture(source, TexCoord + offset.xy).rgb + texture(source, TexCoord + offset.zy).rgb
+        + texture(source, TexCoord + offset.xw).rgb + texture(source, TexCoord + offset.zw).rgb;
+    vec3 result = sum * 0.25f;
+
+    if (prefilter)
+    {
+        float brightness = max(result.r, max(result.g, result.b));
+        float soft = clamp(brightness - threshold + knee, 0.0f, 2.0f * knee);
+        soft = soft * soft / (4.0f * knee + 0.0001f);
+        result *= max(soft, brightness - threshold) / max(brightness, 0.0001f);
+    }
+    color = vec4(result, 1.0f);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+in vec2 TexCoord;
+
+out vec4 color;
+
+uniform sampler2D source;
+uniform vec2 texelSize;
+
+void main()
+{
+    // 3x3 tent filter, blended additively into the next larger level
+    vec4 offset = texelSize.xyxy * vec4(1.0f, 1.0f, -1.0f, 0.0f);
+    vec3 sum = texture(source, TexCoord - offset.xy).rgb;
+    sum += texture(source, TexCoord - offset.wy).rgb * 2.0f;
+    sum += texture(source, TexCoord - offset.zy).rgb;
+    sum += texture(source, TexCoord + offset.zw).rgb * 2.0f;
+    sum += texture(source, TexCoord).rgb * 4.0f;
+    sum += texture(source, TexCoord + offset.xw).rgb * 2.0f;
+    sum += texture(source, TexCoord + offset.zy).rgb;
+    sum += texture(source, TexCoord + offset.wy).rgb * 2.0f;
+    sum += texture(source, TexCoord + offset.xy).rgb;
+    color = vec4(sum / 16.0f, 1.0f);
+}
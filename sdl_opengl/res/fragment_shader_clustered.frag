@@ -0,0 +1,75 @@
+#version 330 core
+in vec3 FragPos;
+in float ViewDepth;
+
+out vec4 color;
+
+uniform vec3 objectColor;
+uniform vec3 ambientColor;
+// Below 1 for geometry in the transparent queue
+uniform float opacity;
+
+// Filled by LightClusters: two texels (position + radius, color) per light,
+// (offset, count) per cluster and the concatenated per cluster light lists
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer lightIndices;
+
+uniform ivec3 gridSize;
+uniform vec2 screenSize;
+uniform float zNear;
+uniform float sliceScale;
+
+// Filled by ShadowMaps: the sun and its cascades, cascadeCount is 0 without shadows
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 cascadeMatrices[4];
+uniform vec4 cascadeSplits;
+uniform int cascadeCount;
+uniform float shadowTexelSize;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+float SunShadow(vec3 fragPos, float viewDepth)
+{
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    if (cascade == cascadeCount)
+        return 1.0f;
+
+    vec4 coord = cascadeMatrices[cascade] * vec4(fragPos, 1.0f);
+    // 3x3 taps of the hardware compared 2x2 filter
+    float lit = 0.0f;
+    for (int y = -1; y <= 1; ++y)
+        for (int x = -1; x <= 1; ++x)
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * shadowTexelSize, float(cascade), coord.z));
+    return lit / 9.0f;
+}
+
+void main()
+{
+    // Flat face normal, the mesh has no normal attribute
+    vec3 normal = normalize(cross(dFdx(FragPos), dFdy(FragPos)));
+
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / screenSize * vec2(gridSize.xy)), ivec2(0), gridSize.xy - 1);
+    int slice = clamp(int(log(max(ViewDepth, zNear) / zNear) * sliceScale), 0, gridSize.z - 1);
+    int cluster = (slice * gridSize.y + tile.y) * gridSize.x + tile.x;
+    uvec2 range = texelFetch(clusterGrid, cluster).xy;
+
+    vec3 lighting = ambientColor;
+    float sun = max(dot(normal, sunDirection), 0.0f);
+    if (sun > 0.0f && cascadeCount > 0)
+        lighting += sunColor * sun * SunShadow(FragPos, ViewDepth);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec3 lightColor = texelFetch(lightData, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float dist = length(toLight);
+        float falloff = clamp(1.0f - dist / positionRadius.w, 0.0f, 1.0f);
+        lighting += lightColor * max(dot(normal, toLight / max(dist, 0.0001f)), 0.0f) * falloff * falloff;
+    }
+    color = vec4(lighting * objectColor, opacity);
+}
@@ -0,0 +1,63 @@
+#version 330 core
+in vec2 TexCoord;
+
+out vec4 color;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform vec3 ambientColor;
+uniform mat4 inverseViewProjection;
+uniform mat4 view;
+
+// Filled by ShadowMaps: the sun and its cascades, cascadeCount is 0 without shadows
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 cascadeMatrices[4];
+uniform vec4 cascadeSplits;
+uniform int cascadeCount;
+uniform float shadowTexelSize;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+float SunShadow(vec3 fragPos, float viewDepth)
+{
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    if (cascade == cascadeCount)
+        return 1.0f;
+
+    vec4 coord = cascadeMatrices[cascade] * vec4(fragPos, 1.0f);
+    // 3x3 taps of the hardware compared 2x2 filter
+    float lit = 0.0f;
+    for (int y = -1; y <= 1; ++y)
+        for (int x = -1; x <= 1; ++x)
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * shadowTexelSize, float(cascade), coord.z));
+    return lit / 9.0f;
+}
+
+void main()
+{
+    float depth = texture(gDepth, TexCoord).r;
+    if (depth == 1.0f)
+        discard;
+    gl_FragDepth = depth;
+    vec4 albedo = texture(gAlbedo, TexCoord);
+    if (albedo.a > 0.5f)
+    {
+        color = vec4(albedo.rgb, 1.0f);
+        return;
+    }
+
+    vec3 lighting = ambientColor;
+    vec3 normal = texture(gNormal, TexCoord).xyz;
+    float sun = max(dot(normal, sunDirection), 0.0f);
+    if (sun > 0.0f && cascadeCount > 0)
+    {
+        vec4 world = inverseViewProjection * vec4(vec3(TexCoord, depth) * 2.0f - 1.0f, 1.0f);
+        vec3 fragPos = world.xyz / world.w;
+        float viewDepth = -(view * vec4(fragPos, 1.0f)).z;
+        lighting += sunColor * sun * SunShadow(fragPos, viewDepth);
+    }
+    color = vec4(albedo.rgb * lighting, 1.0f);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+flat in vec4 LightPositionRadius;
+flat in vec3 LightColor;
+
+out vec4 color;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    float depth = texture(gDepth, uv).r;
+    vec4 albedo = texture(gAlbedo, uv);
+    if (depth == 1.0f || albedo.a > 0.5f)
+        discard;
+
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0f - 1.0f, 1.0f);
+    vec3 fragPos = world.xyz / world.w;
+    vec3 normal = texture(gNormal, uv).xyz;
+
+    vec3 toLight = LightPositionRadius.xyz - fragPos;
+    float dist = length(toLight);
+    float falloff = clamp(1.0f - dist / LightPositionRadius.w, 0.0f, 1.0f);
+    vec3 lighting = LightColor * max(dot(normal, toLight / max(dist, 0.0001f)), 0.0f) * falloff * falloff;
+    color = vec4(albedo.rgb * lighting, 1.0f);
+}
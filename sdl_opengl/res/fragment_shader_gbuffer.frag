@@ -0,0 +1,17 @@
+#version 330 core
+in vec3 FragPos;
+in float ViewDepth;
+
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+
+uniform vec3 objectColor;
+// 1 for unlit geometry such as the lamp, the lighting passes output its color as is
+uniform float emissive;
+
+void main()
+{
+    vec3 normal = normalize(cross(dFdx(FragPos), dFdy(FragPos)));
+    gAlbedo = vec4(objectColor, emissive);
+    gNormal = vec4(normal, 0.0f);
+}
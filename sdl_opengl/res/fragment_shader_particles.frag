@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 quadCoord;
+in float life;
+
+out vec4 color;
+
+void main()
+{
+    // Round soft sprite, fading out and cooling down over the lifetime
+    float falloff = 1.0f - dot(quadCoord, quadCoord);
+    if (falloff <= 0.0f)
+        discard;
+    vec3 tint = mix(vec3(0.2f, 0.4f, 1.0f), vec3(1.0f, 0.8f, 0.4f), life);
+    color = vec4(tint, falloff * life * 0.5f);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+in vec2 TexCoord;
+
+out vec4 color;
+
+uniform sampler2D hdr;
+uniform float exposure;
+
+void main()
+{
+    // Exponential exposure curve into [0, 1), then gamma for the 8 bit default framebuffer
+    vec3 mapped = vec3(1.0f) - exp(-texture(hdr, TexCoord).rgb * exposure);
+    color = vec4(pow(mapped, vec3(1.0f / 2.2f)), 1.0f);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+out vec3 FragPos;
+out float ViewDepth;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vec4 worldPos = model * vec4(position, 1.0f);
+    vec4 viewPos = view * worldPos;
+    FragPos = worldPos.xyz;
+    ViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
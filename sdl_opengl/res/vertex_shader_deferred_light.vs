@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 lightPositionRadius;
+layout (location = 2) in vec3 lightColor;
+
+flat out vec4 LightPositionRadius;
+flat out vec3 LightColor;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    LightPositionRadius = lightPositionRadius;
+    LightColor = lightColor;
+    // Unit cube scaled to enclose the light sphere
+    gl_Position = viewProjection * vec4(lightPositionRadius.xyz + position * 2.0f * lightPositionRadius.w, 1.0f);
+}
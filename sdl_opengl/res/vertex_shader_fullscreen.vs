@@ -0,0 +1,10 @@
+#version 330 core
+out vec2 TexCoord;
+
+void main()
+{
+    // One triangle covering the screen, generated from gl_VertexID without a vertex buffer
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = position;
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
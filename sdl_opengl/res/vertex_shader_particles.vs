@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec2 corner;
+layout (location = 1) in vec4 particle;
+
+out vec2 quadCoord;
+out float life;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float size;
+
+void main()
+{
+    // Expanded in view space so the quad always faces the camera
+    vec4 center = view * vec4(particle.xyz, 1.0f);
+    gl_Position = projection * vec4(center.xy + corner * size, center.zw);
+    quadCoord = corner;
+    life = particle.w;
+}